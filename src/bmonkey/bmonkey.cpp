@@ -24,10 +24,14 @@
 #include <cstdlib>
 #include <cstring>
 #include <cassert>
+#include <unordered_set>
+#include <thread>
+#include <chrono>
 #include <glibmm/miscutils.h>
 #include <glibmm/fileutils.h>
 #include "../utils/utils.hpp"
 #include "../core/datreader/dat_reader_factory.hpp"
+#include "../core/collection/rom_verifier.hpp"
 #include "../core/bmke/volume_manager.hpp"
 #include "../core/bmke/sound_manager.hpp"
 
@@ -129,6 +133,12 @@ int BMonkeyApp::run(int argc, char** argv)
 		clean();
 		return EXIT_FAILURE;
 	}
+	tmp_dir = Glib::build_filename(m_working_dir, USER_LIBRARY_DIR, USER_THUMBNAILS_DIR);
+	if (!utils::checkOrCreateDir(tmp_dir))
+	{
+		clean();
+		return EXIT_FAILURE;
+	}
 
 	// Comprobamos el directorio de themes del usuario (themes)
 	LOG_INFO("BMonkey: Checking user themes directory...");
@@ -292,6 +302,41 @@ int BMonkeyApp::parseParams(int argc, char** argv)
 			}
 			return 0;
 		}
+		// -pm actualiza una plataforma existente desde un fichero dat
+		else if ((strcmp(argv[i], "-pm") == 0) || (strcmp(argv[i], "--platform-merge") == 0))
+		{
+			m_command = COMMAND_PLATFORM_MERGE;
+			// Necesitamos dos parámetros más, la plataforma y el fichero dat
+			if (i < argc - 2)
+			{
+				m_param1 = argv[i + 1];
+				m_param2 = argv[i + 2];
+			}
+			else
+			{
+				std::cout << "BMonkey: --platform-merge wrong params:" << std::endl
+						<< "Usage: " << argv[0] << " --platform-merge platform_name File" << std::endl;
+				return 1;
+			}
+			return 0;
+		}
+		// -pv verifica las roms de una plataforma
+		else if ((strcmp(argv[i], "-pv") == 0) || (strcmp(argv[i], "--platform-verify") == 0))
+		{
+			m_command = COMMAND_PLATFORM_VERIFY;
+			// Necesitamos un parámetros más con el nombre de la plataforma
+			if (i < argc - 1)
+			{
+				m_param1 = argv[i + 1];
+			}
+			else
+			{
+				std::cout << "BMonkey: --platform-verify wrong params:" << std::endl
+						<< "Usage: " << argv[0] << " --platform-verify platform_name" << std::endl;
+				return 1;
+			}
+			return 0;
+		}
 		// -ga añade una gamelist a una plataforma dada
 		else if ((strcmp(argv[i], "-ga") == 0) || (strcmp(argv[i], "--gamelist-add") == 0))
 		{
@@ -357,6 +402,12 @@ int BMonkeyApp::execCommand(void)
 	case COMMAND_PLATFORM_IMPORT:
 		ret = platformImport(m_param1, m_param2);
 		break;
+	case COMMAND_PLATFORM_MERGE:
+		ret = platformMerge(m_param1, m_param2);
+		break;
+	case COMMAND_PLATFORM_VERIFY:
+		ret = platformVerify(m_param1);
+		break;
 	case COMMAND_GAMELIST_ADD:
 		ret = gamelistAdd(m_param1, m_param2);
 		break;
@@ -380,7 +431,9 @@ void BMonkeyApp::showHelp(const Glib::ustring& program) const
 			  << "  -ld, --log-disable       Disable logging" << std::endl
 			  << "  -le, --log-enable        Enable logging" << std::endl
 			  << "  -pa, --platform-add      Add a new empty platform to the user collection" << std::endl
-			  << "  -pi, --platform-import   Imports a platform from a dat file" << std::endl
+			  << "  -pi, --platform-import   Imports a platform from a dat file (plain, .gz or .zip)" << std::endl
+			  << "  -pm, --platform-merge    Updates an existing platform from a newer dat file" << std::endl
+			  << "  -pv, --platform-verify   Verifies the roms of a platform" << std::endl
 			  << "  -ga, --gamelist-add      Add a new empty gamelist to a platform" << std::endl;
 }
 
@@ -457,6 +510,7 @@ int BMonkeyApp::platformImport(const Glib::ustring& name, const Glib::ustring& f
 	Platform* platform = nullptr;
 	Gamelist* list = nullptr;
 	Game* game = nullptr;
+	std::vector<Game*> games;
 	int total = 0;
 
 	// Obtenemos un lector de dat para el fichero
@@ -493,6 +547,7 @@ int BMonkeyApp::platformImport(const Glib::ustring& name, const Glib::ustring& f
 	// Obtenemos lista master y agremgamos los juegos
 	list = platform->gamelistGet();
 	// Procesamos todos los sets del dat
+	games.reserve(sets.size());
 	for (iter = sets.begin(); iter != sets.end(); ++iter)
 	{
 		if (!iter->is_bios)
@@ -500,17 +555,12 @@ int BMonkeyApp::platformImport(const Glib::ustring& name, const Glib::ustring& f
 			std::cout << "Adding set: " << iter->name << " / \"" << iter->description << "\"" << std::endl;
 			game = new Game(platform->getDir());
 			game->name = iter->name;
-			game->title = iter->description;
-			game->cloneof = iter->clone_of;
-			game->crc = iter->crc;
-			game->manufacturer = iter->manufacturer;
-			game->year = iter->year;
-			game->genre = iter->genre;
-			game->players = iter->players;
-			list->gameAdd(game);
-			++total;
+			gameUpdate(game, *iter);
+			games.push_back(game);
 		}
 	}
+	// Agregamos todos los juegos a la lista de una sola vez
+	total = list->gameAdd(games);
 	std::cout << "-------------------------------------" <<  std::endl;
 	std::cout << "New sets: " << total << std::endl;
 
@@ -526,6 +576,229 @@ int BMonkeyApp::platformImport(const Glib::ustring& name, const Glib::ustring& f
 	return 0;
 }
 
+int BMonkeyApp::platformMerge(const Glib::ustring& name, const Glib::ustring& file)
+{
+	DatReader* dat = nullptr;
+	std::vector<DatSet> sets;
+	std::vector<DatSet>::iterator iter;
+	std::unordered_set<std::string> names;
+	std::vector<const DatSet*> added;
+	std::vector<const DatSet*>::iterator added_iter;
+	std::vector<Game*> games;
+	std::vector<Glib::ustring> removed;
+	std::vector<Glib::ustring>::iterator removed_iter;
+	Platform* platform = nullptr;
+	Gamelist* list = nullptr;
+	Game* game = nullptr;
+	Item* item = nullptr;
+	Glib::ustring set_name;
+	int changed = 0;
+	int unchanged = 0;
+	int count;
+
+	// Obtenemos un lector de dat para el fichero
+	dat = DatReaderFactory::getDatReader(file);
+	if (!dat)
+	{
+		std::cout << "Dat reader not found for file \"" << file << "\"" <<  std::endl;
+		return -1;
+	}
+	std::cout << "Dat type: " << dat->getType() <<  std::endl;
+	if (!dat->read(sets))
+	{
+		std::cout << "Error reading sets" <<  std::endl;
+		delete dat;
+		return -1;
+	}
+	// Los sets ya están copiados, liberamos el dat cuanto antes
+	delete dat;
+	std::cout << "Total dat sets: " << sets.size() <<  std::endl;
+	std::cout << "-------------------------------------" <<  std::endl;
+
+	m_collection = new Collection(m_working_dir);
+	m_collection->loadConfig();
+	platform = m_collection->platformGet(name);
+	if (!platform)
+	{
+		LOG_DEBUG("BMonkey: Platform \"" << name << "\" does not exist");
+		std::cout << "Platform \"" << name << "\" does not exist" << std::endl;
+		delete m_collection;
+		return -1;
+	}
+	platform->loadConfig();
+	platform->loadGames();
+	platform->loadGamelists();
+	list = platform->gamelistGet();
+
+	// Calculamos las diferencias entre el dat y la lista master. Los juegos
+	// existentes se actualizan directamente ya que conservan su nodo
+	names.reserve(sets.size());
+	for (iter = sets.begin(); iter != sets.end(); ++iter)
+	{
+		if (iter->is_bios)
+		{
+			continue;
+		}
+		set_name = iter->name.lowercase();
+		// Descartamos los sets repetidos en el dat
+		if (!names.insert(set_name).second)
+		{
+			continue;
+		}
+		game = list->gameGet(set_name);
+		if (!game)
+		{
+			added.push_back(&(*iter));
+		}
+		else if (gameUpdate(game, *iter))
+		{
+			std::cout << "Updating set: " << game->name << " / \"" << game->title << "\"" << std::endl;
+			++changed;
+		}
+		else
+		{
+			++unchanged;
+		}
+	}
+	// Buscamos los juegos de la plataforma que ya no están en el dat
+	item = list->itemFirst();
+	for (count = list->gameCount(); count > 0; --count)
+	{
+		game = list->gameGet(item);
+		if (names.find(game->name) == names.end())
+		{
+			removed.push_back(game->name);
+		}
+		item = list->itemNext(item);
+	}
+
+	// Aplicamos los cambios en bloque
+	for (removed_iter = removed.begin(); removed_iter != removed.end(); ++removed_iter)
+	{
+		std::cout << "Removing set: " << *removed_iter << std::endl;
+		platform->gameDelete(*removed_iter, list);
+	}
+	games.reserve(added.size());
+	for (added_iter = added.begin(); added_iter != added.end(); ++added_iter)
+	{
+		std::cout << "Adding set: " << (*added_iter)->name << " / \"" << (*added_iter)->description << "\"" << std::endl;
+		game = new Game(platform->getDir());
+		game->name = (*added_iter)->name;
+		gameUpdate(game, **added_iter);
+		games.push_back(game);
+	}
+	list->gameAdd(games);
+	std::cout << "-------------------------------------" <<  std::endl;
+	std::cout << "New sets: " << added.size() << std::endl;
+	std::cout << "Removed sets: " << removed.size() << std::endl;
+	std::cout << "Updated sets: " << changed << std::endl;
+	std::cout << "Unchanged sets: " << unchanged << std::endl;
+
+	// Solamente guardamos si hubo algún cambio
+	if (added.empty() && removed.empty() && (changed == 0))
+	{
+		std::cout << "Platform \"" << name << "\" is up to date" << std::endl;
+	}
+	else
+	{
+		if (!removed.empty())
+		{
+			platform->saveGamelists();
+		}
+		platform->saveGames();
+	}
+	delete m_collection;
+
+	return 0;
+}
+
+int BMonkeyApp::platformVerify(const Glib::ustring& name)
+{
+	Platform* platform = nullptr;
+	RomVerifier verifier;
+
+	m_collection = new Collection(m_working_dir);
+	m_collection->loadConfig();
+	platform = m_collection->platformGet(name);
+	if (!platform)
+	{
+		LOG_DEBUG("BMonkey: Platform \"" << name << "\" does not exist");
+		std::cout << "Platform \"" << name << "\" does not exist" << std::endl;
+		delete m_collection;
+		return -1;
+	}
+	platform->loadConfig();
+	platform->loadGames();
+
+	std::cout << "Verifying roms in \"" << platform->getRomsDir() << "\"..." << std::endl;
+	if (verifier.start(platform))
+	{
+		// La verificación se realiza en segundo plano, vamos recogiendo los
+		// resultados y mostrando el progreso
+		while (verifier.isRunning())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			if (verifier.update())
+			{
+				std::cout << "\rVerified: " << verifier.getVerified() << "/" << verifier.getTotal() << std::flush;
+			}
+		}
+		std::cout << std::endl;
+	}
+	std::cout << "-------------------------------------" <<  std::endl;
+	std::cout << "Correct sets: " << verifier.getCorrect() << std::endl;
+	std::cout << "Incorrect sets: " << verifier.getVerified() - verifier.getCorrect() << std::endl;
+
+	platform->saveGames();
+	delete m_collection;
+
+	return 0;
+}
+
+bool BMonkeyApp::gameUpdate(Game* game, const DatSet& set)
+{
+	bool changed = false;
+
+	assert(game);
+
+	if (game->title != set.description)
+	{
+		game->title = set.description;
+		changed = true;
+	}
+	if (game->cloneof != set.clone_of)
+	{
+		game->cloneof = set.clone_of;
+		changed = true;
+	}
+	if (game->crc != set.crc)
+	{
+		game->crc = set.crc;
+		changed = true;
+	}
+	if (game->manufacturer != set.manufacturer)
+	{
+		game->manufacturer = set.manufacturer;
+		changed = true;
+	}
+	if (game->year != set.year)
+	{
+		game->year = set.year;
+		changed = true;
+	}
+	if (game->genre != set.genre)
+	{
+		game->genre = set.genre;
+		changed = true;
+	}
+	if (game->players != set.players)
+	{
+		game->players = set.players;
+		changed = true;
+	}
+	return changed;
+}
+
 int BMonkeyApp::gamelistAdd(const Glib::ustring& platform, const Glib::ustring& name)
 {
 	int ret = 0;
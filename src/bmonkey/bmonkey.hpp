@@ -26,6 +26,7 @@
 #include "../defines.hpp"
 #include "../utils/config.hpp"
 #include "../core/collection/collection.hpp"
+#include "../core/datreader/dat_set.hpp"
 #include "../core/bmke/director.hpp"
 
 namespace bmonkey{
@@ -48,6 +49,8 @@ public:
 		COMMAND_LOG_ENABLE,			/**< Habilita el log a fichero */
 		COMMAND_PLATFORM_ADD,		/**< Añade una nueva plataforma a la colección */
 		COMMAND_PLATFORM_IMPORT,	/**< Importa una plataforma desde un dat */
+		COMMAND_PLATFORM_MERGE,		/**< Actualiza una plataforma desde un dat */
+		COMMAND_PLATFORM_VERIFY,	/**< Verifica las roms de una plataforma */
 		COMMAND_GAMELIST_ADD		/**< Añade una lista de jeugos nueva a una plataforma */
 	};
 
@@ -143,6 +146,33 @@ private:
 	 */
 	int platformImport(const Glib::ustring& name, const Glib::ustring& file);
 
+	/**
+	 * Actualiza una plataforma existente a partir de un fichero dat
+	 * @param name Nombre de la plataforma a actualizar
+	 * @param file Fichero dat con la nueva versión de los juegos
+	 * @return 0 si se pudo realizar la operación, -1 en otro caso
+	 * @note Solamente se aplican las diferencias entre el dat y la lista master
+	 * de la plataforma, conservando los datos de usuario de los juegos
+	 * (puntuación, veces jugado y favorito)
+	 */
+	int platformMerge(const Glib::ustring& name, const Glib::ustring& file);
+
+	/**
+	 * Verifica las roms de los juegos de una plataforma actualizando su estado
+	 * @param name Nombre de la plataforma a verificar
+	 * @return 0 si se pudo realizar la operación, -1 en otro caso
+	 */
+	int platformVerify(const Glib::ustring& name);
+
+	/**
+	 * Actualiza los datos de un juego con los de un set de un dat
+	 * @param game Juego a actualizar
+	 * @param set Set del dat con los nuevos datos
+	 * @return true si se modificó algún dato del juego, false en otro caso
+	 * @note Los datos de usuario del juego no se modifican
+	 */
+	bool gameUpdate(Game* game, const DatSet& set);
+
 	/**
 	 * Añade una nueva lista de juegos a la plataforma dada
 	 * @param platform Nombre de plataforma donde agregar la lista
@@ -0,0 +1,174 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * Comprobación y medida de los métodos de cálculo del crc32
+ *
+ * Fuerza cada método disponible en el procesador y compara sus resultados con
+ * los del cálculo de referencia byte a byte y con la función crc32 de zlib,
+ * sobre desplazamientos, tamaños y crc de entrada aleatorios, partiendo cada
+ * bloque en dos para comprobar también la continuación. Después mide el
+ * rendimiento de cada método en MB/s.
+ * Termina con EXIT_FAILURE si algún método no coincide.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <zlib.h>
+#include "../utils/crc32.hpp"
+
+// Tamaño del bloque de datos aleatorios
+#define CRC32_CHECK_DATA_SIZE (1024 * 1024)
+// Desplazamiento máximo sobre el comienzo del bloque, para probar alineaciones
+#define CRC32_CHECK_MAX_OFFSET 64
+// Número de comprobaciones por método
+#define CRC32_CHECK_ROUNDS 20000
+// Semilla fija para que los fallos se puedan reproducir
+#define CRC32_CHECK_SEED 20140101
+// Bytes procesados al medir cada método (256MB)
+#define CRC32_CHECK_BENCH_BYTES (256 * 1024 * 1024)
+
+// Nombre de cada método de cálculo, en el orden de Crc32::EngineType
+static const char* const ENGINE_NAMES[Crc32::ENGINE_COUNT] =
+{
+	"table",
+	"slicing-by-8",
+	"pclmulqdq",
+	"armv8-crc32"
+};
+
+/**
+ * Compara un método de cálculo con el de referencia y con zlib
+ * @param type Método de cálculo a comprobar
+ * @param data Bloque de datos aleatorios
+ * @param random Generador de números aleatorios
+ * @return true si todos los resultados coinciden, false en otro caso
+ */
+static bool check(const Crc32::EngineType type, const std::vector<char>& data, std::mt19937& random)
+{
+	std::uniform_int_distribution<unsigned int> offset_dist(0, CRC32_CHECK_MAX_OFFSET - 1);
+	std::uniform_int_distribution<unsigned int> small_dist(0, 512);
+	std::uniform_int_distribution<unsigned int> large_dist(0, CRC32_CHECK_DATA_SIZE - CRC32_CHECK_MAX_OFFSET);
+	unsigned int round, offset, size, split;
+	Crc32::Crc seed, expected, crc;
+	uLong zlib_crc;
+
+	for (round = 0; round < CRC32_CHECK_ROUNDS; ++round)
+	{
+		// La mayoría de bloques son pequeños, para recorrer los casos de los
+		// extremos de cada método
+		offset = offset_dist(random);
+		size = (round % 16 == 0) ? large_dist(random) : small_dist(random);
+		split = std::uniform_int_distribution<unsigned int>(0, size)(random);
+		seed = random();
+
+		expected = Crc32::getCrc32(&data[offset], size, seed, Crc32::ENGINE_TABLE);
+		crc = Crc32::getCrc32(&data[offset], split, seed, type);
+		crc = Crc32::getCrc32(&data[offset + split], size - split, crc, type);
+		// zlib recibe y devuelve el crc finalizado
+		zlib_crc = crc32(Crc32::getCrc32Finalize(seed), reinterpret_cast<const Bytef*>(&data[offset]), size);
+		if ((crc != expected) || (Crc32::getCrc32Finalize(crc) != zlib_crc))
+		{
+			std::cout << ENGINE_NAMES[type] << ": FAILED at offset " << offset << ", size " << size <<
+				", split " << split << ", seed " << Crc32::toString(seed) << ": " <<
+				Crc32::toString(Crc32::getCrc32Finalize(crc)) << " expected " <<
+				Crc32::toString(Crc32::getCrc32Finalize(expected)) << " zlib " <<
+				Crc32::toString(zlib_crc) << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Mide el rendimiento de un método de cálculo
+ * @param type Método de cálculo a medir, o ENGINE_COUNT para medir zlib
+ * @param data Bloque de datos aleatorios
+ * @param crc Devuelve el crc calculado, para que no se descarte el cálculo
+ * @return Velocidad en MB/s
+ */
+static double bench(const Crc32::EngineType type, const std::vector<char>& data, Crc32::Crc& crc)
+{
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double> elapsed;
+	unsigned int done;
+
+	// zlib parte del crc finalizado y el resto del crc sin finalizar
+	crc = (type == Crc32::ENGINE_COUNT) ? 0 : 0xFFFFFFFF;
+	start = std::chrono::steady_clock::now();
+	for (done = 0; done < CRC32_CHECK_BENCH_BYTES; done += data.size())
+	{
+		if (type == Crc32::ENGINE_COUNT)
+		{
+			crc = crc32(crc, reinterpret_cast<const Bytef*>(&data[0]), data.size());
+		}
+		else
+		{
+			crc = Crc32::getCrc32(&data[0], data.size(), crc, type);
+		}
+	}
+	elapsed = std::chrono::steady_clock::now() - start;
+	return (done / (1024.0 * 1024.0)) / elapsed.count();
+}
+
+int main(void)
+{
+	std::vector<char> data(CRC32_CHECK_DATA_SIZE);
+	std::mt19937 random(CRC32_CHECK_SEED);
+	std::vector<char>::iterator iter;
+	Crc32::EngineType type;
+	Crc32::Crc crc;
+	int i;
+	bool passed = true;
+
+	for (iter = data.begin(); iter != data.end(); ++iter)
+	{
+		*iter = static_cast<char>(random());
+	}
+
+	std::cout << "Selected engine: " << Crc32::getEngineName() << std::endl;
+	std::cout << std::fixed << std::setprecision(1);
+	for (i = 0; i < Crc32::ENGINE_COUNT; ++i)
+	{
+		type = static_cast<Crc32::EngineType>(i);
+		if (!Crc32::isEngineSupported(type))
+		{
+			std::cout << ENGINE_NAMES[type] << ": not supported" << std::endl;
+			continue;
+		}
+		if (!check(type, data, random))
+		{
+			passed = false;
+			continue;
+		}
+		std::cout << ENGINE_NAMES[type] << ": ok, " << bench(type, data, crc) << " MB/s (" <<
+			Crc32::toString(Crc32::getCrc32Finalize(crc)) << ")" << std::endl;
+	}
+	// zlib como referencia de rendimiento
+	std::cout << "zlib: " << bench(Crc32::ENGINE_COUNT, data, crc) << " MB/s (" <<
+		Crc32::toString(crc) << ")" << std::endl;
+
+	return (passed ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,186 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "artwork_prefetcher.hpp"
+#include <cassert>
+#include <algorithm>
+
+// Juegos anticipados como mínimo en cada sentido
+#define ARTWORK_PREFETCHER_MIN_DEPTH 2
+// Juegos anticipados como máximo por defecto
+#define ARTWORK_PREFETCHER_MAX_DEPTH 16
+// Tiempo de desplazamiento que se anticipa, en segundos
+#define ARTWORK_PREFETCHER_LOOKAHEAD 0.5f
+// Pausa a partir de la cual se considera que el desplazamiento se ha detenido
+#define ARTWORK_PREFETCHER_IDLE_TIME 1.f
+
+namespace bmonkey{
+
+ArtworkPrefetcher::ArtworkPrefetcher(TextureManager* textures):
+	m_textures(textures),
+	m_max_depth(ARTWORK_PREFETCHER_MAX_DEPTH),
+	m_direction(0),
+	m_speed(0.f)
+{
+	int i;
+
+	assert(m_textures);
+
+	for (i = 0; i < MediaIndex::MEDIA_COUNT; ++i)
+	{
+		m_enabled[i] = false;
+		m_sizes[i] = sf::Vector2u(0, 0);
+	}
+}
+
+ArtworkPrefetcher::~ArtworkPrefetcher(void)
+{
+	clear();
+}
+
+void ArtworkPrefetcher::setMaxDepth(const int depth)
+{
+	m_max_depth = std::max(depth, ARTWORK_PREFETCHER_MIN_DEPTH);
+}
+
+void ArtworkPrefetcher::setSize(const MediaIndex::MediaType type, const sf::Vector2u& size)
+{
+	assert(type < MediaIndex::MEDIA_COUNT);
+
+	m_enabled[type] = true;
+	m_sizes[type] = size;
+}
+
+void ArtworkPrefetcher::disable(const MediaIndex::MediaType type)
+{
+	assert(type < MediaIndex::MEDIA_COUNT);
+
+	m_enabled[type] = false;
+}
+
+void ArtworkPrefetcher::select(Platform* platform, Gamelist* list, Item* item, const int direction)
+{
+	std::unordered_map<std::string, Request> requests;
+	MediaIndex* index;
+	Item* next;
+	float elapsed;
+	int ahead, behind, i;
+
+	assert(platform);
+	assert(list);
+
+	// Estimamos la velocidad del desplazamiento con una media suavizada. Un
+	// salto o un cambio de sentido la reinician
+	elapsed = m_clock.restart().asSeconds();
+	if ((direction == 0) || (direction != m_direction) || (elapsed > ARTWORK_PREFETCHER_IDLE_TIME))
+	{
+		m_speed = 0.f;
+	}
+	else if (elapsed > 0.f)
+	{
+		m_speed = (m_speed * 0.5f) + (0.5f / elapsed);
+	}
+	m_direction = direction;
+
+	ahead = ARTWORK_PREFETCHER_MIN_DEPTH + static_cast<int>(m_speed * ARTWORK_PREFETCHER_LOOKAHEAD);
+	ahead = std::min(ahead, m_max_depth);
+	behind = (direction == 0) ? ARTWORK_PREFETCHER_MIN_DEPTH : 1;
+
+	if (item)
+	{
+		// Solicitamos primero la selección y después los juegos en orden de
+		// cercanía, así se decodifican antes los que se necesitarán antes
+		index = platform->getMediaIndex();
+		request(index, list->gameGet(item), requests);
+		for (i = 0, next = item; i < ahead; ++i)
+		{
+			next = (direction < 0) ? list->itemPrev(next) : list->itemNext(next);
+			if (!next || (next == item))
+			{
+				break;
+			}
+			request(index, list->gameGet(next), requests);
+		}
+		for (i = 0, next = item; i < behind; ++i)
+		{
+			next = (direction < 0) ? list->itemNext(next) : list->itemPrev(next);
+			if (!next || (next == item))
+			{
+				break;
+			}
+			request(index, list->gameGet(next), requests);
+		}
+	}
+
+	// Liberamos las peticiones que ya no están cerca de la selección. Las que
+	// no han terminado se cancelan y el resto quedan en la caché del manager
+	release(m_requests);
+	m_requests.swap(requests);
+}
+
+void ArtworkPrefetcher::clear(void)
+{
+	release(m_requests);
+	m_requests.clear();
+	m_direction = 0;
+	m_speed = 0.f;
+}
+
+void ArtworkPrefetcher::request(MediaIndex* index, Game* game, std::unordered_map<std::string, Request>& requests)
+{
+	static const MediaIndex::MediaType types[] = {MediaIndex::MEDIA_SNAP, MediaIndex::MEDIA_WHEEL};
+	const MediaIndex::Media* media;
+	Request request;
+	unsigned int i;
+
+	if (!game)
+	{
+		return;
+	}
+	for (i = 0; i < sizeof(types) / sizeof(types[0]); ++i)
+	{
+		if (!m_enabled[types[i]])
+		{
+			continue;
+		}
+		media = index->get(types[i], game);
+		// Cada fichero se solicita una única vez aunque lo compartan varios
+		// juegos, como los clones
+		if (media && (requests.find(media->file) == requests.end()))
+		{
+			request.size = m_sizes[types[i]];
+			request.handle = m_textures->loadTextureAsync(media->file, false, request.size);
+			requests[media->file] = request;
+		}
+	}
+}
+
+void ArtworkPrefetcher::release(std::unordered_map<std::string, Request>& requests)
+{
+	std::unordered_map<std::string, Request>::iterator iter;
+
+	for (iter = requests.begin(); iter != requests.end(); ++iter)
+	{
+		m_textures->deleteTexture(iter->first, iter->second.size);
+	}
+}
+
+} // namespace bmonkey
@@ -0,0 +1,141 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _ARTWORK_PREFETCHER_HPP_
+#define _ARTWORK_PREFETCHER_HPP_
+
+#include <SFML/System.hpp>
+#include <glibmm/ustring.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "../collection/platform.hpp"
+#include "texture_manager.hpp"
+
+namespace bmonkey{
+
+/**
+ * Carga anticipada de las imágenes de los juegos cercanos a la selección
+ *
+ * Cada vez que cambia el juego seleccionado solicita al TextureManager la
+ * carga en segundo plano de los snaps y wheels de los siguientes juegos en el
+ * sentido del desplazamiento, de forma que ya estén cargados cuando el usuario
+ * llegue a ellos. El número de juegos anticipados crece con la velocidad del
+ * desplazamiento.
+ * Las peticiones que dejan de estar cerca de la selección, por un cambio de
+ * sentido o un salto, se liberan cancelando su carga si no ha terminado.
+ * Los juegos se recorren en la vista actual de la lista, respetando sus
+ * filtros.
+ * Sólo se anticipan los tipos de fichero para los que se ha indicado el
+ * tamaño con el que se dibujan, de forma que las peticiones coincidan con las
+ * de quien los muestra y no se decodifiquen imágenes que nadie va a usar.
+ */
+class ArtworkPrefetcher
+{
+public:
+	/**
+	 * Constructor parametrizado
+	 * @param textures Manager de texturas donde se realizan las cargas
+	 */
+	ArtworkPrefetcher(TextureManager* textures);
+
+	/**
+	 * Destructor de la clase
+	 */
+	~ArtworkPrefetcher(void);
+
+	/**
+	 * Establece el número máximo de juegos a anticipar en el sentido del
+	 * desplazamiento
+	 * @param depth Número máximo de juegos a anticipar
+	 */
+	void setMaxDepth(const int depth);
+
+	/**
+	 * Habilita la carga anticipada de un tipo de fichero multimedia
+	 * @param type Tipo de fichero a anticipar
+	 * @param size Tamaño con el que se dibujan los ficheros, 0x0 para usar
+	 * su resolución completa
+	 * @note Debe coincidir con el tamaño que solicita quien los muestra al
+	 * TextureManager, ya que las versiones reducidas se guardan por separado
+	 */
+	void setSize(const MediaIndex::MediaType type, const sf::Vector2u& size);
+
+	/**
+	 * Deshabilita la carga anticipada de un tipo de fichero multimedia
+	 * @param type Tipo de fichero a dejar de anticipar
+	 */
+	void disable(const MediaIndex::MediaType type);
+
+	/**
+	 * Informa de un cambio en el juego seleccionado
+	 * @param platform Plataforma de la lista de juegos
+	 * @param list Lista de juegos en la que se encuentra la selección
+	 * @param item Elemento seleccionado de la lista
+	 * @param direction Sentido del desplazamiento: 1 hacia delante, -1 hacia
+	 * atrás o 0 para un salto, como un cambio de letra o de lista
+	 * @note La lista se recorre en las siguientes llamadas, por lo que si se
+	 * recarga o elimina hay que volver a llamar a select o a clear
+	 */
+	void select(Platform* platform, Gamelist* list, Item* item, const int direction);
+
+	/**
+	 * Libera todas las peticiones de carga
+	 */
+	void clear(void);
+
+private:
+	/**
+	 * Petición de carga de un fichero
+	 */
+	struct Request
+	{
+		TextureManager::Handle handle;	/**< Textura solicitada */
+		sf::Vector2u size;				/**< Tamaño solicitado */
+	};
+
+	/**
+	 * Agrega a las peticiones deseadas los ficheros multimedia de un juego
+	 * @param index Índice multimedia de la plataforma
+	 * @param game Juego del que solicitar los ficheros
+	 * @param requests Peticiones deseadas donde agregar los ficheros
+	 */
+	void request(MediaIndex* index, Game* game, std::unordered_map<std::string, Request>& requests);
+
+	/**
+	 * Libera un conjunto de peticiones
+	 * @param requests Peticiones a liberar
+	 */
+	void release(std::unordered_map<std::string, Request>& requests);
+
+	TextureManager* m_textures;			/**< Manager donde se realizan las cargas */
+	std::unordered_map<std::string, Request> m_requests;	/**< Peticiones en curso */
+	bool m_enabled[MediaIndex::MEDIA_COUNT];	/**< Tipos de fichero anticipados */
+	sf::Vector2u m_sizes[MediaIndex::MEDIA_COUNT];	/**< Tamaño de dibujado de cada tipo */
+	int m_max_depth;					/**< Máximo de juegos anticipados */
+	int m_direction;					/**< Último sentido del desplazamiento */
+	float m_speed;						/**< Velocidad del desplazamiento en juegos por segundo */
+	sf::Clock m_clock;					/**< Tiempo desde el último desplazamiento */
+};
+
+} // namespace bmonkey
+
+#endif // _ARTWORK_PREFETCHER_HPP_
@@ -0,0 +1,301 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "compressed_image.hpp"
+#include <SFML/OpenGL.hpp>
+#include <algorithm>
+#include <cstring>
+
+// Constantes de la extensión GL_EXT_texture_compression_s3tc
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+	#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT		0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+	#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT	0x83F3
+#endif
+#ifndef APIENTRY
+	#define APIENTRY
+#endif
+
+// Las funciones de OpenGL se obtienen del contexto de SFML, disponible desde
+// la versión 2.4, de forma que no es necesario enlazar con OpenGL
+#if (SFML_VERSION_MAJOR > 2) || ((SFML_VERSION_MAJOR == 2) && (SFML_VERSION_MINOR >= 4))
+	#define COMPRESSED_IMAGE_GL_FUNCTIONS
+#endif
+
+namespace bmonkey{
+
+#ifdef COMPRESSED_IMAGE_GL_FUNCTIONS
+typedef const GLubyte* (APIENTRY *GlGetString)(GLenum name);
+typedef GLenum (APIENTRY *GlGetError)(void);
+typedef void (APIENTRY *GlCompressedTexImage2D)(GLenum target, GLint level, GLenum format,
+	GLsizei width, GLsizei height, GLint border, GLsizei size, const GLvoid* data);
+#endif
+
+CompressedImage::CompressedImage(void):
+	m_size(0, 0),
+	m_format(FORMAT_DXT1)
+{
+}
+
+bool CompressedImage::compress(const sf::Image& image)
+{
+	const sf::Uint8* pixels;
+	sf::Uint8 block[64];
+	sf::Uint8* dest;
+	std::size_t i;
+	unsigned int bx, by, x, y, px, py;
+
+	m_size = image.getSize();
+	if ((m_size.x == 0) || (m_size.y == 0))
+	{
+		m_data.clear();
+		return false;
+	}
+	pixels = image.getPixelsPtr();
+
+	// Las imágenes con algún pixel transparente necesitan el canal alfa
+	m_format = FORMAT_DXT1;
+	for (i = 3; i < static_cast<std::size_t>(m_size.x) * m_size.y * 4; i += 4)
+	{
+		if (pixels[i] != 255)
+		{
+			m_format = FORMAT_DXT5;
+			break;
+		}
+	}
+
+	m_data.resize(getDataSize(m_format, m_size));
+	dest = &m_data[0];
+	for (by = 0; by < m_size.y; by += 4)
+	{
+		for (bx = 0; bx < m_size.x; bx += 4)
+		{
+			// Los bloques incompletos del borde repiten el último pixel
+			for (y = 0; y < 4; ++y)
+			{
+				py = std::min(by + y, m_size.y - 1);
+				for (x = 0; x < 4; ++x)
+				{
+					px = std::min(bx + x, m_size.x - 1);
+					std::memcpy(&block[(y * 4 + x) * 4], &pixels[(static_cast<std::size_t>(py) * m_size.x + px) * 4], 4);
+				}
+			}
+			if (m_format == FORMAT_DXT5)
+			{
+				compressAlpha(block, dest);
+				dest += 8;
+			}
+			compressColor(block, dest);
+			dest += 8;
+		}
+	}
+	return true;
+}
+
+bool CompressedImage::create(const sf::Vector2u& size, const Format format, const sf::Uint8* data)
+{
+	if ((size.x == 0) || (size.y == 0) || !data)
+	{
+		return false;
+	}
+	m_size = size;
+	m_format = format;
+	m_data.assign(data, data + getDataSize(format, size));
+	return true;
+}
+
+bool CompressedImage::upload(sf::Texture& texture) const
+{
+#ifdef COMPRESSED_IMAGE_GL_FUNCTIONS
+	GlCompressedTexImage2D compressed_tex_image;
+	GlGetError get_error;
+
+	if (m_data.empty() || !isSupported())
+	{
+		return false;
+	}
+	compressed_tex_image = reinterpret_cast<GlCompressedTexImage2D>(sf::Context::getFunction("glCompressedTexImage2D"));
+	get_error = reinterpret_cast<GlGetError>(sf::Context::getFunction("glGetError"));
+	if (!compressed_tex_image || !get_error || !texture.create(m_size.x, m_size.y))
+	{
+		return false;
+	}
+	// Reemplazamos el contenido de la textura creada por SFML, que mantiene
+	// su tamaño y parámetros
+	while (get_error() != GL_NO_ERROR);
+	sf::Texture::bind(&texture);
+	compressed_tex_image(GL_TEXTURE_2D, 0,
+		(m_format == FORMAT_DXT1) ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+		m_size.x, m_size.y, 0, m_data.size(), &m_data[0]);
+	sf::Texture::bind(nullptr);
+	return (get_error() == GL_NO_ERROR);
+#else
+	(void) texture;
+	return false;
+#endif
+}
+
+bool CompressedImage::isSupported(void)
+{
+#ifdef COMPRESSED_IMAGE_GL_FUNCTIONS
+	// El resultado se guarda tras la primera consulta
+	static int supported = -1;
+	GlGetString get_string;
+	const char* extensions;
+
+	if (supported < 0)
+	{
+		get_string = reinterpret_cast<GlGetString>(sf::Context::getFunction("glGetString"));
+		extensions = get_string ? reinterpret_cast<const char*>(get_string(GL_EXTENSIONS)) : nullptr;
+		supported = (extensions && std::strstr(extensions, "GL_EXT_texture_compression_s3tc") &&
+			sf::Context::getFunction("glCompressedTexImage2D")) ? 1 : 0;
+	}
+	return (supported == 1);
+#else
+	return false;
+#endif
+}
+
+void CompressedImage::compressColor(const sf::Uint8* block, sf::Uint8* dest)
+{
+	int min[3] = {255, 255, 255};
+	int max[3] = {0, 0, 0};
+	int palette[4][3];
+	unsigned int color0, color1, indices, best, distance, best_distance;
+	int i, j, c, inset, diff;
+
+	// Usamos como extremos la caja que envuelve los colores del bloque,
+	// encogida ligeramente para reducir el error medio
+	for (i = 0; i < 16; ++i)
+	{
+		for (c = 0; c < 3; ++c)
+		{
+			min[c] = std::min(min[c], static_cast<int>(block[i * 4 + c]));
+			max[c] = std::max(max[c], static_cast<int>(block[i * 4 + c]));
+		}
+	}
+	for (c = 0; c < 3; ++c)
+	{
+		inset = (max[c] - min[c]) >> 4;
+		min[c] += inset;
+		max[c] -= inset;
+	}
+	color0 = ((max[0] >> 3) << 11) | ((max[1] >> 2) << 5) | (max[2] >> 3);
+	color1 = ((min[0] >> 3) << 11) | ((min[1] >> 2) << 5) | (min[2] >> 3);
+
+	// La paleta se calcula con los extremos tal y como los decodifica la
+	// tarjeta. Con extremos iguales todos los pixels usan el primero
+	indices = 0;
+	if (color0 != color1)
+	{
+		palette[0][0] = ((color0 >> 11) << 3) | (color0 >> 13);
+		palette[0][1] = (((color0 >> 5) & 0x3F) << 2) | (((color0 >> 5) & 0x3F) >> 4);
+		palette[0][2] = ((color0 & 0x1F) << 3) | ((color0 & 0x1F) >> 2);
+		palette[1][0] = ((color1 >> 11) << 3) | (color1 >> 13);
+		palette[1][1] = (((color1 >> 5) & 0x3F) << 2) | (((color1 >> 5) & 0x3F) >> 4);
+		palette[1][2] = ((color1 & 0x1F) << 3) | ((color1 & 0x1F) >> 2);
+		for (c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		for (i = 0; i < 16; ++i)
+		{
+			best = 0;
+			best_distance = ~0u;
+			for (j = 0; j < 4; ++j)
+			{
+				distance = 0;
+				for (c = 0; c < 3; ++c)
+				{
+					diff = static_cast<int>(block[i * 4 + c]) - palette[j][c];
+					distance += diff * diff;
+				}
+				if (distance < best_distance)
+				{
+					best_distance = distance;
+					best = j;
+				}
+			}
+			indices |= best << (i * 2);
+		}
+	}
+	dest[0] = color0 & 0xFF;
+	dest[1] = color0 >> 8;
+	dest[2] = color1 & 0xFF;
+	dest[3] = color1 >> 8;
+	dest[4] = indices & 0xFF;
+	dest[5] = (indices >> 8) & 0xFF;
+	dest[6] = (indices >> 16) & 0xFF;
+	dest[7] = indices >> 24;
+}
+
+void CompressedImage::compressAlpha(const sf::Uint8* block, sf::Uint8* dest)
+{
+	int palette[8];
+	int alpha0 = 0;
+	int alpha1 = 255;
+	unsigned long long indices;
+	unsigned int best, distance, best_distance;
+	int i, j;
+
+	for (i = 0; i < 16; ++i)
+	{
+		alpha0 = std::max(alpha0, static_cast<int>(block[i * 4 + 3]));
+		alpha1 = std::min(alpha1, static_cast<int>(block[i * 4 + 3]));
+	}
+
+	// Con el primer extremo mayor la tarjeta interpola 6 valores intermedios
+	indices = 0;
+	if (alpha0 != alpha1)
+	{
+		palette[0] = alpha0;
+		palette[1] = alpha1;
+		for (j = 2; j < 8; ++j)
+		{
+			palette[j] = ((8 - j) * alpha0 + (j - 1) * alpha1) / 7;
+		}
+		for (i = 0; i < 16; ++i)
+		{
+			best = 0;
+			best_distance = ~0u;
+			for (j = 0; j < 8; ++j)
+			{
+				distance = std::abs(static_cast<int>(block[i * 4 + 3]) - palette[j]);
+				if (distance < best_distance)
+				{
+					best_distance = distance;
+					best = j;
+				}
+			}
+			indices |= static_cast<unsigned long long>(best) << (i * 3);
+		}
+	}
+	dest[0] = alpha0;
+	dest[1] = alpha1;
+	for (i = 0; i < 6; ++i)
+	{
+		dest[i + 2] = (indices >> (i * 8)) & 0xFF;
+	}
+}
+
+} // namespace bmonkey
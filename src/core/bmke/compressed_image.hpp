@@ -0,0 +1,146 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _COMPRESSED_IMAGE_HPP_
+#define _COMPRESSED_IMAGE_HPP_
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+namespace bmonkey{
+
+/**
+ * Imagen comprimida en un formato de textura de la tarjeta gráfica
+ *
+ * Comprime imágenes RGBA en los formatos S3TC (DXT1 para imágenes opacas y
+ * DXT5 para imágenes con transparencias), que la tarjeta puede usar
+ * directamente sin descomprimirlas. Ocupan entre 4 y 8 veces menos que la
+ * imagen original, tanto en disco como en la memoria de vídeo, y se suben a
+ * la tarjeta sin conversiones.
+ * La compresión puede realizarse desde cualquier hilo, pero la subida y la
+ * comprobación del soporte necesitan el contexto OpenGL de la ventana.
+ */
+class CompressedImage
+{
+public:
+	/**
+	 * Formatos de compresión soportados
+	 */
+	enum Format
+	{
+		FORMAT_DXT1,	/**< Bloques de 8 bytes sin transparencias */
+		FORMAT_DXT5		/**< Bloques de 16 bytes con canal alfa */
+	};
+
+	/**
+	 * Constructor de la clase
+	 */
+	CompressedImage(void);
+
+	/**
+	 * Comprime una imagen eligiendo el formato según sus transparencias
+	 * @param image Imagen a comprimir
+	 * @return true si se pudo comprimir, false si la imagen está vacía
+	 */
+	bool compress(const sf::Image& image);
+
+	/**
+	 * Crea la imagen a partir de datos ya comprimidos
+	 * @param size Tamaño de la imagen en pixels
+	 * @param format Formato de los datos
+	 * @param data Datos comprimidos
+	 * @return true si se pudo crear, false si el tamaño es incorrecto
+	 */
+	bool create(const sf::Vector2u& size, const Format format, const sf::Uint8* data);
+
+	/**
+	 * Sube la imagen a una textura
+	 * @param texture Textura donde se sube la imagen
+	 * @return true si se pudo subir, false en otro caso
+	 * @note La textura deja de tener mipmaps
+	 */
+	bool upload(sf::Texture& texture) const;
+
+	/**
+	 * Obtiene el tamaño de la imagen
+	 * @return Tamaño de la imagen en pixels
+	 */
+	const sf::Vector2u& getSize(void) const;
+
+	/**
+	 * Obtiene el formato de compresión de la imagen
+	 * @return Formato de la imagen
+	 */
+	Format getFormat(void) const;
+
+	/**
+	 * Obtiene los datos comprimidos de la imagen
+	 * @return Puntero a los datos o null si la imagen está vacía
+	 */
+	const sf::Uint8* getData(void) const;
+
+	/**
+	 * Obtiene el tamaño de los datos comprimidos de la imagen
+	 * @return Número de bytes de los datos
+	 */
+	std::size_t getDataSize(void) const;
+
+	/**
+	 * Calcula el tamaño de los datos comprimidos de una imagen
+	 * @param format Formato de compresión
+	 * @param size Tamaño de la imagen en pixels
+	 * @return Número de bytes de los datos
+	 */
+	static std::size_t getDataSize(const Format format, const sf::Vector2u& size);
+
+	/**
+	 * Indica si la tarjeta gráfica soporta texturas comprimidas S3TC
+	 * @return true si se soportan, false en otro caso
+	 * @note Debe llamarse por primera vez con el contexto de la ventana activo
+	 */
+	static bool isSupported(void);
+
+private:
+	/**
+	 * Comprime el color de un bloque de 4x4 pixels
+	 * @param block Pixels RGBA del bloque
+	 * @param dest Destino de los 8 bytes del bloque
+	 */
+	static void compressColor(const sf::Uint8* block, sf::Uint8* dest);
+
+	/**
+	 * Comprime el canal alfa de un bloque de 4x4 pixels
+	 * @param block Pixels RGBA del bloque
+	 * @param dest Destino de los 8 bytes del bloque
+	 */
+	static void compressAlpha(const sf::Uint8* block, sf::Uint8* dest);
+
+	sf::Vector2u m_size;				/**< Tamaño de la imagen */
+	Format m_format;					/**< Formato de compresión */
+	std::vector<sf::Uint8> m_data;		/**< Datos comprimidos */
+};
+
+// Inclusión de los métodos inline
+#include "compressed_image.inl"
+
+} // namespace bmonkey
+
+#endif // _COMPRESSED_IMAGE_HPP_
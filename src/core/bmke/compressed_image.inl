@@ -0,0 +1,51 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _COMPRESSED_IMAGE_INL_
+#define _COMPRESSED_IMAGE_INL_
+
+inline const sf::Vector2u& CompressedImage::getSize(void) const
+{
+	return m_size;
+}
+
+inline CompressedImage::Format CompressedImage::getFormat(void) const
+{
+	return m_format;
+}
+
+inline const sf::Uint8* CompressedImage::getData(void) const
+{
+	return m_data.empty() ? nullptr : &m_data[0];
+}
+
+inline std::size_t CompressedImage::getDataSize(void) const
+{
+	return m_data.size();
+}
+
+inline std::size_t CompressedImage::getDataSize(const Format format, const sf::Vector2u& size)
+{
+	// Los datos se organizan en bloques de 4x4 pixels
+	return static_cast<std::size_t>((size.x + 3) / 4) * ((size.y + 3) / 4) * (format == FORMAT_DXT1 ? 8 : 16);
+}
+
+#endif // _COMPRESSED_IMAGE_INL_
@@ -21,6 +21,8 @@
 
 #include "director.hpp"
 #include <cassert>
+#include <algorithm>
+#include <glibmm/unicode.h>
 #include "animation_factory.hpp"
 
 #include "animations/move_in_animation.hpp"
@@ -38,6 +40,8 @@ Director::Director(Config* config):
 	m_graphics(config),
 	m_controls(m_graphics.getRenderWindow()),
 	m_font_library(),
+	m_textures(),
+	m_watcher(),
 	m_volumes(&m_sounds, &m_movies),
 	m_show_fps(false),
 	m_fps_update_time(sf::Time::Zero),
@@ -71,12 +75,16 @@ Director::~Director(void)
 	// Si se destruye la instancia, permitimos que se cree de nuevo
 	m_instantiated = false;
 
+	m_watcher.clear();
 	collection->savePlatforms();
 	delete collection;
 }
 
 void Director::init(void)
 {
+	int texture_budget = 64;
+	bool texture_compression = false;
+
 	LOG_INFO("Director: Initializing...");
 	m_init = true;
 
@@ -94,6 +102,21 @@ void Director::init(void)
     LOG_INFO("Director: Initializing volumes...");
     volumeInit();
 
+	// Memoria de textura en MB, las tarjetas de los muebles suelen tener poca
+	if (!m_config->getKey(BMONKEY_CFG_SCREEN, "texture_memory_budget", texture_budget))
+	{
+		m_config->setKey(BMONKEY_CFG_SCREEN, "texture_memory_budget", texture_budget);
+	}
+	m_textures.setMemoryBudget(static_cast<std::size_t>(texture_budget) * 1024 * 1024);
+	m_textures.setThumbnailDir(Glib::build_filename(m_working_dir, USER_LIBRARY_DIR, USER_THUMBNAILS_DIR));
+
+	// Texturas comprimidas para las imágenes reducidas, si la tarjeta las soporta
+	if (!m_config->getKey(BMONKEY_CFG_SCREEN, "texture_compression", texture_compression))
+	{
+		m_config->setKey(BMONKEY_CFG_SCREEN, "texture_compression", texture_compression);
+	}
+	m_textures.setCompression(texture_compression);
+
 	// Inicialización del visor de fps's
 	if (!m_config->getKey(BMONKEY_CFG_SCREEN, "show_fps", m_show_fps))
 	{
@@ -117,6 +140,7 @@ void Director::init(void)
 	collection->loadConfig();
 	collection->loadPlatforms();
 	LOG_DEBUG("fin");
+	watcherInit();
 
 	m_text.setFont(m_font_library.getSystemFont());
 	m_text.setCharacterSize(18);
@@ -261,15 +285,19 @@ void Director::init(void)
     m_controls.enableEvent(ControlManager::SELECT);
     m_controls.enableEvent(ControlManager::BACK);
     m_controls.enableEvent(ControlManager::EXIT_MENU);
+
+    LOG_INFO("Director: Warming up fonts...");
+    glyphsInit();
 }
 
 int Director::run(void)
 {
 	float fixed_fps = 60.f;
-	sf::Time fixed_fps_time = sf::Time::Zero;
-    sf::Time time_since_last_update = sf::Time::Zero;
-    sf::Time delta_time  = sf::Time::Zero;
-    sf::Clock clock;
+	unsigned int fps_limit = 0;
+	unsigned int max_updates = 5;
+	unsigned int updates;
+	int texture_upload_time = 4;
+	sf::Time texture_upload_limit = sf::Time::Zero;
 
   	// Obtenemos el tiempo para las actualizaciones fijas
 	if (!m_config->getKey(BMONKEY_CFG_CORE, "fixed_framerate", fixed_fps))
@@ -280,23 +308,46 @@ int Director::run(void)
 	{
 		fixed_fps = 60.f;
 	}
-	fixed_fps_time = sf::seconds(1.f/fixed_fps);
 
+	// Frames por segundo a mantener y límite de actualizaciones por frame
+	if (!m_config->getKey(BMONKEY_CFG_CORE, "framerate_limit", fps_limit))
+	{
+		m_config->setKey(BMONKEY_CFG_CORE, "framerate_limit", fps_limit);
+	}
+	if (!m_config->getKey(BMONKEY_CFG_CORE, "max_updates_per_frame", max_updates))
+	{
+		m_config->setKey(BMONKEY_CFG_CORE, "max_updates_per_frame", max_updates);
+	}
+	LOG_INFO("Director: Fixed framerate " << fixed_fps << ", Fps Limit " << fps_limit << ", Max updates per frame " << max_updates);
+	m_pacer.setUpdateRate(fixed_fps);
+	m_pacer.setFrameRate(fps_limit);
+	m_pacer.setMaxUpdates(max_updates);
+
+	// Tiempo máximo por frame para subir las texturas cargadas en segundo plano
+	if (!m_config->getKey(BMONKEY_CFG_CORE, "texture_upload_time", texture_upload_time))
+	{
+		m_config->setKey(BMONKEY_CFG_CORE, "texture_upload_time", texture_upload_time);
+	}
+	texture_upload_limit = sf::milliseconds(texture_upload_time);
+
+	m_pacer.start();
     while (m_graphics.isOpen())
     {
-    	delta_time = clock.restart();
-    	time_since_last_update += delta_time;
-        while (time_since_last_update > fixed_fps_time)
+    	updates = m_pacer.beginFrame();
+        for (; updates > 0; --updates)
         {
-        	time_since_last_update -= fixed_fps_time;
         	processInput();
-            update(fixed_fps_time);
+            update(m_pacer.getUpdateTime());
         }
+    	// Las entidades se dibujan entre sus dos últimas actualizaciones
+    	Entity::setInterpolation(m_pacer.getInterpolation());
     	if (m_show_fps)
     	{
-    		updateFps(delta_time);
+    		updateFps(m_pacer.getFrameTime());
     	}
+    	m_textures.update(texture_upload_limit);
         draw();
+        m_pacer.endFrame();
     }
 
 	clean();
@@ -547,8 +598,143 @@ void Director::processInput(void)
 	}
 }
 
+void Director::glyphsInit(void)
+{
+	std::set<sf::Uint32> glyphs;
+	Platform* current_platform;
+	Gamelist* master;
+	Item* platform_item;
+	Item* game_item;
+	Game* current_game;
+	int platforms, games;
+	char c;
+
+	// Caracteres imprimibles básicos, usados por los textos fijos del tema
+	for (c = ' '; c <= '~'; ++c)
+	{
+		glyphs.insert(c);
+	}
+	// Caracteres de los textos de la colección
+	platform_item = collection->itemFirst();
+	for (platforms = collection->platformCount(); platforms > 0; --platforms)
+	{
+		current_platform = collection->platformGet(platform_item);
+		glyphsAdd(current_platform->getTitle(), glyphs);
+		glyphsAdd(current_platform->getManufacturer(), glyphs);
+		glyphsAdd(current_platform->getYear(), glyphs);
+		master = current_platform->gamelistGet();
+		game_item = master->itemFirst();
+		for (games = master->gameCount(); (games > 0) && game_item; --games)
+		{
+			current_game = master->gameGet(game_item);
+			glyphsAdd(current_game->title, glyphs);
+			glyphsAdd(current_game->manufacturer, glyphs);
+			glyphsAdd(current_game->year, glyphs);
+			glyphsAdd(current_game->genre, glyphs);
+			game_item = master->itemNext(game_item);
+		}
+		platform_item = collection->itemNext(platform_item);
+	}
+	m_font_library.setGlyphSet(glyphs);
+	m_font_library.warmUp();
+}
+
+void Director::glyphsAdd(const Glib::ustring& text, std::set<sf::Uint32>& glyphs)
+{
+	Glib::ustring::const_iterator iter;
+
+	// Los textos pueden mostrarse en mayúsculas
+	for (iter = text.begin(); iter != text.end(); ++iter)
+	{
+		glyphs.insert(*iter);
+		glyphs.insert(Glib::Unicode::toupper(*iter));
+	}
+}
+
+void Director::watcherInit(void)
+{
+	Item* item;
+	int count;
+
+	if (!m_watcher.isSupported())
+	{
+		LOG_INFO("Director: Directory watching not supported, changes will be detected on restart");
+		return;
+	}
+	item = collection->itemFirst();
+	for (count = collection->platformCount(); count > 0; --count)
+	{
+		m_watcher.watch(collection->platformGet(item));
+		item = collection->itemNext(item);
+	}
+}
+
+void Director::updateWatcher(void)
+{
+	std::vector<Glib::ustring> files;
+	std::vector<Glib::ustring>::iterator iter;
+	std::vector<Platform*> platforms;
+	Glib::ustring list_name, game_name;
+	int changes;
+
+	// Guardamos la selección por nombre, ya que aplicar los cambios puede
+	// liberar la lista actual y sus elementos
+	if (!gamelist->isMaster())
+	{
+		list_name = gamelist->getName();
+	}
+	if (game)
+	{
+		game_name = game->name;
+	}
+	changes = m_watcher.update();
+	// Una recarga fallida elimina la lista aunque no cuente como cambio
+	if (m_watcher.pollGamelists(platforms) &&
+		(std::find(platforms.begin(), platforms.end(), platform) != platforms.end()))
+	{
+		selectionReload(list_name, game_name);
+		++changes;
+	}
+	if (changes == 0)
+	{
+		return;
+	}
+	// Las texturas modificadas en disco se recargan si están en uso
+	if (m_watcher.pollMedia(files))
+	{
+		for (iter = files.begin(); iter != files.end(); ++iter)
+		{
+			m_textures.reloadTexture(*iter);
+		}
+	}
+	// Los textos muestran datos de las listas, los refrescamos
+	pp_text.refresh();
+	ll_text.refresh();
+	gg_text.refresh();
+}
+
+void Director::selectionReload(const Glib::ustring& list_name, const Glib::ustring& game_name)
+{
+	gamelist = list_name.empty() ? nullptr : platform->gamelistGet(list_name);
+	if (!gamelist)
+	{
+		// La lista ha desaparecido, volvemos a la master
+		gamelist = platform->gamelistGet();
+	}
+	item = game_name.empty() ? nullptr : gamelist->itemGet(game_name);
+	if (!item)
+	{
+		item = gamelist->itemFirst();
+	}
+	game = item ? gamelist->gameGet(item) : nullptr;
+	ll_text.setGamelist(gamelist);
+	gg_text.setGame(game);
+}
+
 void Director::update(sf::Time delta_time)
 {
+	updateWatcher();
+
 	m_text.update(delta_time);
 	mm_text.update(delta_time);
 	message.update(delta_time);
@@ -575,7 +761,13 @@ void Director::updateFps(sf::Time delta_time)
 	{
 
 		text = "Frames / Second = " + utils::toStr(m_fps_num_frames) + "\n" +
-				"Time / Update = " + utils::toStr(m_fps_update_time.asMicroseconds() / m_fps_num_frames) + "us";
+				"Time / Update = " + utils::toStr(m_fps_update_time.asMicroseconds() / m_fps_num_frames) + "us\n" +
+				"Textures = " + utils::toStr(m_textures.getMemoryUsage() / 1024) + "KB (Hits: " +
+				utils::toStr(m_textures.getHits()) + ", Misses: " + utils::toStr(m_textures.getMisses()) +
+				", Evictions: " + utils::toStr(m_textures.getEvictions()) + ")\n" +
+				"Batches / Frame = " + utils::toStr(m_graphics.getSpriteBatch()->getDrawCalls() / m_fps_num_frames) +
+				" (Quads: " + utils::toStr(m_graphics.getSpriteBatch()->getQuadCount() / m_fps_num_frames) + ")";
+		m_graphics.getSpriteBatch()->resetStats();
 
 		m_fps_text.setString(text.raw());
 
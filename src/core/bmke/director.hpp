@@ -26,6 +26,7 @@
 #include "../../utils/config.hpp"
 
 #include "../collection/collection.hpp"
+#include "../collection/platform_watcher.hpp"
 #include "graphics.hpp"
 #include "control_manager.hpp"
 #include "font_library.hpp"
@@ -34,6 +35,7 @@
 #include "movie_manager.hpp"
 #include "volume_manager.hpp"
 #include "shader_manager.hpp"
+#include "frame_pacer.hpp"
 
 #include "entities/transition_entity.hpp"
 #include "entities/box_entity.hpp"
@@ -98,6 +100,39 @@ private:
 	 */
 	void update(sf::Time delta_time);
 
+	/**
+	 * Precarga en las fuentes los caracteres de los textos de la colección
+	 * con los tamaños usados por los textos
+	 */
+	void glyphsInit(void);
+
+	/**
+	 * Añade al conjunto de caracteres a precargar los de un texto, en su forma
+	 * original y en mayúsculas
+	 * @param text Texto del que tomar los caracteres
+	 * @param glyphs Conjunto donde se añaden los caracteres
+	 */
+	void glyphsAdd(const Glib::ustring& text, std::set<sf::Uint32>& glyphs);
+
+	/**
+	 * Comienza a vigilar los directorios de todas las plataformas de la
+	 * colección
+	 */
+	void watcherInit(void);
+
+	/**
+	 * Aplica los cambios producidos en los directorios de las plataformas
+	 */
+	void updateWatcher(void);
+
+	/**
+	 * Vuelve a obtener por nombre la lista, el elemento y el juego actuales
+	 * tras recargarse o eliminarse las listas de la plataforma actual
+	 * @param list_name Nombre de la lista actual o cadena vacía si es la master
+	 * @param game_name Nombre del juego actual o cadena vacía si no hay juego
+	 */
+	void selectionReload(const Glib::ustring& list_name, const Glib::ustring& game_name);
+
 	/**
 	 * Se encarga de actualizar el recuento de fps's
 	 * @param delta_time Tiempo transcurrido desde la última actualización
@@ -124,9 +159,12 @@ private:
 	Graphics m_graphics;
 	ControlManager m_controls;
 	FontLibrary m_font_library;		/**< Librería de fuentes para el fe */
+	TextureManager m_textures;		/**< Almacén de texturas para el fe */
+	PlatformWatcher m_watcher;		/**< Vigilancia de los directorios de las plataformas */
 	SoundManager m_sounds;
 	MovieManager m_movies;
 	VolumeManager m_volumes;
+	FramePacer m_pacer;				/**< Ritmo del bucle principal */
 
 	bool m_show_fps;
 	// Contador de frames del libro SFML Game Development
@@ -89,7 +89,7 @@ void BoxEntity::setPivot(Pivot pivot)
 void BoxEntity::setColor(const sf::Color& color)
 {
 	Entity::setColor(color);
-	m_box.setFillColor(color);
+	m_box.setFillColor(getEffectiveColor());
 }
 
 sf::Vector2i BoxEntity::getSize(void) const
@@ -102,6 +102,7 @@ void BoxEntity::setSize(const int width, const int height)
 	m_size.x = width < 0 ? 0 : width;
 	m_size.y = height < 0 ? 0 : height;
 	m_box.setSize(sf::Vector2f(m_size));
+	setDirty();
 	// Forzamos el cálculo del pivote
 	setPivot(m_pivot);
 }
@@ -113,7 +114,11 @@ void BoxEntity::setSize(const sf::Vector2i& size)
 
 void BoxEntity::updateCurrent(sf::Time delta_time, const sf::Color& color)
 {
-	m_box.setFillColor(getColor());
+}
+
+void BoxEntity::updateColor(const sf::Color& color)
+{
+	m_box.setFillColor(color);
 }
 
 void BoxEntity::drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
@@ -121,4 +126,16 @@ void BoxEntity::drawCurrent(sf::RenderTarget& target, sf::RenderStates states) c
 	target.draw(m_box, states);
 }
 
+bool BoxEntity::batchCurrent(SpriteBatch& batch, const sf::RenderStates& states) const
+{
+	sf::Vertex vertices[4];
+
+	vertices[0] = sf::Vertex(sf::Vector2f(0.f, 0.f), m_box.getFillColor());
+	vertices[1] = sf::Vertex(sf::Vector2f(m_size.x, 0.f), m_box.getFillColor());
+	vertices[2] = sf::Vertex(sf::Vector2f(m_size.x, m_size.y), m_box.getFillColor());
+	vertices[3] = sf::Vertex(sf::Vector2f(0.f, m_size.y), m_box.getFillColor());
+	batch.add(vertices, 4, states);
+	return true;
+}
+
 } // namespace bmonkey
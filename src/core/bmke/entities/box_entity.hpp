@@ -86,6 +86,12 @@ protected:
 	 */
 	virtual void updateCurrent(sf::Time delta_time, const sf::Color& color);
 
+	/**
+	 * Aplica el color efectivo al rectángulo
+	 * @param color Nuevo color efectivo de la entidad
+	 */
+	virtual void updateColor(const sf::Color& color);
+
 	/**
 	 * Realiza el dibujado real de esta entidad
 	 * @param target Target donde se dibujará la entidad
@@ -94,6 +100,14 @@ protected:
 	 */
 	virtual void drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
 
+	/**
+	 * Añade el quad de la caja a un agrupador
+	 * @param batch Agrupador donde añadir el quad
+	 * @param states States para dibujar la entidad
+	 * @return Siempre true, la caja siempre se puede agrupar
+	 */
+	virtual bool batchCurrent(SpriteBatch& batch, const sf::RenderStates& states) const;
+
 private:
 	sf::Vector2i m_size;		/**< Dimensiones de la entidad */
 	sf::RectangleShape m_box;	/**< Primitiva rectángulo para la entidad */
@@ -32,12 +32,21 @@ namespace bmonkey{
 // El borde tiene un grosor predeterminado de 2 pixeles
 #define OUTLINE_THICKNESS 2
 
+// Direcciones en las que se repite el texto para dibujar el borde sin SDF. Las
+// cuatro primeras son las de calidad LOW
+static const sf::Vector2f OUTLINE_OFFSETS[8] =
+{
+	sf::Vector2f(-1.f, -1.f), sf::Vector2f(1.f, -1.f), sf::Vector2f(1.f, 1.f), sf::Vector2f(-1.f, 1.f),
+	sf::Vector2f(-1.f, 0.f), sf::Vector2f(0.f, -1.f), sf::Vector2f(1.f, 0.f), sf::Vector2f(0.f, 1.f)
+};
+
 TextEntity::TextEntity(FontLibrary* font_library):
 	Entity(),
 	m_font_library(font_library),
 	m_font(font_library->getSystemFont()),
 	m_character_size(30),
 	m_style(REGULAR),
+	m_font_size_added(false),
 	m_text_color(sf::Color::White),
 	m_max_length(0),
 	m_force_uppercase(false),
@@ -47,17 +56,25 @@ TextEntity::TextEntity(FontLibrary* font_library):
 	m_shadow_enabled(true),
 	m_shadow_color(sf::Color::Transparent),
 	m_shadow_offset(sf::Vector2i(0, 0)),
-	m_shadow_position(sf::Vector2i(0, 0))
-
+	m_shadow_position(sf::Vector2i(0, 0)),
+	m_sdf_font(nullptr),
+	m_vertices(sf::Quads),
+	m_shadow_count(0),
+	m_outline_count(0),
+	m_geometry_valid(false),
+	m_colors_valid(false),
+	m_geometry_color(sf::Color::White)
 {
 	assert(m_font_library);
 
-	// Por defecto fijamos la fuente del sistema
+	// Por defecto fijamos la fuente del sistema. El tamaño no se registra
+	// para precargarlo hasta que el tema fija el definitivo
 	m_text.setFont(*m_font);
 }
 
 TextEntity::~TextEntity(void)
 {
+	releaseFontSize();
 	// Indicamos que se puede eliminar la fuente
 	m_font_library->deleteFont(m_font);
 }
@@ -116,6 +133,33 @@ void TextEntity::setPivot(Pivot pivot)
 	setOrigin(origin.x, origin.y);
 }
 
+sf::FloatRect TextEntity::getLocalBounds(void) const
+{
+	sf::FloatRect bounds;
+	float right;
+	float bottom;
+
+	// Además del texto hay que tener en cuenta el borde y la sombra
+	bounds = m_text.getLocalBounds();
+	if (m_outline_enabled)
+	{
+		bounds.left -= OUTLINE_THICKNESS;
+		bounds.top -= OUTLINE_THICKNESS;
+		bounds.width += 2 * OUTLINE_THICKNESS;
+		bounds.height += 2 * OUTLINE_THICKNESS;
+	}
+	if (m_shadow_enabled && (m_shadow_offset.x != 0 || m_shadow_offset.y != 0))
+	{
+		right = std::max(bounds.left + bounds.width, bounds.left + bounds.width + m_shadow_position.x);
+		bottom = std::max(bounds.top + bounds.height, bounds.top + bounds.height + m_shadow_position.y);
+		bounds.left = std::min(bounds.left, bounds.left + m_shadow_position.x);
+		bounds.top = std::min(bounds.top, bounds.top + m_shadow_position.y);
+		bounds.width = right - bounds.left;
+		bounds.height = bottom - bounds.top;
+	}
+	return bounds;
+}
+
 sf::Vector2i TextEntity::getSize(void) const
 {
 	sf::FloatRect bounds;
@@ -133,9 +177,12 @@ void TextEntity::setFont(sf::Font* font)
 	if (font != m_font)
 	{
 		// Primero eliminamos la fuente previa
+		releaseFontSize();
 		m_font_library->deleteFont(m_font);
 		m_font = font;
 		m_text.setFont(*m_font);
+		registerFontSize();
+		updateSdf();
 		// Actualizamos el pivote para posicionarlo en el lugar correcto
 		setPivot(m_pivot);
 	}
@@ -159,20 +206,35 @@ void TextEntity::setString(const Glib::ustring& string)
 		new_string = string;
 	}
 	m_text.setString(fromUstring(m_force_uppercase ? new_string.uppercase() : new_string));
+	updateSdf();
 	setPivot(m_pivot);
 }
 
 void TextEntity::setCharacterSize(const unsigned int size)
 {
+	releaseFontSize();
 	m_character_size = size;
 	m_text.setCharacterSize(size);
+	registerFontSize();
+	m_geometry_valid = false;
+	setDirty();
 	setPivot(m_pivot);
 }
 
 void TextEntity::setStyle(const TextEntity::Style& style)
 {
+	bool registered;
+
+	// El estilo sólo cambia la variante ya registrada, no la registra
+	registered = m_font_size_added;
+	releaseFontSize();
 	m_style = style;
 	m_text.setStyle(style);
+	if (registered)
+	{
+		registerFontSize();
+	}
+	updateSdf();
 	setPivot(m_pivot);
 }
 
@@ -191,6 +253,8 @@ void TextEntity::setForceUppercase(const bool uppercase)
 void TextEntity::setOutlineEnabled(const bool enabled)
 {
 	m_outline_enabled = enabled;
+	m_geometry_valid = false;
+	setDirty();
 
 	// Ajustamos la posición de la sombra si se habilitó el outline
 	if (m_outline_enabled && (m_shadow_offset.x != 0 || m_shadow_offset.y != 0))
@@ -204,6 +268,8 @@ void TextEntity::setShadowOffset(const int ox, const int oy)
 {
 	m_shadow_offset.x = ox;
 	m_shadow_offset.y = oy;
+	m_geometry_valid = false;
+	setDirty();
 
 	// Ajustamos la posición del shadow
 	if (m_shadow_offset.x != 0 || m_shadow_offset.y != 0)
@@ -224,57 +290,318 @@ void TextEntity::setShadowOffset(const int ox, const int oy)
 
 void TextEntity::drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
 {
-	sf::Text text;
+	sf::Shader* shader;
 
-	text.setFont(*m_font);
-	text.setString(m_text.getString());
-	text.setCharacterSize(m_character_size);
-	text.setStyle(m_style);
+	ensureGeometry();
+	if (m_vertices.getVertexCount() == 0)
+	{
+		return;
+	}
 
-	// Comprobamos si hay que dibujar la sombra
-	if (m_shadow_enabled && (m_shadow_offset.x != 0 || m_shadow_offset.y != 0))
+	if (m_sdf_font)
+	{
+		// Relleno y borde se resuelven en el shader a partir del atlas SDF
+		shader = m_font_library->getSdfShader();
+		shader->setParameter("texture", sf::Shader::CurrentTexture);
+		shader->setParameter("fill_color", m_text_color * getEffectiveColor());
+		if (m_outline_enabled)
+		{
+			// El grosor se pasa a unidades de distancia del atlas, limitado a
+			// lo que el atlas puede representar
+			shader->setParameter("outline_color", m_outline_color * getEffectiveColor());
+			shader->setParameter("outline_width", std::min(OUTLINE_THICKNESS * static_cast<float>(SdfFont::BASE_SIZE) / m_character_size / (2.f * SdfFont::SPREAD), 0.45f));
+		}
+		else
+		{
+			shader->setParameter("outline_color", m_text_color * getEffectiveColor());
+			shader->setParameter("outline_width", 0.f);
+		}
+		states.shader = shader;
+		states.texture = &m_sdf_font->getTexture();
+	}
+	else
 	{
-		text.setColor(m_shadow_color * m_color);
-		text.setPosition(m_shadow_position.x, m_shadow_position.y);
-		target.draw(text, states);
+		states.texture = &m_font->getTexture(m_character_size);
 	}
+	target.draw(m_vertices, states);
+}
 
-	// Comprobamos si hay que sibujar el outline
-	if (m_outline_enabled)
+bool TextEntity::batchCurrent(SpriteBatch& batch, const sf::RenderStates& states) const
+{
+	sf::RenderStates text_states(states);
+
+	if (m_sdf_font)
+	{
+		return false;
+	}
+	ensureGeometry();
+	if (m_vertices.getVertexCount() > 0)
 	{
+		text_states.texture = &m_font->getTexture(m_character_size);
+		batch.add(&m_vertices[0], m_vertices.getVertexCount(), text_states);
+	}
+	return true;
+}
 
-		text.setColor(m_outline_color * m_color);
-
-		// Para que el outline quede con buena calidad, se necesita renderizar
-		// el texto en 8 direcciones, pero esto hace que la carga de renderizado
-		// sea mucho mayor, por lo que dividimos en dos bloques de cuatro
-		// dependiendo de la calidad solicitada
-		// Calidad LOW
-		text.setPosition(-OUTLINE_THICKNESS, -OUTLINE_THICKNESS);
-		target.draw(text, states);
-		text.setPosition(OUTLINE_THICKNESS, -OUTLINE_THICKNESS);
-		target.draw(text, states);
-		text.setPosition(OUTLINE_THICKNESS, OUTLINE_THICKNESS);
-		target.draw(text, states);
-		text.setPosition(-OUTLINE_THICKNESS, OUTLINE_THICKNESS);
-		target.draw(text, states);
-		// Calidad HIGH
-		if (m_outline_quality == HIGH)
+void TextEntity::ensureGeometry(void) const
+{
+	// La geometría sólo se regenera cuando cambia el texto o su aspecto, y los
+	// colores cuando cambian los de la entidad
+	if (!m_geometry_valid)
+	{
+		updateGeometry();
+	}
+	if (!m_colors_valid || (m_geometry_color != getEffectiveColor()))
+	{
+		updateColors();
+	}
+}
+
+void TextEntity::registerFontSize(void)
+{
+	assert(!m_font_size_added);
+
+	m_font_library->addFontSize(m_font, m_character_size, m_style & BOLD);
+	m_font_size_added = true;
+}
+
+void TextEntity::releaseFontSize(void)
+{
+	if (m_font_size_added)
+	{
+		m_font_library->removeFontSize(m_font, m_character_size, m_style & BOLD);
+		m_font_size_added = false;
+	}
+}
+
+void TextEntity::updateSdf(void)
+{
+	SdfFont* sdf_font;
+
+	m_sdf_font = nullptr;
+	m_geometry_valid = false;
+	setDirty();
+	// El subrayado y el tachado no están en el atlas
+	if ((m_style & (UNDERLINED | STRIKETHROUGH)) || !m_font_library->getSdfShader())
+	{
+		return;
+	}
+	sdf_font = m_font_library->getSdfFont(m_font);
+	if (sdf_font && sdf_font->loadGlyphs(m_text.getString(), m_style & BOLD))
+	{
+		m_sdf_font = sdf_font;
+	}
+}
+
+void TextEntity::updateGeometry(void) const
+{
+	const SdfFont::Glyph* sdf_glyph;
+	sf::VertexArray glyphs(sf::Quads);
+	sf::String string;
+	sf::Vector2f position;
+	sf::FloatRect bounds;
+	sf::FloatRect x_bounds;
+	sf::Uint32 previous = 0;
+	sf::Uint32 current;
+	float scale;
+	float italic;
+	float space;
+	float line_spacing;
+	float thickness;
+	bool bold;
+	unsigned int offsets;
+	std::size_t count;
+	std::size_t i;
+	std::size_t j;
+
+	bold = m_style & BOLD;
+	// Mismo factor de inclinación que usa sf::Text para la cursiva
+	italic = (m_style & ITALIC) ? 0.208f : 0.f;
+	if (m_sdf_font)
+	{
+		scale = static_cast<float>(m_character_size) / SdfFont::BASE_SIZE;
+		sdf_glyph = m_sdf_font->getGlyph(L' ', bold);
+		space = sdf_glyph ? sdf_glyph->advance * scale : 0.f;
+	}
+	else
+	{
+		scale = 1.f;
+		space = m_font->getGlyph(L' ', m_character_size, bold).advance;
+	}
+	line_spacing = m_font->getLineSpacing(m_character_size);
+	thickness = m_character_size * (bold ? 0.1f : 0.07f);
+	if (m_style & STRIKETHROUGH)
+	{
+		x_bounds = sf::FloatRect(m_font->getGlyph(L'x', m_character_size, bold).bounds);
+	}
+	string = m_text.getString();
+
+	// Colocamos los caracteres igual que sf::Text, con la línea base del
+	// primer renglón a la altura del tamaño de los caracteres
+	position.x = 0.f;
+	position.y = m_character_size;
+	for (i = 0; i < string.getSize(); ++i)
+	{
+		current = string[i];
+		position.x += m_font->getKerning(previous, current, m_character_size);
+		previous = current;
+		if (current == L'\n')
+		{
+			appendLines(glyphs, position, thickness, x_bounds);
+		}
+		switch (current)
+		{
+		case L' ':
+			position.x += space;
+			continue;
+		case L'\t':
+			position.x += space * 4;
+			continue;
+		case L'\n':
+			position.y += line_spacing;
+			position.x = 0.f;
+			continue;
+		}
+		if (m_sdf_font)
+		{
+			sdf_glyph = m_sdf_font->getGlyph(current, bold);
+			if (!sdf_glyph)
+			{
+				continue;
+			}
+			bounds.left = sdf_glyph->bounds.left * scale;
+			bounds.top = sdf_glyph->bounds.top * scale;
+			bounds.width = sdf_glyph->bounds.width * scale;
+			bounds.height = sdf_glyph->bounds.height * scale;
+			// Los caracteres sin forma sólo aportan su avance
+			if (sdf_glyph->rect.width > 0)
+			{
+				appendQuad(glyphs, position, bounds, sdf_glyph->rect, italic);
+			}
+			position.x += sdf_glyph->advance * scale;
+		}
+		else
 		{
-			text.setPosition(-OUTLINE_THICKNESS, 0);
-			target.draw(text, states);
-			text.setPosition(0, -OUTLINE_THICKNESS);
-			target.draw(text, states);
-			text.setPosition(OUTLINE_THICKNESS, 0);
-			target.draw(text, states);
-			text.setPosition(0, OUTLINE_THICKNESS);
-			target.draw(text, states);
+			const sf::Glyph& glyph = m_font->getGlyph(current, m_character_size, bold);
+			appendQuad(glyphs, position, sf::FloatRect(glyph.bounds), glyph.textureRect, italic);
+			position.x += glyph.advance;
 		}
 	}
+	appendLines(glyphs, position, thickness, x_bounds);
+
+	// Juntamos todas las capas en un único array en orden de dibujado: sombra,
+	// borde y relleno
+	count = glyphs.getVertexCount();
+	m_vertices.clear();
+	m_shadow_count = 0;
+	m_outline_count = 0;
+	if (m_shadow_enabled && (m_shadow_offset.x != 0 || m_shadow_offset.y != 0))
+	{
+		for (i = 0; i < count; ++i)
+		{
+			m_vertices.append(glyphs[i]);
+			m_vertices[i].position.x += m_shadow_position.x;
+			m_vertices[i].position.y += m_shadow_position.y;
+			// Con SDF el shader reconoce la sombra por la coordenada x
+			// negativa, ya que el atlas nunca usa la columna 0
+			if (m_sdf_font)
+			{
+				m_vertices[i].texCoords.x = -m_vertices[i].texCoords.x;
+			}
+		}
+		m_shadow_count = count;
+	}
+	// Sin SDF, para que el outline quede con buena calidad, se necesita
+	// renderizar el texto en 8 direcciones, pero esto hace que la carga sea
+	// mucho mayor, por lo que usamos sólo 4 en calidad LOW
+	if (m_outline_enabled && !m_sdf_font)
+	{
+		offsets = (m_outline_quality == HIGH) ? 8 : 4;
+		for (j = 0; j < offsets; ++j)
+		{
+			for (i = 0; i < count; ++i)
+			{
+				m_vertices.append(glyphs[i]);
+				m_vertices[m_vertices.getVertexCount() - 1].position += OUTLINE_OFFSETS[j] * static_cast<float>(OUTLINE_THICKNESS);
+			}
+		}
+		m_outline_count = count * offsets;
+	}
+	for (i = 0; i < count; ++i)
+	{
+		m_vertices.append(glyphs[i]);
+	}
+	m_geometry_valid = true;
+	m_colors_valid = false;
+}
+
+void TextEntity::updateColors(void) const
+{
+	sf::Color color;
+	std::size_t count;
+	std::size_t i;
+
+	count = m_vertices.getVertexCount();
+	color = m_shadow_color * getEffectiveColor();
+	for (i = 0; i < m_shadow_count; ++i)
+	{
+		m_vertices[i].color = color;
+	}
+	color = m_outline_color * getEffectiveColor();
+	for (; i < m_shadow_count + m_outline_count; ++i)
+	{
+		m_vertices[i].color = color;
+	}
+	// Con SDF los colores del relleno y el borde son parámetros del shader
+	color = m_sdf_font ? sf::Color::White : m_text_color * getEffectiveColor();
+	for (; i < count; ++i)
+	{
+		m_vertices[i].color = color;
+	}
+	m_geometry_color = getEffectiveColor();
+	m_colors_valid = true;
+}
+
+void TextEntity::appendQuad(sf::VertexArray& vertices, const sf::Vector2f& position, const sf::FloatRect& bounds, const sf::IntRect& rect, const float italic)
+{
+	float left;
+	float top;
+	float right;
+	float bottom;
+
+	left = position.x + bounds.left;
+	top = position.y + bounds.top;
+	right = left + bounds.width;
+	bottom = top + bounds.height;
+	vertices.append(sf::Vertex(sf::Vector2f(left - italic * bounds.top, top), sf::Color::White, sf::Vector2f(rect.left, rect.top)));
+	vertices.append(sf::Vertex(sf::Vector2f(right - italic * bounds.top, top), sf::Color::White, sf::Vector2f(rect.left + rect.width, rect.top)));
+	vertices.append(sf::Vertex(sf::Vector2f(right - italic * (bounds.top + bounds.height), bottom), sf::Color::White, sf::Vector2f(rect.left + rect.width, rect.top + rect.height)));
+	vertices.append(sf::Vertex(sf::Vector2f(left - italic * (bounds.top + bounds.height), bottom), sf::Color::White, sf::Vector2f(rect.left, rect.top + rect.height)));
+}
+
+void TextEntity::appendLines(sf::VertexArray& vertices, const sf::Vector2f& position, const float thickness, const sf::FloatRect& x_bounds) const
+{
+	sf::FloatRect bounds;
 
-	text.setColor(m_text_color * m_color);
-	text.setPosition(0, 0);
-	target.draw(text, states);
+	if (position.x <= 0.f)
+	{
+		return;
+	}
+	// Las líneas usan el cuadrado blanco que SFML reserva en la esquina de
+	// cada página de la textura de la fuente
+	bounds.left = 0.f;
+	bounds.width = position.x;
+	bounds.height = thickness;
+	if (m_style & UNDERLINED)
+	{
+		bounds.top = m_character_size * 0.1f;
+		appendQuad(vertices, sf::Vector2f(0.f, position.y), bounds, sf::IntRect(1, 1, 0, 0), 0.f);
+	}
+	if (m_style & STRIKETHROUGH)
+	{
+		bounds.top = x_bounds.top + x_bounds.height / 2.f;
+		appendQuad(vertices, sf::Vector2f(0.f, position.y), bounds, sf::IntRect(1, 1, 0, 0), 0.f);
+	}
 }
 
 sf::String TextEntity::fromUstring(const Glib::ustring& ustring)
@@ -26,6 +26,7 @@
 #include "../../../defines.hpp"
 #include "../entity.hpp"
 #include "../font_library.hpp"
+#include "../sdf_font.hpp"
 
 namespace bmonkey{
 
@@ -38,6 +39,13 @@ namespace bmonkey{
  * Tanto el borde como la sombra se pueden desactivar para reducir la carga
  * de dibujado de la entidad y se puede configurar la calidad de renderizado
  * para el borde.
+ * Si el sistema soporta shaders, el texto se dibuja a partir del atlas SDF de
+ * su fuente y las tres capas se obtienen en un único dibujado, con un borde
+ * que no depende de la calidad configurada. En otro caso, o si el texto usa
+ * subrayado o tachado, el borde se obtiene repitiendo los caracteres
+ * desplazados dentro del mismo array de vértices.
+ * Los vértices se guardan entre frames y sólo se regeneran cuando cambia el
+ * texto, la fuente, el tamaño, el estilo o los colores.
  */
 class TextEntity : public Entity
 {
@@ -88,6 +96,13 @@ public:
 	 */
 	virtual sf::Vector2i getSize(void) const;
 
+	/**
+	 * Obtiene la caja que ocupa el dibujado del texto, incluyendo su borde y
+	 * su sombra
+	 * @return Caja local de la entidad
+	 */
+	virtual sf::FloatRect getLocalBounds(void) const;
+
 	/**
 	 * Obtiene la fuente usada por la entidad
 	 * @return Fuente usada por la entidad
@@ -270,6 +285,15 @@ protected:
 	 */
 	virtual void drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
 
+	/**
+	 * Añade los quads del texto a un agrupador
+	 * @param batch Agrupador donde añadir los quads
+	 * @param states States para dibujar la entidad
+	 * @return true si se añadieron, false si el texto se dibuja con SDF, ya
+	 * que su shader necesita los colores de cada texto
+	 */
+	virtual bool batchCurrent(SpriteBatch& batch, const sf::RenderStates& states) const;
+
 	/**
 	 * Convierte una cadena Glib::ustring a sf::String
 	 * @param ustring Cadena a convertir
@@ -278,11 +302,67 @@ protected:
 	sf::String fromUstring(const Glib::ustring& ustring);
 
 private:
+	/**
+	 * Prepara el atlas SDF con los caracteres del texto actual y decide si se
+	 * puede usar para dibujarlo
+	 */
+	void updateSdf(void);
+
+	/**
+	 * Registra en la librería el tamaño y la fuente actuales para precargar
+	 * sus caracteres
+	 * @pre El registro previo debe haberse liberado con releaseFontSize
+	 */
+	void registerFontSize(void);
+
+	/**
+	 * Libera el registro del tamaño y la fuente en la librería, si lo hay
+	 */
+	void releaseFontSize(void);
+
+	/**
+	 * Regenera los vértices y sus colores si han quedado desfasados
+	 */
+	void ensureGeometry(void) const;
+
+	/**
+	 * Regenera los vértices de todas las capas del texto: sombra, borde (sólo
+	 * sin SDF) y relleno, en ese orden
+	 */
+	void updateGeometry(void) const;
+
+	/**
+	 * Aplica a los vértices los colores de cada capa, teniendo en cuenta el
+	 * color de la entidad
+	 */
+	void updateColors(void) const;
+
+	/**
+	 * Añade al array el quad de un carácter
+	 * @param vertices Array donde añadir el quad
+	 * @param position Posición del carácter sobre la línea base
+	 * @param bounds Caja del carácter respecto a su posición
+	 * @param rect Región de la textura con el carácter
+	 * @param italic Factor de inclinación de la cursiva
+	 */
+	static void appendQuad(sf::VertexArray& vertices, const sf::Vector2f& position, const sf::FloatRect& bounds, const sf::IntRect& rect, const float italic);
+
+	/**
+	 * Añade al array el subrayado y el tachado de un renglón, si el estilo los
+	 * incluye
+	 * @param vertices Array donde añadir las líneas
+	 * @param position Posición al final del renglón sobre la línea base
+	 * @param thickness Grosor de las líneas
+	 * @param x_bounds Caja del carácter 'x', para colocar el tachado
+	 */
+	void appendLines(sf::VertexArray& vertices, const sf::Vector2f& position, const float thickness, const sf::FloatRect& x_bounds) const;
+
 	FontLibrary* m_font_library;		/**< Librería de fuentes a usar por la entidad */
 	sf::Font* m_font;					/**< SFML Font usada */
 	Glib::ustring m_string;				/**< Cadena de texto a renderizar */
 	unsigned int m_character_size;		/**< Tamaño base de los caracteres en pixeles */
 	Style m_style;						/**< Estilo aplicado al texto */
+	bool m_font_size_added;				/**< Indica si el tamaño actual está registrado en la librería */
 	sf::Color m_text_color;				/**< Color del texto */
 	unsigned int m_max_length;			/**< Longitud máxima permitida para el texto */
 	bool m_force_uppercase;				/**< Indica si hay que forzar mayúsculas */
@@ -294,6 +374,13 @@ private:
 	sf::Vector2i m_shadow_offset;		/**< Offsets de la sombra en pixeles */
 	sf::Vector2i m_shadow_position;		/**< Posición de la sombra */
 	sf::Text m_text;					/**< Texto para cálculos internos */
+	SdfFont* m_sdf_font;				/**< Atlas SDF con los caracteres del texto o null si no se usa */
+	mutable sf::VertexArray m_vertices;	/**< Vértices de todas las capas del texto */
+	mutable std::size_t m_shadow_count;	/**< Vértices de la capa de sombra */
+	mutable std::size_t m_outline_count;	/**< Vértices de la capa de borde */
+	mutable bool m_geometry_valid;		/**< Indica si los vértices corresponden al texto actual */
+	mutable bool m_colors_valid;		/**< Indica si los colores de los vértices están al día */
+	mutable sf::Color m_geometry_color;	/**< Color de la entidad aplicado a los vértices */
 };
 
 // Inclusión de los métodos inline
@@ -56,6 +56,8 @@ inline void TextEntity::setTextColor(const sf::Color& color)
 {
 	m_text_color = color;
 	m_outline_color.a = color.a;
+	m_colors_valid = false;
+	setDirty();
 }
 
 inline unsigned int TextEntity::getMaxLength(void)
@@ -88,6 +90,8 @@ inline TextEntity::OutlineQuality TextEntity::getOutlineQuality(void) const
 inline void TextEntity::setOutlineQuality(const TextEntity::OutlineQuality quality)
 {
 	m_outline_quality = quality;
+	m_geometry_valid = false;
+	setDirty();
 }
 
 inline const sf::Color& TextEntity::getOutlineColor(void)
@@ -99,6 +103,8 @@ inline void TextEntity::setOutlineColor(const sf::Color& color)
 {
 	m_outline_color = color;
 	m_outline_color.a = m_text_color.a;
+	m_colors_valid = false;
+	setDirty();
 }
 
 inline bool TextEntity::getShadowEnabled(void) const
@@ -109,6 +115,8 @@ inline bool TextEntity::getShadowEnabled(void) const
 inline void TextEntity::setShadowEnabled(const bool enabled)
 {
 	m_shadow_enabled = enabled;
+	m_geometry_valid = false;
+	setDirty();
 }
 
 inline const sf::Color& TextEntity::getShadowColor(void)
@@ -119,6 +127,8 @@ inline const sf::Color& TextEntity::getShadowColor(void)
 inline void TextEntity::setShadowColor(const sf::Color& color)
 {
 	m_shadow_color = color;
+	m_colors_valid = false;
+	setDirty();
 }
 
 inline sf::Vector2i TextEntity::getShadowOffset(void) const
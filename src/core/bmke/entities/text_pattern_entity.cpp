@@ -119,6 +119,7 @@ void TextPatternEntity::setPlatform(Platform* platform)
 		if (m_has_platform)
 		{
 			m_need_parse = true;
+			requestUpdate();
 		}
 	}
 }
@@ -132,6 +133,7 @@ void TextPatternEntity::setGamelist(Gamelist* gamelist)
 		if (m_has_gamelist)
 		{
 			m_need_parse = true;
+			requestUpdate();
 		}
 	}
 }
@@ -145,6 +147,7 @@ void TextPatternEntity::setGame(Game* game)
 		if (m_has_game)
 		{
 			m_need_parse = true;
+			requestUpdate();
 		}
 	}
 }
@@ -156,6 +159,8 @@ void TextPatternEntity::updateCurrent(sf::Time delta_time, const sf::Color& colo
 	{
 		// Solo forzamos el parseo de la cadena si cambió algo de la fecha-hora
 		m_need_parse = updateDateTime() ? true : m_need_parse;
+		// La hora se sigue consultando en cada actualización
+		requestUpdate();
 	}
 	if (m_need_parse)
 	{
@@ -132,6 +132,12 @@ public:
 	 */
 	void setGame(Game* game);
 
+	/**
+	 * Fuerza a volver a generar el texto, para cuando cambian los datos de la
+	 * plataforma, la lista o el juego actuales
+	 */
+	void refresh(void);
+
 protected:
 	/**
 	 * Realiza la actualización real de la entidad
@@ -47,9 +47,16 @@ inline void TextPatternEntity::setString(const Glib::ustring& string)
 	m_pattern = string;
 	m_parser.initFromString(m_pattern);
 	m_need_parse = true;
+	requestUpdate();
 	checkPatterns();
 }
 
+inline void TextPatternEntity::refresh(void)
+{
+	m_need_parse = true;
+	requestUpdate();
+}
+
 inline void TextPatternEntity::drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
 {
 	TextEntity::drawCurrent(target, states);
@@ -86,7 +86,7 @@ void TransitionEntity::setPivot(Pivot pivot)
 void TransitionEntity::setColor(const sf::Color& color)
 {
 	Entity::setColor(color);
-	m_sprite.setColor(color);
+	m_sprite.setColor(getEffectiveColor());
 }
 
 sf::Vector2i TransitionEntity::getSize(void) const
@@ -105,13 +105,28 @@ void TransitionEntity::setTexture(sf::Texture *texture)
 {
 	m_texture = texture;
 	m_sprite.setTexture(*m_texture, true);
+	setDirty();
+	// Forzamos el cálculo del pivote
+	setPivot(m_pivot);
+}
+
+void TransitionEntity::setTexture(sf::Texture *texture, const sf::IntRect& rect)
+{
+	m_texture = texture;
+	m_sprite.setTexture(*m_texture);
+	m_sprite.setTextureRect(rect);
+	setDirty();
 	// Forzamos el cálculo del pivote
 	setPivot(m_pivot);
 }
 
 void TransitionEntity::updateCurrent(sf::Time delta_time, const sf::Color& color)
 {
-	m_sprite.setColor(getColor());
+}
+
+void TransitionEntity::updateColor(const sf::Color& color)
+{
+	m_sprite.setColor(color);
 }
 
 void TransitionEntity::drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
@@ -119,4 +134,24 @@ void TransitionEntity::drawCurrent(sf::RenderTarget& target, sf::RenderStates st
 	target.draw(m_sprite, states);
 }
 
+bool TransitionEntity::batchCurrent(SpriteBatch& batch, const sf::RenderStates& states) const
+{
+	sf::RenderStates sprite_states(states);
+	sf::Vertex vertices[4];
+	sf::IntRect rect;
+
+	if (!m_texture)
+	{
+		return false;
+	}
+	rect = m_sprite.getTextureRect();
+	vertices[0] = sf::Vertex(sf::Vector2f(0.f, 0.f), m_sprite.getColor(), sf::Vector2f(rect.left, rect.top));
+	vertices[1] = sf::Vertex(sf::Vector2f(rect.width, 0.f), m_sprite.getColor(), sf::Vector2f(rect.left + rect.width, rect.top));
+	vertices[2] = sf::Vertex(sf::Vector2f(rect.width, rect.height), m_sprite.getColor(), sf::Vector2f(rect.left + rect.width, rect.top + rect.height));
+	vertices[3] = sf::Vertex(sf::Vector2f(0.f, rect.height), m_sprite.getColor(), sf::Vector2f(rect.left, rect.top + rect.height));
+	sprite_states.texture = m_texture;
+	batch.add(vertices, 4, sprite_states);
+	return true;
+}
+
 } // namespace bmonkey
@@ -77,6 +77,16 @@ public:
 	 */
 	void setTexture(sf::Texture *texture);
 
+	/**
+	 * Establece la región de una textura que dibujará la entidad
+	 * @param texture Textura que contiene la imagen, como una página del
+	 * atlas de texturas
+	 * @param rect Región de la textura a dibujar
+	 * @note Al cambiar la textura, las dimensiones de la entidad se adaptan
+	 * a la región
+	 */
+	void setTexture(sf::Texture *texture, const sf::IntRect& rect);
+
 protected:
 	/**
 	 * Realiza la actualización real de la entidad
@@ -85,6 +95,12 @@ protected:
 	 */
 	virtual void updateCurrent(sf::Time delta_time, const sf::Color& color);
 
+	/**
+	 * Aplica el color efectivo al sprite
+	 * @param color Nuevo color efectivo de la entidad
+	 */
+	virtual void updateColor(const sf::Color& color);
+
 	/**
 	 * Realiza el dibujado real de esta entidad
 	 * @param target Target donde se dibujará la entidad
@@ -93,6 +109,14 @@ protected:
 	 */
 	virtual void drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
 
+	/**
+	 * Añade el quad del sprite a un agrupador
+	 * @param batch Agrupador donde añadir el quad
+	 * @param states States para dibujar la entidad
+	 * @return true si se añadió, false si la entidad no tiene textura
+	 */
+	virtual bool batchCurrent(SpriteBatch& batch, const sf::RenderStates& states) const;
+
 private:
 	sf::Texture* m_texture;		/**< Textura mostrada por la entidad */
 	sf::Sprite m_sprite;		/**< Sprite interno para mostrar la textura */
@@ -21,9 +21,13 @@
 
 #include "entity.hpp"
 #include <cassert>
+#include <cmath>
+#include <algorithm>
 
 namespace bmonkey{
 
+float Entity::m_interpolation = 1.f;
+
 Entity::Entity(void):
 	m_enabled(true),
 	m_status(STARTED),
@@ -32,7 +36,26 @@ Entity::Entity(void):
 	m_start_animation(nullptr),
 	m_position_animation(nullptr),
 	m_current_animation(nullptr),
-	m_parent(nullptr)
+	m_parent(nullptr),
+	m_cached(false),
+	m_cache(nullptr),
+	m_cache_valid(false),
+	m_cache_dirty(true),
+	m_cache_volatile(false),
+	m_effective_color(sf::Color(255, 255, 255, 255)),
+	m_transform_dirty(true),
+	m_color_dirty(true),
+	m_bounds_dirty(true),
+	m_color_changed(true),
+	m_update_requested(true),
+	m_update_pending(true),
+	m_has_previous(false),
+	m_previous_rotation(0.f),
+	m_animating(false),
+	m_interpolated(false),
+	m_world_interpolation(1.f),
+	m_bounds_interpolated(false),
+	m_bounds_interpolation(1.f)
 {
 }
 
@@ -48,6 +71,28 @@ Entity::~Entity(void)
 
 	delete m_start_animation;
 	delete m_position_animation;
+	delete m_cache;
+}
+
+void Entity::setCached(const bool cached)
+{
+	m_cached = cached;
+	m_cache_valid = false;
+	m_cache_dirty = true;
+	// Sin caché no necesitamos mantener la textura
+	if (!m_cached)
+	{
+		delete m_cache;
+		m_cache = nullptr;
+	}
+}
+
+sf::FloatRect Entity::getLocalBounds(void) const
+{
+	sf::Vector2i size;
+
+	size = getSize();
+	return sf::FloatRect(0.f, 0.f, size.x, size.y);
 }
 
 Animation* Entity::getAnimation(Entity::AnimationType type)
@@ -94,6 +139,8 @@ void Entity::removeChild(Entity* entity)
 		{
 			delete (*iter);
 			m_children.erase(iter);
+			invalidateCache();
+			invalidateBounds();
 			return;
 		}
 	}
@@ -116,7 +163,7 @@ void Entity::run(void)
 	{
 		m_current_animation->run();
 	}
-
+	requestUpdate();
 }
 
 void Entity::stop(void)
@@ -129,11 +176,26 @@ void Entity::stop(void)
 	m_current_animation = nullptr;
 }
 
-void Entity::update(sf::Time delta_time, const sf::Color& color)
+void Entity::update(sf::Time delta_time)
 {
-	// Solo actualizamos si la entidad está habilitada y en ejecución
-	if (m_enabled && m_status == STARTED)
+	// Los subárboles sin nada pendiente no se recorren
+	if (!m_update_pending)
+	{
+		return;
+	}
+	m_update_pending = false;
+	// Los descendientes que sigan cambiando en cada frame lo vuelven a marcar
+	m_cache_volatile = false;
+	// Solo actualizamos si la entidad está habilitada y en ejecución. La
+	// petición se conserva hasta que se habilite o se ejecute de nuevo
+	if (!m_enabled || (m_status != STARTED))
 	{
+		return;
+	}
+	if (m_update_requested)
+	{
+		m_update_requested = false;
+		savePreviousTransform();
 		// Comprobamos si es necesario avanzar a la siguiente animación
 		if (m_current_animation && m_current_animation == m_start_animation && m_current_animation->isFinished())
 		{
@@ -143,43 +205,474 @@ void Entity::update(sf::Time delta_time, const sf::Color& color)
 				m_current_animation->run();
 			}
 		}
-		// Si hay animación la actualizamos
+		// Si hay animación la actualizamos. Sólo sus cambios se interpolan
 		if (m_current_animation)
 		{
+			m_animating = true;
 			m_current_animation->update(delta_time);
+			m_animating = false;
+		}
+		if (m_color_changed)
+		{
+			m_color_changed = false;
+			updateColor(getEffectiveColor());
+		}
+		updateCurrent(delta_time, getEffectiveColor());
+		// Seguimos actualizando mientras haya animación o la entidad se haya
+		// movido, para que el estado anterior alcance al actual
+		if ((m_current_animation && (!m_current_animation->isFinished() ||
+			((m_current_animation == m_start_animation) && m_position_animation))) || isMoving())
+		{
+			requestUpdate();
+		}
+		// La interpolación y los shaders cambian el dibujado en cada frame, así
+		// que las cachés que la contienen no se pueden aprovechar. Con shader
+		// seguimos actualizando para renovar la marca mientras lo tenga
+		if (isMoving())
+		{
+			markCacheVolatile();
+		}
+		else if (m_current_animation && m_current_animation->getShader())
+		{
+			markCacheVolatile();
+			requestUpdate();
 		}
-		updateCurrent(delta_time, color);
-		updateChildren(delta_time, color);
 	}
+	updateChildren(delta_time);
 }
 
-void Entity::updateChildren(sf::Time delta_time, const sf::Color& color)
+void Entity::updateChildren(sf::Time delta_time)
 {
 	std::vector<Entity* >::iterator iter;
 
 	for (iter = m_children.begin(); iter != m_children.end(); ++iter)
 	{
-		(*iter)->update(delta_time, color);
+		if ((*iter)->m_update_pending)
+		{
+			(*iter)->update(delta_time);
+		}
 	}
 }
 
-void Entity::draw(sf::RenderTarget& target, sf::RenderStates states) const
+void Entity::updateColor(const sf::Color& color)
 {
-	std::vector<Entity* >::const_iterator iter;
+}
 
+void Entity::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
 	// Solo dibujamos si está habilitada
 	if (m_enabled)
 	{
-		states.transform *= getTransform();
 		if (m_current_animation)
 		{
 			states.shader = m_current_animation->getShader();
 		}
-		drawCurrent(target, states);
+		// Si todo el subárbol queda fuera de la vista no hay nada que dibujar
+		if (isSubtreeCulled(target, states.transform))
+		{
+			return;
+		}
+		if (!m_cached || !drawCached(target, states))
+		{
+			drawSubtree(target, states);
+		}
+	}
+}
+
+void Entity::drawBatched(SpriteBatch& batch, sf::RenderStates states) const
+{
+	std::vector<Entity* >::const_iterator iter;
+	sf::RenderStates node_states;
+
+	// Solo dibujamos si está habilitada
+	if (!m_enabled)
+	{
+		return;
+	}
+	if (m_current_animation)
+	{
+		states.shader = m_current_animation->getShader();
+	}
+	// Si todo el subárbol queda fuera de la vista no hay nada que dibujar
+	if (isSubtreeCulled(*batch.getTarget(), states.transform))
+	{
+		return;
+	}
+	node_states = states;
+	node_states.transform *= getWorldTransform();
+	// La caché se dibuja directamente, tras lo que haya pendiente
+	if (m_cached)
+	{
+		batch.flush();
+		if (drawCached(*batch.getTarget(), states))
+		{
+			return;
+		}
+	}
+	// Las entidades con shader no se pueden agrupar
+	if (!isCulled(*batch.getTarget(), node_states.transform) && (states.shader || !batchCurrent(batch, node_states)))
+	{
+		batch.flush();
+		drawCurrent(*batch.getTarget(), node_states);
+	}
+
+	for (iter = m_children.begin(); iter != m_children.end(); ++iter)
+	{
+		(*iter)->drawBatched(batch, states);
+	}
+}
+
+bool Entity::isCulled(const sf::RenderTarget& target, const sf::Transform& transform) const
+{
+	return !getViewBounds(target).intersects(transform.transformRect(getLocalBounds()));
+}
+
+bool Entity::isSubtreeCulled(const sf::RenderTarget& target, const sf::Transform& transform) const
+{
+	// Sin hijos, basta con la comprobación de la propia entidad al dibujarla
+	if (m_children.empty())
+	{
+		return false;
+	}
+	return !getViewBounds(target).intersects(transform.transformRect(getSubtreeBounds()));
+}
+
+const sf::Transform& Entity::getWorldTransform(void) const
+{
+	// Si la entidad o algún antecesor se mueve, depende de la interpolación
+	if (m_transform_dirty || (m_interpolated && (m_world_interpolation != m_interpolation)))
+	{
+		m_world_transform = m_parent ? m_parent->getWorldTransform() : sf::Transform::Identity;
+		m_world_transform *= getInterpolatedTransform();
+		m_interpolated = (m_parent && m_parent->m_interpolated) || isMoving();
+		m_world_interpolation = m_interpolation;
+		m_transform_dirty = false;
+	}
+	return m_world_transform;
+}
+
+const sf::Color& Entity::getEffectiveColor(void) const
+{
+	if (m_color_dirty)
+	{
+		m_effective_color = m_parent ? m_parent->getEffectiveColor() * m_color : m_color;
+		m_color_dirty = false;
+	}
+	return m_effective_color;
+}
+
+const sf::FloatRect& Entity::getSubtreeBounds(void) const
+{
+	std::vector<Entity* >::const_iterator iter;
+	sf::FloatRect rect;
+	float right;
+	float bottom;
+
+	if (m_bounds_dirty || (m_bounds_interpolated && (m_bounds_interpolation != m_interpolation)))
+	{
+		m_subtree_bounds = getWorldTransform().transformRect(getLocalBounds());
+		m_bounds_interpolated = m_interpolated;
+		for (iter = m_children.begin(); iter != m_children.end(); ++iter)
+		{
+			if ((*iter)->m_enabled)
+			{
+				rect = (*iter)->getSubtreeBounds();
+				m_bounds_interpolated = m_bounds_interpolated || (*iter)->m_bounds_interpolated;
+				right = std::max(m_subtree_bounds.left + m_subtree_bounds.width, rect.left + rect.width);
+				bottom = std::max(m_subtree_bounds.top + m_subtree_bounds.height, rect.top + rect.height);
+				m_subtree_bounds.left = std::min(m_subtree_bounds.left, rect.left);
+				m_subtree_bounds.top = std::min(m_subtree_bounds.top, rect.top);
+				m_subtree_bounds.width = right - m_subtree_bounds.left;
+				m_subtree_bounds.height = bottom - m_subtree_bounds.top;
+			}
+		}
+		m_bounds_interpolation = m_interpolation;
+		m_bounds_dirty = false;
+	}
+	return m_subtree_bounds;
+}
+
+void Entity::invalidateTransform(void)
+{
+	markTransformDirty();
+	invalidateBounds();
+	// La transformación de la propia entidad se aplica al dibujar su caché,
+	// sólo cambian las de sus antecesores
+	if (m_parent)
+	{
+		m_parent->invalidateCache();
+	}
+}
+
+void Entity::markTransformDirty(void)
+{
+	std::vector<Entity* >::iterator iter;
+
+	// Si ya estaba marcada, también lo están todos sus descendientes
+	if (!m_transform_dirty)
+	{
+		m_transform_dirty = true;
+		m_bounds_dirty = true;
+		for (iter = m_children.begin(); iter != m_children.end(); ++iter)
+		{
+			(*iter)->markTransformDirty();
+		}
+	}
+}
+
+void Entity::invalidateColor(void)
+{
+	markColorDirty();
+	invalidateCache();
+}
 
+void Entity::markColorDirty(void)
+{
+	std::vector<Entity* >::iterator iter;
+
+	// Si ya estaba marcada, también lo están todos sus descendientes
+	if (!m_color_dirty)
+	{
+		m_color_dirty = true;
+		m_color_changed = true;
+		m_cache_dirty = true;
+		requestUpdate();
 		for (iter = m_children.begin(); iter != m_children.end(); ++iter)
 		{
-			(*iter)->draw(target, states);
+			(*iter)->markColorDirty();
+		}
+	}
+}
+
+void Entity::invalidateCache(void)
+{
+	Entity* entity;
+
+	// Las cachés anidadas contienen también el subárbol
+	for (entity = this; entity; entity = entity->m_parent)
+	{
+		entity->m_cache_dirty = true;
+	}
+}
+
+void Entity::markCacheVolatile(void)
+{
+	Entity* entity;
+
+	for (entity = m_parent; entity; entity = entity->m_parent)
+	{
+		entity->m_cache_volatile = true;
+	}
+}
+
+void Entity::savePreviousTransform(void)
+{
+	m_previous_position = getPosition();
+	m_previous_rotation = getRotation();
+	m_previous_scale = getScale();
+	m_previous_origin = getOrigin();
+	m_has_previous = true;
+	// Si se estaba moviendo, ahora el estado anterior coincide con el actual
+	if (m_interpolated)
+	{
+		invalidateTransform();
+	}
+}
+
+bool Entity::isMoving(void) const
+{
+	return m_has_previous && ((m_previous_position != getPosition()) || (m_previous_rotation != getRotation()) ||
+		(m_previous_scale != getScale()) || (m_previous_origin != getOrigin()));
+}
+
+sf::Transform Entity::getInterpolatedTransform(void) const
+{
+	sf::Vector2f position;
+	sf::Vector2f scale;
+	sf::Vector2f origin;
+	float rotation;
+	float angle;
+	float cosine;
+	float sine;
+
+	if (!m_has_previous || (m_interpolation >= 1.f))
+	{
+		return getTransform();
+	}
+
+	position = m_previous_position + (getPosition() - m_previous_position) * m_interpolation;
+	scale = m_previous_scale + (getScale() - m_previous_scale) * m_interpolation;
+	origin = m_previous_origin + (getOrigin() - m_previous_origin) * m_interpolation;
+	// La rotación se interpola por el camino más corto
+	rotation = std::fmod(getRotation() - m_previous_rotation + 540.f, 360.f) - 180.f;
+	rotation = m_previous_rotation + rotation * m_interpolation;
+
+	// Misma composición que sf::Transformable::getTransform
+	angle = -rotation * 3.141592654f / 180.f;
+	cosine = std::cos(angle);
+	sine = std::sin(angle);
+	return sf::Transform(scale.x * cosine, scale.y * sine, -origin.x * scale.x * cosine - origin.y * scale.y * sine + position.x,
+		-scale.x * sine, scale.y * cosine, origin.x * scale.x * sine - origin.y * scale.y * cosine + position.y,
+		0.f, 0.f, 1.f);
+}
+
+void Entity::invalidateBounds(void)
+{
+	Entity* entity;
+
+	// La caja de cada antecesor incluye la de esta entidad
+	for (entity = this; entity; entity = entity->m_parent)
+	{
+		entity->m_bounds_dirty = true;
+	}
+}
+
+sf::FloatRect Entity::getViewBounds(const sf::RenderTarget& target)
+{
+	// La inversa de la vista lleva el rectángulo normalizado del target a
+	// coordenadas de la escena, teniendo en cuenta su rotación
+	return target.getView().getInverseTransform().transformRect(sf::FloatRect(-1.f, -1.f, 2.f, 2.f));
+}
+
+bool Entity::batchCurrent(SpriteBatch& batch, const sf::RenderStates& states) const
+{
+	return false;
+}
+
+void Entity::drawSubtree(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	std::vector<Entity* >::const_iterator iter;
+	sf::RenderStates node_states;
+
+	// Los hijos reciben los states base, ya que aplican su propia
+	// transformación global
+	node_states = states;
+	node_states.transform *= getWorldTransform();
+	if (!isCulled(target, node_states.transform))
+	{
+		drawCurrent(target, node_states);
+	}
+
+	for (iter = m_children.begin(); iter != m_children.end(); ++iter)
+	{
+		(*iter)->draw(target, states);
+	}
+}
+
+bool Entity::drawCached(sf::RenderTarget& target, sf::RenderStates states) const
+{
+// Los modos de mezcla con factores separados para el alfa aparecieron en
+// SFML 2.3, sin ellos la caché no puede componer bien las transparencias
+#if (SFML_VERSION_MAJOR > 2) || ((SFML_VERSION_MAJOR == 2) && (SFML_VERSION_MINOR >= 3))
+	sf::RenderStates cache_states;
+	sf::FloatRect bounds;
+	sf::Vector2u size;
+	sf::Sprite sprite;
+	bool found = false;
+
+	// Los shaders de las animaciones pueden cambiar en cada frame
+	if (states.shader)
+	{
+		m_cache_valid = false;
+		return false;
+	}
+	// Mientras el subárbol cambie, lo dibujamos de forma normal
+	if (m_cache_dirty || m_cache_volatile)
+	{
+		m_cache_dirty = false;
+		m_cache_valid = false;
+		return false;
+	}
+
+	if (!m_cache_valid)
+	{
+		addSubtreeBounds(sf::Transform::Identity, bounds, found);
+		m_cache_rect.left = std::floor(bounds.left);
+		m_cache_rect.top = std::floor(bounds.top);
+		m_cache_rect.width = std::ceil(bounds.left + bounds.width) - m_cache_rect.left;
+		m_cache_rect.height = std::ceil(bounds.top + bounds.height) - m_cache_rect.top;
+		if (!found || (m_cache_rect.width <= 0) || (m_cache_rect.height <= 0))
+		{
+			m_cache_rect = sf::IntRect(0, 0, 0, 0);
+			m_cache_valid = true;
+			return true;
+		}
+
+		// Sólo recreamos la textura si el subárbol ya no cabe en ella
+		if (!m_cache)
+		{
+			m_cache = new sf::RenderTexture();
+		}
+		size = m_cache->getSize();
+		if ((size.x < static_cast<unsigned int>(m_cache_rect.width)) || (size.y < static_cast<unsigned int>(m_cache_rect.height)))
+		{
+			if (!m_cache->create(std::max(size.x, static_cast<unsigned int>(m_cache_rect.width)), std::max(size.y, static_cast<unsigned int>(m_cache_rect.height))))
+			{
+				LOG_ERROR("Entity: Can't create the cache texture for \"" << m_name << "\"");
+				delete m_cache;
+				m_cache = nullptr;
+				return false;
+			}
+			m_cache->setSmooth(true);
+		}
+
+		// La caché guarda los colores premultiplicados por su alfa, para que
+		// las zonas semitransparentes se compongan igual que sin caché
+		m_cache->clear(sf::Color::Transparent);
+		// Deshacemos la transformación global de la entidad, que se aplica al
+		// dibujar la caché
+		cache_states.transform.translate(-m_cache_rect.left, -m_cache_rect.top);
+		cache_states.transform *= getWorldTransform().getInverse();
+		cache_states.blendMode = sf::BlendMode(sf::BlendMode::SrcAlpha, sf::BlendMode::OneMinusSrcAlpha, sf::BlendMode::Add,
+			sf::BlendMode::One, sf::BlendMode::OneMinusSrcAlpha, sf::BlendMode::Add);
+		drawSubtree(*m_cache, cache_states);
+		m_cache->display();
+		m_cache_valid = true;
+	}
+
+	if ((m_cache_rect.width > 0) && (m_cache_rect.height > 0))
+	{
+		sprite.setTexture(m_cache->getTexture());
+		sprite.setTextureRect(sf::IntRect(0, 0, m_cache_rect.width, m_cache_rect.height));
+		sprite.setPosition(m_cache_rect.left, m_cache_rect.top);
+		states.transform *= getWorldTransform();
+		states.blendMode = sf::BlendMode(sf::BlendMode::One, sf::BlendMode::OneMinusSrcAlpha);
+		target.draw(sprite, states);
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+void Entity::addSubtreeBounds(const sf::Transform& transform, sf::FloatRect& bounds, bool& found) const
+{
+	std::vector<Entity* >::const_iterator iter;
+	sf::FloatRect rect;
+	float right;
+	float bottom;
+
+	rect = transform.transformRect(getLocalBounds());
+	if (!found)
+	{
+		bounds = rect;
+		found = true;
+	}
+	else
+	{
+		right = std::max(bounds.left + bounds.width, rect.left + rect.width);
+		bottom = std::max(bounds.top + bounds.height, rect.top + rect.height);
+		bounds.left = std::min(bounds.left, rect.left);
+		bounds.top = std::min(bounds.top, rect.top);
+		bounds.width = right - bounds.left;
+		bounds.height = bottom - bounds.top;
+	}
+
+	for (iter = m_children.begin(); iter != m_children.end(); ++iter)
+	{
+		if ((*iter)->m_enabled)
+		{
+			(*iter)->addSubtreeBounds(transform * (*iter)->getTransform(), bounds, found);
 		}
 	}
 }
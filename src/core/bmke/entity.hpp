@@ -27,6 +27,7 @@
 #include <glibmm/ustring.h>
 #include "../../defines.hpp"
 #include "animation.hpp"
+#include "sprite_batch.hpp"
 
 namespace bmonkey{
 
@@ -48,6 +49,18 @@ typedef sf::Vector2<bool> Vector2b;
  * ejecutan secuencialmente en orden:
  * - Start: Animación que se ejecuta para posicionar la entidad en su lugar
  * - Position: Animación que se ejecuta mientras que la entidad esté en su lugar
+ * Una entidad se puede marcar como cacheada para que dibuje su subárbol en una
+ * textura y en los frames siguientes lo dibuje con un único quad. La textura
+ * se regenera cuando cambia el contenido, la transformación, el color o la
+ * visibilidad de alguna entidad del subárbol, que lo marcan en sus
+ * antecesores. Mientras el subárbol está cambiando se dibuja de forma normal,
+ * y sólo se vuelve a cachear cuando se mantiene estable entre dos frames.
+ * Al dibujar, las entidades y subárboles que quedan fuera de la vista del
+ * target se descartan sin llegar a dibujarse.
+ * Al actualizar sólo se recorren los subárboles con alguna entidad que lo
+ * necesite: con una animación en curso, que se ha movido en la última
+ * actualización, cuyo color ha cambiado o que lo ha solicitado con
+ * requestUpdate.
  */
 class Entity : public sf::Drawable, public sf::Transformable
 {
@@ -145,6 +158,36 @@ public:
 	 */
 	virtual void setColor(const sf::Color& color);
 
+	/**
+	 * Indica si la entidad guarda el dibujado de su subárbol en una textura
+	 * @return true si la entidad está cacheada, false en otro caso
+	 */
+	bool isCached(void) const;
+
+	/**
+	 * Establece si la entidad guarda el dibujado de su subárbol en una textura
+	 * @param cached Nuevo valor para el cacheado
+	 * @note Sólo tiene efecto con SFML 2.3 o superior
+	 */
+	void setCached(const bool cached);
+
+	/**
+	 * Indica que el contenido de la entidad ha cambiado, para que se regeneren
+	 * las cachés de las entidades que la contienen
+	 * @note Los cambios de transformación, color y visibilidad ya marcan las
+	 * cachés sin necesidad de llamar a este método
+	 */
+	void setDirty(void);
+
+	/**
+	 * Obtiene el color efectivo de la entidad, resultado de combinar su color
+	 * con el de todos sus antecesores
+	 * @return Color efectivo de la entidad
+	 * @note Se guarda entre llamadas y sólo se recalcula cuando cambia el color
+	 * de la entidad o de alguno de sus antecesores
+	 */
+	const sf::Color& getEffectiveColor(void) const;
+
 	/**
 	 * Obtiene la opacidad definida en la entidad
 	 * @return Opacidad actual de la entidad
@@ -177,6 +220,121 @@ public:
 	 */
 	virtual sf::Vector2i getSize(void) const = 0;
 
+	/**
+	 * Obtiene la caja que ocupa el dibujado de la entidad en sus coordenadas
+	 * locales, sin contar sus hijos
+	 * @return Caja local de la entidad
+	 */
+	virtual sf::FloatRect getLocalBounds(void) const;
+
+	/**
+	 * Obtiene la transformación global de la entidad, resultado de combinar la
+	 * suya con la de todos sus antecesores
+	 * @return Transformación global de la entidad
+	 * @note Se guarda entre llamadas y sólo se recalcula cuando cambia la
+	 * transformación de la entidad o de alguno de sus antecesores, o cuando
+	 * cambia la interpolación y la entidad se está moviendo
+	 */
+	const sf::Transform& getWorldTransform(void) const;
+
+	/**
+	 * Establece el punto entre las dos últimas actualizaciones en el que se
+	 * dibujan las entidades
+	 * @param interpolation Fracción entre 0 (estado anterior a la última
+	 * actualización) y 1 (estado actual)
+	 * @note Permite que el movimiento sea suave aunque el número de frames no
+	 * coincida con el de actualizaciones fijas
+	 */
+	static void setInterpolation(const float interpolation);
+
+	/**
+	 * Obtiene el punto entre las dos últimas actualizaciones en el que se
+	 * dibujan las entidades
+	 * @return Fracción entre 0 y 1
+	 */
+	static float getInterpolation(void);
+
+	/**
+	 * Establece la posición de la entidad
+	 * @param x Nueva posición en el eje x
+	 * @param y Nueva posición en el eje y
+	 * @note Ocultan a los métodos de sf::Transformable para poder invalidar la
+	 * transformación global, al igual que el resto de modificadores
+	 * @note Sólo se interpolan los cambios realizados por las animaciones; el
+	 * resto, como el origen al recolocar el pivote, se aplican directamente
+	 */
+	void setPosition(const float x, const float y);
+
+	/**
+	 * Establece la posición de la entidad
+	 * @param position Nueva posición
+	 */
+	void setPosition(const sf::Vector2f& position);
+
+	/**
+	 * Establece la rotación de la entidad
+	 * @param angle Nuevo ángulo de rotación en grados
+	 */
+	void setRotation(const float angle);
+
+	/**
+	 * Establece la escala de la entidad
+	 * @param factor_x Nuevo factor de escala en el eje x
+	 * @param factor_y Nuevo factor de escala en el eje y
+	 */
+	void setScale(const float factor_x, const float factor_y);
+
+	/**
+	 * Establece la escala de la entidad
+	 * @param factors Nuevos factores de escala
+	 */
+	void setScale(const sf::Vector2f& factors);
+
+	/**
+	 * Establece el origen local de las transformaciones de la entidad
+	 * @param x Nueva coordenada x del origen
+	 * @param y Nueva coordenada y del origen
+	 */
+	void setOrigin(const float x, const float y);
+
+	/**
+	 * Establece el origen local de las transformaciones de la entidad
+	 * @param origin Nuevo origen
+	 */
+	void setOrigin(const sf::Vector2f& origin);
+
+	/**
+	 * Desplaza la entidad respecto a su posición actual
+	 * @param offset_x Desplazamiento en el eje x
+	 * @param offset_y Desplazamiento en el eje y
+	 */
+	void move(const float offset_x, const float offset_y);
+
+	/**
+	 * Desplaza la entidad respecto a su posición actual
+	 * @param offset Desplazamiento
+	 */
+	void move(const sf::Vector2f& offset);
+
+	/**
+	 * Rota la entidad respecto a su rotación actual
+	 * @param angle Ángulo a añadir en grados
+	 */
+	void rotate(const float angle);
+
+	/**
+	 * Escala la entidad respecto a su escala actual
+	 * @param factor_x Factor a aplicar en el eje x
+	 * @param factor_y Factor a aplicar en el eje y
+	 */
+	void scale(const float factor_x, const float factor_y);
+
+	/**
+	 * Escala la entidad respecto a su escala actual
+	 * @param factor Factores a aplicar
+	 */
+	void scale(const sf::Vector2f& factor);
+
 	/**
 	 * Obtiene la entidad padre
 	 * @return Entidad padre o null si no es una entidad padre
@@ -212,9 +370,19 @@ public:
 	/**
 	 * Actualiza el estado de la entidad
 	 * @param delta_time Tiempo transcurrido desde la última actualización
+	 * @note No hace nada si ni la entidad ni sus descendientes lo necesitan
 	 */
 	void update(sf::Time delta_time);
 
+	/**
+	 * Dibuja la entidad y sus hijos a través de un agrupador de quads
+	 * @param batch Agrupador donde se añaden los quads de las entidades
+	 * @param states States para dibujar la entidad
+	 * @note Las entidades que no pueden aportar sus quads se dibujan
+	 * directamente en el target del agrupador, tras vaciarlo
+	 */
+	void drawBatched(SpriteBatch& batch, sf::RenderStates states = sf::RenderStates::Default) const;
+
 	/**
 	 * Comienza la ejecución de la entidad desde su punto inicial
 	 */
@@ -227,25 +395,33 @@ public:
 
 protected:
 	/**
-	 * Actualiza el estado de la entidad incluyendo un color de referencia
+	 * Realiza la actualización real de la entidad
 	 * @param delta_time Tiempo transcurrido desde la última actualización
-	 * @param color Color de referencia para actualizar la entidad
+	 * @param color Color efectivo de la entidad, ya combinado con el de sus
+	 * antecesores
+	 */
+	virtual void updateCurrent(sf::Time delta_time, const sf::Color& color) = 0;
+
+	/**
+	 * Aplica el color efectivo a los elementos de la entidad
+	 * @param color Nuevo color efectivo de la entidad
+	 * @note Sólo se llama al actualizar la entidad tras cambiar el color de la
+	 * entidad o de alguno de sus antecesores
 	 */
-	void update(sf::Time delta_time, const sf::Color& color);
+	virtual void updateColor(const sf::Color& color);
 
 	/**
-	 * Realiza la actualización real de la entidad
-	 * @param delta_time Tiempo transcurrido desde la última actualización
-	 * @param color Color de referencia para actualizar la entidad
+	 * Solicita que la entidad se actualice en la siguiente actualización
+	 * @note Las entidades que necesitan actualizarse de forma continua deben
+	 * volver a solicitarlo en cada updateCurrent
 	 */
-	virtual void updateCurrent(sf::Time delta_time, const sf::Color& color) = 0;
+	void requestUpdate(void);
 
 	/**
 	 * Actualiza las entidades hijas de la actual
 	 * @param delta_time Tiempo transcurrido desde la última actualización
-	 * @param color Color de referencia para actualizar las entidades
 	 */
-	void updateChildren(sf::Time delta_time, const sf::Color& color);
+	void updateChildren(sf::Time delta_time);
 
 	/**
 	 * Implementación de drawable
@@ -262,6 +438,144 @@ protected:
 	 */
 	virtual void drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const = 0;
 
+	/**
+	 * Añade los quads de esta entidad a un agrupador, en lugar de dibujarla
+	 * @param batch Agrupador donde añadir los quads
+	 * @param states States para dibujar la entidad
+	 * @return true si la entidad se añadió al agrupador, false si hay que
+	 * dibujarla con drawCurrent
+	 */
+	virtual bool batchCurrent(SpriteBatch& batch, const sf::RenderStates& states) const;
+
+	/**
+	 * Dibuja la entidad y sus hijos sin pasar por la caché
+	 * @param target Target donde se dibujará la entidad
+	 * @param states States para dibujar la entidad, con su transformación ya
+	 * aplicada
+	 */
+	void drawSubtree(sf::RenderTarget& target, sf::RenderStates states) const;
+
+	/**
+	 * Dibuja el subárbol desde la caché, regenerándola si es necesario
+	 * @param target Target donde se dibujará la entidad
+	 * @param states States para dibujar la entidad, con su transformación ya
+	 * aplicada
+	 * @return true si se dibujó desde la caché, false si hay que dibujar el
+	 * subárbol de forma normal
+	 */
+	bool drawCached(sf::RenderTarget& target, sf::RenderStates states) const;
+
+	/**
+	 * Obtiene la caja que ocupa el dibujado de la entidad y sus hijos, con sus
+	 * transformaciones globales
+	 * @return Caja del subárbol
+	 * @note Se guarda entre llamadas y sólo se recalcula cuando cambia la
+	 * transformación, el contenido o la visibilidad de alguna entidad del
+	 * subárbol
+	 */
+	const sf::FloatRect& getSubtreeBounds(void) const;
+
+	/**
+	 * Indica si el dibujado de la entidad, sin sus hijos, queda fuera de la
+	 * vista del target
+	 * @param target Target donde se dibujará la entidad
+	 * @param transform Transformación completa de la entidad
+	 * @return true si la entidad no es visible, false en otro caso
+	 */
+	bool isCulled(const sf::RenderTarget& target, const sf::Transform& transform) const;
+
+	/**
+	 * Indica si el dibujado de la entidad y todos sus hijos queda fuera de la
+	 * vista del target
+	 * @param target Target donde se dibujará la entidad
+	 * @param transform Transformación base sobre la que se aplica la global de
+	 * la entidad
+	 * @return true si ninguna entidad del subárbol es visible, false en otro
+	 * caso
+	 * @note Para entidades sin hijos siempre devuelve false, ya que se
+	 * comprueban al dibujarlas con isCulled
+	 */
+	bool isSubtreeCulled(const sf::RenderTarget& target, const sf::Transform& transform) const;
+
+	/**
+	 * Obtiene la región de la escena visible en un target
+	 * @param target Target a consultar
+	 * @return Caja de la región visible en coordenadas de la escena
+	 */
+	static sf::FloatRect getViewBounds(const sf::RenderTarget& target);
+
+	/**
+	 * Añade a una caja la que ocupa el dibujado de la entidad y sus hijos
+	 * @param transform Transformación a aplicar a la entidad
+	 * @param bounds Caja a ampliar
+	 * @param found Indica si la caja ya contiene algo, se actualiza
+	 */
+	void addSubtreeBounds(const sf::Transform& transform, sf::FloatRect& bounds, bool& found) const;
+
+	/**
+	 * Marca la transformación global de la entidad y de sus descendientes
+	 * para que se recalcule, junto con las cajas afectadas
+	 */
+	void invalidateTransform(void);
+
+	/**
+	 * Marca la transformación global de la entidad y de sus descendientes
+	 * para que se recalcule
+	 */
+	void markTransformDirty(void);
+
+	/**
+	 * Marca el color efectivo de la entidad y de sus descendientes para que
+	 * se recalcule y se aplique en la siguiente actualización
+	 */
+	void invalidateColor(void);
+
+	/**
+	 * Marca el color efectivo de la entidad y de sus descendientes para que
+	 * se recalcule
+	 */
+	void markColorDirty(void);
+
+	/**
+	 * Marca la caché de la entidad y las de sus antecesores para que se
+	 * regeneren
+	 */
+	void invalidateCache(void);
+
+	/**
+	 * Marca las cachés de los antecesores como no aprovechables hasta la
+	 * siguiente actualización, porque el subárbol cambia en cada frame
+	 */
+	void markCacheVolatile(void);
+
+	/**
+	 * Marca la caja del subárbol de la entidad y de sus antecesores para que
+	 * se recalcule
+	 */
+	void invalidateBounds(void);
+
+	/**
+	 * Guarda la transformación actual como la anterior a la actualización en
+	 * curso
+	 */
+	void savePreviousTransform(void);
+
+	/**
+	 * Indica si la transformación ha cambiado en la última actualización
+	 * @return true si difiere de la anterior a la actualización, false en
+	 * otro caso
+	 */
+	bool isMoving(void) const;
+
+	/**
+	 * Obtiene la transformación local de la entidad interpolada entre la
+	 * anterior a la última actualización y la actual
+	 * @return Transformación local interpolada
+	 */
+	sf::Transform getInterpolatedTransform(void) const;
+
+	static float m_interpolation;	/**< Punto de dibujado entre las dos últimas actualizaciones */
+
 	Glib::ustring m_name;			/**< Nombre de esta entidad */
 	bool m_enabled;					/**< Indica si la entidad está habilitada */
 	Status m_status;				/**< Estado en el que se encuentra */
@@ -272,6 +586,31 @@ protected:
 	Animation* m_current_animation;	/**< Efecto en ejecución */
 	Entity* m_parent;				/**< Padre de la entidad en una cadena */
 	std::vector<Entity* > m_children; /**< Hijos de la entidad */
+	bool m_cached;					/**< Indica si el subárbol se dibuja desde una textura */
+	mutable sf::RenderTexture* m_cache;	/**< Textura con el dibujado del subárbol */
+	mutable sf::IntRect m_cache_rect;	/**< Región local que ocupa el subárbol en la caché */
+	mutable bool m_cache_valid;		/**< Indica si la caché corresponde al subárbol actual */
+	mutable bool m_cache_dirty;		/**< Indica si el subárbol ha cambiado desde el último frame */
+	bool m_cache_volatile;			/**< Indica si el subárbol cambia en cada frame hasta la siguiente actualización */
+	mutable sf::Transform m_world_transform;	/**< Transformación global de la entidad */
+	mutable sf::Color m_effective_color;	/**< Color combinado con el de los antecesores */
+	mutable sf::FloatRect m_subtree_bounds;	/**< Caja global del subárbol */
+	mutable bool m_transform_dirty;	/**< Indica si hay que recalcular la transformación global */
+	mutable bool m_color_dirty;		/**< Indica si hay que recalcular el color efectivo */
+	mutable bool m_bounds_dirty;	/**< Indica si hay que recalcular la caja del subárbol */
+	bool m_color_changed;			/**< Indica si hay que aplicar el color efectivo al actualizar */
+	bool m_update_requested;		/**< Indica si la entidad necesita actualizarse */
+	bool m_update_pending;			/**< Indica si la entidad o algún descendiente necesita actualizarse */
+	bool m_has_previous;			/**< Indica si se ha guardado la transformación anterior */
+	sf::Vector2f m_previous_position;	/**< Posición antes de la última actualización */
+	float m_previous_rotation;		/**< Rotación antes de la última actualización */
+	sf::Vector2f m_previous_scale;	/**< Escala antes de la última actualización */
+	sf::Vector2f m_previous_origin;	/**< Origen antes de la última actualización */
+	bool m_animating;				/**< Indica si la animación en curso está actualizando la entidad */
+	mutable bool m_interpolated;	/**< Indica si la transformación global depende de la interpolación */
+	mutable float m_world_interpolation;	/**< Interpolación usada en la transformación global */
+	mutable bool m_bounds_interpolated;	/**< Indica si la caja del subárbol depende de la interpolación */
+	mutable float m_bounds_interpolation;	/**< Interpolación usada en la caja del subárbol */
 };
 
 // Inclusión de los métodos inline
@@ -40,6 +40,14 @@ inline bool Entity::isEnabled(void) const
 inline void Entity::setEnabled(const bool enabled)
 {
 	m_enabled = enabled;
+	// Mientras estaba deshabilitada no se ha actualizado
+	if (m_enabled)
+	{
+		requestUpdate();
+	}
+	// Cambia la caja y la caché de los antecesores
+	invalidateCache();
+	invalidateBounds();
 }
 
 inline Entity::Status Entity::getStatus(void) const
@@ -60,6 +68,19 @@ inline const sf::Color& Entity::getColor(void)
 inline void Entity::setColor(const sf::Color& color)
 {
 	m_color = color;
+	invalidateColor();
+}
+
+inline bool Entity::isCached(void) const
+{
+	return m_cached;
+}
+
+inline void Entity::setDirty(void)
+{
+	invalidateCache();
+	// El contenido puede haber cambiado de tamaño
+	invalidateBounds();
 }
 
 inline unsigned char Entity::getOpacity(void) const
@@ -81,6 +102,8 @@ inline Entity* Entity::getParent(void)
 inline void Entity::setParent(Entity* entity)
 {
 	m_parent = entity;
+	invalidateTransform();
+	invalidateColor();
 }
 
 inline void Entity::addChild(Entity* entity)
@@ -88,6 +111,9 @@ inline void Entity::addChild(Entity* entity)
 	assert(entity);
 
 	m_children.push_back(entity);
+	entity->setParent(this);
+	// El nuevo hijo puede tener actualizaciones pendientes
+	entity->requestUpdate();
 }
 
 inline std::vector<Entity* >& Entity::getChildren(void)
@@ -95,9 +121,146 @@ inline std::vector<Entity* >& Entity::getChildren(void)
 	return m_children;
 }
 
-inline void Entity::update(sf::Time delta_time)
+inline void Entity::setInterpolation(const float interpolation)
 {
-	update(delta_time, m_color);
+	m_interpolation = interpolation;
+}
+
+inline float Entity::getInterpolation(void)
+{
+	return m_interpolation;
+}
+
+inline void Entity::setPosition(const float x, const float y)
+{
+	sf::Transformable::setPosition(x, y);
+	if (!m_animating)
+	{
+		m_previous_position = getPosition();
+	}
+	invalidateTransform();
+}
+
+inline void Entity::setPosition(const sf::Vector2f& position)
+{
+	sf::Transformable::setPosition(position);
+	if (!m_animating)
+	{
+		m_previous_position = getPosition();
+	}
+	invalidateTransform();
+}
+
+inline void Entity::setRotation(const float angle)
+{
+	sf::Transformable::setRotation(angle);
+	if (!m_animating)
+	{
+		m_previous_rotation = getRotation();
+	}
+	invalidateTransform();
+}
+
+inline void Entity::setScale(const float factor_x, const float factor_y)
+{
+	sf::Transformable::setScale(factor_x, factor_y);
+	if (!m_animating)
+	{
+		m_previous_scale = getScale();
+	}
+	invalidateTransform();
+}
+
+inline void Entity::setScale(const sf::Vector2f& factors)
+{
+	sf::Transformable::setScale(factors);
+	if (!m_animating)
+	{
+		m_previous_scale = getScale();
+	}
+	invalidateTransform();
+}
+
+inline void Entity::setOrigin(const float x, const float y)
+{
+	sf::Transformable::setOrigin(x, y);
+	if (!m_animating)
+	{
+		m_previous_origin = getOrigin();
+	}
+	invalidateTransform();
+}
+
+inline void Entity::setOrigin(const sf::Vector2f& origin)
+{
+	sf::Transformable::setOrigin(origin);
+	if (!m_animating)
+	{
+		m_previous_origin = getOrigin();
+	}
+	invalidateTransform();
+}
+
+inline void Entity::move(const float offset_x, const float offset_y)
+{
+	sf::Transformable::move(offset_x, offset_y);
+	if (!m_animating)
+	{
+		m_previous_position = getPosition();
+	}
+	invalidateTransform();
+}
+
+inline void Entity::move(const sf::Vector2f& offset)
+{
+	sf::Transformable::move(offset);
+	if (!m_animating)
+	{
+		m_previous_position = getPosition();
+	}
+	invalidateTransform();
+}
+
+inline void Entity::rotate(const float angle)
+{
+	sf::Transformable::rotate(angle);
+	if (!m_animating)
+	{
+		m_previous_rotation = getRotation();
+	}
+	invalidateTransform();
+}
+
+inline void Entity::scale(const float factor_x, const float factor_y)
+{
+	sf::Transformable::scale(factor_x, factor_y);
+	if (!m_animating)
+	{
+		m_previous_scale = getScale();
+	}
+	invalidateTransform();
+}
+
+inline void Entity::scale(const sf::Vector2f& factor)
+{
+	sf::Transformable::scale(factor);
+	if (!m_animating)
+	{
+		m_previous_scale = getScale();
+	}
+	invalidateTransform();
+}
+
+inline void Entity::requestUpdate(void)
+{
+	Entity* entity;
+
+	m_update_requested = true;
+	// Si un antecesor ya estaba marcado, también lo están los siguientes
+	for (entity = this; entity && !entity->m_update_pending; entity = entity->m_parent)
+	{
+		entity->m_update_pending = true;
+	}
 }
 
 #endif // _ENTITY_INL_
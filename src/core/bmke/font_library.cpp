@@ -21,13 +21,19 @@
 
 #include "font_library.hpp"
 #include <cassert>
+#include <algorithm>
 #include <glibmm/miscutils.h>
 #include <glibmm/fileutils.h>
 
+// Caracteres generados en cada bloque al precargar los atlas SDF
+#define FONT_LIBRARY_SDF_BATCH 128
+
 namespace bmonkey{
 
 
-FontLibrary::FontLibrary(void)
+FontLibrary::FontLibrary(void):
+	m_sdf_shader(nullptr),
+	m_sdf_failed(false)
 {
 	LOG_INFO("FontLibrary: Loading default font...");
 	if (!m_system_font.loadFromFile(Glib::build_filename(BMONKEY_FONTS_DIR, BMONKEY_DEFAULT_FONT_FILE)))
@@ -39,12 +45,21 @@ FontLibrary::FontLibrary(void)
 
 FontLibrary::~FontLibrary(void)
 {
+	std::unordered_map<const sf::Font*, SdfFont*>::iterator iter;
+
 	clean();
+	// Los atlas de las fuentes del sistema sólo se liberan aquí
+	for (iter = m_sdf_fonts.begin(); iter != m_sdf_fonts.end(); ++iter)
+	{
+		delete iter->second;
+	}
+	m_sdf_fonts.clear();
+	delete m_sdf_shader;
 }
 
 sf::Font* FontLibrary::loadFont(const Glib::ustring& file)
 {
-	std::vector<Resource >::iterator iter;
+	std::unordered_map<std::string, Resource>::iterator iter;
 	Resource resource;
 
 	if (file.empty())
@@ -53,17 +68,14 @@ sf::Font* FontLibrary::loadFont(const Glib::ustring& file)
 	}
 
 	// Comprobamos si ya tenemos la fuente cargada
-	for (iter = m_fonts.begin(); iter != m_fonts.end(); ++iter)
+	iter = m_fonts.find(file);
+	if (iter != m_fonts.end())
 	{
-		if (iter->file == file)
-		{
-			// Incrementamos contador de referencias
-			++iter->count;
-			return iter->font;
-		}
+		// Incrementamos contador de referencias
+		++iter->second.count;
+		return iter->second.font;
 	}
 	// No encontramos la fuente, tratamos de cargarla
-	resource.file = file;
 	resource.count = 1;
 	resource.font = new sf::Font();
 	// Cargamos la nueva fuente y la almacenamos
@@ -74,7 +86,8 @@ sf::Font* FontLibrary::loadFont(const Glib::ustring& file)
 	}
 	else
 	{
-		m_fonts.push_back(resource);
+		m_fonts[file.raw()] = resource;
+		m_files[resource.font] = file.raw();
 	}
 	return resource.font;
 }
@@ -86,7 +99,8 @@ sf::Font* FontLibrary::getSystemFont(void)
 
 void FontLibrary::deleteFont(sf::Font* font)
 {
-	std::vector<Resource >::iterator iter;
+	std::unordered_map<const sf::Font*, std::string>::iterator file_iter;
+	std::unordered_map<std::string, Resource>::iterator iter;
 
 	if (!font)
 	{
@@ -94,31 +108,231 @@ void FontLibrary::deleteFont(sf::Font* font)
 	}
 
 	// Buscamos la fuente
-	for (iter = m_fonts.begin(); iter != m_fonts.end(); ++iter)
+	file_iter = m_files.find(font);
+	if (file_iter == m_files.end())
+	{
+		return;
+	}
+	iter = m_fonts.find(file_iter->second);
+	// Decrementamos el contador de referencias
+	--iter->second.count;
+	// Si no hay más referencias descargamos la fuente
+	if (iter->second.count == 0)
+	{
+		m_variants.erase(font);
+		deleteSdfFont(font);
+		m_fonts.erase(iter);
+		m_files.erase(file_iter);
+		delete font;
+	}
+}
+
+void FontLibrary::addFontSize(sf::Font* font, const unsigned int size, const bool bold)
+{
+	std::vector<Variant>::iterator iter;
+	Variant variant;
+
+	if (!font || (size == 0))
+	{
+		return;
+	}
+	std::vector<Variant>& variants = m_variants[font];
+	for (iter = variants.begin(); iter != variants.end(); ++iter)
+	{
+		if ((iter->size == size) && (iter->bold == bold))
+		{
+			++iter->count;
+			return;
+		}
+	}
+	variant.size = size;
+	variant.bold = bold;
+	variant.warmed = 0;
+	variant.count = 1;
+	variants.push_back(variant);
+}
+
+void FontLibrary::removeFontSize(sf::Font* font, const unsigned int size, const bool bold)
+{
+	std::unordered_map<sf::Font*, std::vector<Variant> >::iterator font_iter;
+	std::vector<Variant>::iterator iter;
+
+	font_iter = m_variants.find(font);
+	if (font_iter == m_variants.end())
+	{
+		return;
+	}
+	for (iter = font_iter->second.begin(); iter != font_iter->second.end(); ++iter)
 	{
-		if (iter->font == font)
+		if ((iter->size == size) && (iter->bold == bold))
 		{
-			// Decrementamos el contador de referencias
+			// Sin usuarios no tiene sentido seguir precargando el tamaño
 			--iter->count;
-			// Si no hay más referencias descargamos la fuente
 			if (iter->count == 0)
 			{
-				delete iter->font;
-				m_fonts.erase(iter);
+				font_iter->second.erase(iter);
+				if (font_iter->second.empty())
+				{
+					m_variants.erase(font_iter);
+				}
 			}
+			return;
 		}
 	}
 }
 
+void FontLibrary::setGlyphSet(const std::set<sf::Uint32>& glyphs)
+{
+	std::unordered_map<sf::Font*, std::vector<Variant> >::iterator iter;
+	std::vector<Variant>::iterator variant_iter;
+
+	// El conjunto ya viene ordenado y sin repeticiones
+	m_glyphs.assign(glyphs.begin(), glyphs.end());
+
+	// El conjunto ha cambiado, hay que volver a recorrerlo. Los caracteres ya
+	// rasterizados no tienen coste
+	for (iter = m_variants.begin(); iter != m_variants.end(); ++iter)
+	{
+		for (variant_iter = iter->second.begin(); variant_iter != iter->second.end(); ++variant_iter)
+		{
+			variant_iter->warmed = 0;
+		}
+	}
+}
+
+unsigned int FontLibrary::warmUp(const sf::Time time_limit)
+{
+	std::unordered_map<sf::Font*, std::vector<Variant> >::iterator iter;
+	std::vector<Variant>::iterator variant_iter;
+	unsigned int pending = 0;
+	bool expired = false;
+	sf::Clock clock;
+
+	// Los textos SDF no usan las páginas de cada tamaño de la fuente
+	if (getSdfShader())
+	{
+		return warmUpSdf(time_limit);
+	}
+	for (iter = m_variants.begin(); iter != m_variants.end(); ++iter)
+	{
+		for (variant_iter = iter->second.begin(); variant_iter != iter->second.end(); ++variant_iter)
+		{
+			while (!expired && (variant_iter->warmed < m_glyphs.size()))
+			{
+				// getGlyph rasteriza el carácter en la textura de la fuente
+				iter->first->getGlyph(m_glyphs[variant_iter->warmed], variant_iter->size, variant_iter->bold);
+				++variant_iter->warmed;
+				expired = (time_limit != sf::Time::Zero) && (clock.getElapsedTime() >= time_limit);
+			}
+			pending += m_glyphs.size() - variant_iter->warmed;
+		}
+	}
+	return pending;
+}
+
+unsigned int FontLibrary::warmUpSdf(const sf::Time time_limit)
+{
+	std::unordered_map<sf::Font*, std::vector<Variant> >::iterator iter;
+	std::vector<Variant>::iterator variant_iter, previous_iter;
+	sf::String batch;
+	std::size_t end;
+	unsigned int pending = 0;
+	bool expired = false;
+	bool covered;
+	sf::Clock clock;
+
+	for (iter = m_variants.begin(); iter != m_variants.end(); ++iter)
+	{
+		for (variant_iter = iter->second.begin(); variant_iter != iter->second.end(); ++variant_iter)
+		{
+			// El atlas no depende del tamaño, basta una variante por grosor
+			covered = false;
+			for (previous_iter = iter->second.begin(); previous_iter != variant_iter; ++previous_iter)
+			{
+				covered |= (previous_iter->bold == variant_iter->bold);
+			}
+			if (covered)
+			{
+				continue;
+			}
+			while (!expired && (variant_iter->warmed < m_glyphs.size()))
+			{
+				end = std::min<std::size_t>(variant_iter->warmed + FONT_LIBRARY_SDF_BATCH, m_glyphs.size());
+				batch = std::basic_string<sf::Uint32>(m_glyphs.begin() + variant_iter->warmed, m_glyphs.begin() + end);
+				if (!getSdfFont(iter->first)->loadGlyphs(batch, variant_iter->bold))
+				{
+					// Con el atlas lleno no tiene sentido seguir
+					LOG_ERROR("FontLibrary: SDF atlas full, " << m_glyphs.size() - end << " glyphs not preloaded");
+					end = m_glyphs.size();
+				}
+				variant_iter->warmed = end;
+				expired = (time_limit != sf::Time::Zero) && (clock.getElapsedTime() >= time_limit);
+			}
+			pending += m_glyphs.size() - variant_iter->warmed;
+		}
+	}
+	return pending;
+}
+
+SdfFont* FontLibrary::getSdfFont(sf::Font* font)
+{
+	std::unordered_map<const sf::Font*, SdfFont*>::iterator iter;
+	SdfFont* sdf_font;
+
+	if (!font)
+	{
+		return nullptr;
+	}
+	iter = m_sdf_fonts.find(font);
+	if (iter != m_sdf_fonts.end())
+	{
+		return iter->second;
+	}
+	sdf_font = new SdfFont(font);
+	m_sdf_fonts[font] = sdf_font;
+	return sdf_font;
+}
+
+sf::Shader* FontLibrary::getSdfShader(void)
+{
+	// No insistimos si el shader ya falló una vez
+	if (!m_sdf_shader && !m_sdf_failed)
+	{
+		m_sdf_shader = new sf::Shader();
+		if (!SdfFont::loadShader(*m_sdf_shader))
+		{
+			delete m_sdf_shader;
+			m_sdf_shader = nullptr;
+			m_sdf_failed = true;
+		}
+	}
+	return m_sdf_shader;
+}
+
+void FontLibrary::deleteSdfFont(const sf::Font* font)
+{
+	std::unordered_map<const sf::Font*, SdfFont*>::iterator iter;
+
+	iter = m_sdf_fonts.find(font);
+	if (iter != m_sdf_fonts.end())
+	{
+		delete iter->second;
+		m_sdf_fonts.erase(iter);
+	}
+}
+
 void FontLibrary::clean(void)
 {
-	std::vector<Resource >::iterator iter;
+	std::unordered_map<std::string, Resource>::iterator iter;
 
 	for (iter = m_fonts.begin(); iter != m_fonts.end(); ++iter)
 	{
-		delete iter->font;
+		m_variants.erase(iter->second.font);
+		deleteSdfFont(iter->second.font);
+		delete iter->second.font;
 	}
 	m_fonts.clear();
+	m_files.clear();
 }
 
 } // namespace bmonkey
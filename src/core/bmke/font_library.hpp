@@ -25,8 +25,11 @@
 #include <SFML/Graphics.hpp>
 #include <glibmm/ustring.h>
 #include <vector>
+#include <set>
 #include <unordered_map>
+#include <string>
 #include "../../defines.hpp"
+#include "sdf_font.hpp"
 
 namespace bmonkey{
 
@@ -38,6 +41,12 @@ namespace bmonkey{
  * Además de las fuentes cargadas por el usuario, proporciona una fuente por
  * defecto de sistema que siempre estará disponible y que se puede usar en
  * cualquier momento.
+ * SFML rasteriza cada carácter la primera vez que se dibuja con un tamaño, lo
+ * que provoca tirones cuando aparece un texto nuevo. Para evitarlo, la librería
+ * registra los tamaños con los que se usa cada fuente y permite precargar con
+ * ellos un conjunto de caracteres durante la carga del sistema.
+ * También mantiene, bajo demanda, el atlas SDF de cada fuente y el shader con
+ * el que se dibujan los textos a partir de ellos.
  */
 class FontLibrary
 {
@@ -75,6 +84,60 @@ public:
 	 */
 	void deleteFont(sf::Font* font);
 
+	/**
+	 * Registra un tamaño con el que se va a usar una fuente, para precargar
+	 * sus caracteres
+	 * @param font Fuente que se va a usar
+	 * @param size Tamaño de los caracteres
+	 * @param bold Indica si los caracteres se dibujan en negrita
+	 * @note Cada llamada debe acompañarse de una a removeFontSize cuando el
+	 * tamaño deje de usarse
+	 */
+	void addFontSize(sf::Font* font, const unsigned int size, const bool bold);
+
+	/**
+	 * Indica que un usuario deja de usar un tamaño de una fuente. Cuando no le
+	 * quedan usuarios el tamaño deja de precargarse
+	 * @param font Fuente que se usaba
+	 * @param size Tamaño de los caracteres
+	 * @param bold Indica si los caracteres se dibujaban en negrita
+	 */
+	void removeFontSize(sf::Font* font, const unsigned int size, const bool bold);
+
+	/**
+	 * Establece el conjunto de caracteres a precargar en las fuentes
+	 * @param glyphs Caracteres a precargar
+	 */
+	void setGlyphSet(const std::set<sf::Uint32>& glyphs);
+
+	/**
+	 * Rasteriza los caracteres pendientes de precargar en todas las fuentes y
+	 * tamaños registrados
+	 * @param time_limit Tiempo máximo a emplear o cero para no limitarlo
+	 * @return Número de caracteres que quedan pendientes
+	 * @note Necesita el contexto de la ventana, por lo que debe llamarse desde
+	 * el hilo de render
+	 * @note Si el sistema soporta el shader SDF los textos se dibujan desde el
+	 * atlas SDF de cada fuente, así que se precarga éste, una vez por fuente y
+	 * grosor, en lugar de cada tamaño
+	 */
+	unsigned int warmUp(const sf::Time time_limit = sf::Time::Zero);
+
+	/**
+	 * Obtiene el atlas SDF de una fuente, creándolo si es necesario
+	 * @param font Fuente de la que se quiere el atlas
+	 * @return Atlas de la fuente o null si la fuente es null
+	 * @note El atlas se libera junto con la fuente
+	 */
+	SdfFont* getSdfFont(sf::Font* font);
+
+	/**
+	 * Obtiene el shader para dibujar textos SDF, cargándolo si es necesario
+	 * @return Shader de textos SDF o null si el sistema no soporta shaders o
+	 * no se pudo compilar
+	 */
+	sf::Shader* getSdfShader(void);
+
 	/**
 	 * Limpia la librería de fuentes liberando todas las cargadas
 	 * @note Las fuentes del sistema nunca se descargan
@@ -82,16 +145,43 @@ public:
 	void clean(void);
 
 private:
+	/**
+	 * Libera el atlas SDF de una fuente, si lo tiene
+	 * @param font Fuente cuyo atlas se libera
+	 */
+	void deleteSdfFont(const sf::Font* font);
+
+	/**
+	 * Genera los caracteres pendientes de precargar en los atlas SDF de las
+	 * fuentes registradas
+	 * @param time_limit Tiempo máximo a emplear o cero para no limitarlo
+	 * @return Número de caracteres que quedan pendientes
+	 */
+	unsigned int warmUpSdf(const sf::Time time_limit);
 
 	// Estructura para poder llevar el recuento de referencias de la fuente
 	struct Resource
 	{
-		Glib::ustring file;		/**< Path del fichero de la fuente */
 		unsigned int count;		/**< Contador de referencias */
 		sf::Font* font;			/**< Fuente real cargada */
 	};
 
-	std::vector<Resource> m_fonts;		/**< Almacen de fuentes del usuario */
+	// Tamaño con el que se usa una fuente y su estado de precarga
+	struct Variant
+	{
+		unsigned int size;		/**< Tamaño de los caracteres */
+		bool bold;				/**< Indica si se usa en negrita */
+		unsigned int warmed;	/**< Caracteres del conjunto ya precargados */
+		unsigned int count;		/**< Número de usuarios del tamaño */
+	};
+
+	std::unordered_map<std::string, Resource> m_fonts;		/**< Almacen de fuentes del usuario por fichero */
+	std::unordered_map<const sf::Font*, std::string> m_files;	/**< Fichero de cada fuente del usuario */
+	std::unordered_map<sf::Font*, std::vector<Variant> > m_variants;	/**< Tamaños usados de cada fuente */
+	std::vector<sf::Uint32> m_glyphs;	/**< Caracteres a precargar */
+	std::unordered_map<const sf::Font*, SdfFont*> m_sdf_fonts;	/**< Atlas SDF de cada fuente */
+	sf::Shader* m_sdf_shader;			/**< Shader de textos SDF */
+	bool m_sdf_failed;					/**< Indica si falló la carga del shader SDF */
 	sf::Font m_system_font;				/**< Fuente del sistema */
 };
 
@@ -0,0 +1,177 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "frame_pacer.hpp"
+#include <thread>
+#include <algorithm>
+
+// Estimación inicial del exceso de un sleep, en microsegundos
+#define FRAME_PACER_SLEEP_ERROR 1000
+// Exceso máximo que se tiene en cuenta, en microsegundos. Los mayores se
+// deben a esperas puntuales del sistema que no conviene compensar
+#define FRAME_PACER_MAX_SLEEP_ERROR 2000
+// Tiempo restante por debajo del cual no merece la pena dormir
+#define FRAME_PACER_MIN_SLEEP 200
+
+namespace bmonkey{
+
+FramePacer::FramePacer(void):
+	m_frame_duration(Clock::duration::zero()),
+	m_update_duration(std::chrono::duration_cast<Clock::duration>(std::chrono::microseconds(16667))),
+	m_accumulator(Clock::duration::zero()),
+	m_sleep_error(std::chrono::duration_cast<Clock::duration>(std::chrono::microseconds(FRAME_PACER_SLEEP_ERROR))),
+	m_sleep_error_index(0),
+	m_max_updates(5),
+	m_frame_time(sf::Time::Zero),
+	m_interpolation(1.f)
+{
+	unsigned int i;
+
+	for (i = 0; i < ERROR_WINDOW; ++i)
+	{
+		m_sleep_errors[i] = m_sleep_error;
+	}
+	start();
+}
+
+FramePacer::~FramePacer(void)
+{
+}
+
+void FramePacer::setFrameRate(const float frame_rate)
+{
+	if (frame_rate > 0.f)
+	{
+		m_frame_duration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(1.f / frame_rate));
+	}
+	else
+	{
+		m_frame_duration = Clock::duration::zero();
+	}
+}
+
+void FramePacer::setUpdateRate(const float update_rate)
+{
+	if (update_rate > 0.f)
+	{
+		m_update_duration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(1.f / update_rate));
+	}
+}
+
+void FramePacer::start(void)
+{
+	m_last_frame = Clock::now();
+	m_next_frame = m_last_frame;
+	m_accumulator = Clock::duration::zero();
+	m_frame_time = sf::Time::Zero;
+	m_interpolation = 1.f;
+}
+
+unsigned int FramePacer::beginFrame(void)
+{
+	Clock::time_point now;
+	unsigned int updates;
+
+	now = Clock::now();
+	m_frame_time = toTime(now - m_last_frame);
+	m_accumulator += now - m_last_frame;
+	m_last_frame = now;
+
+	// Tras una parada larga descartamos lo que no da tiempo a actualizar
+	if (m_accumulator > m_update_duration * m_max_updates)
+	{
+		m_accumulator = m_update_duration * m_max_updates;
+	}
+	updates = 0;
+	while (m_accumulator >= m_update_duration)
+	{
+		m_accumulator -= m_update_duration;
+		++updates;
+	}
+	m_interpolation = static_cast<float>(m_accumulator.count()) / static_cast<float>(m_update_duration.count());
+	return updates;
+}
+
+void FramePacer::endFrame(void)
+{
+	Clock::time_point now;
+	Clock::time_point before;
+	Clock::duration request;
+	Clock::duration error;
+	Clock::duration max_error;
+	unsigned int i;
+
+	if (m_frame_duration == Clock::duration::zero())
+	{
+		return;
+	}
+
+	now = Clock::now();
+	m_next_frame += m_frame_duration;
+	// Si vamos con retraso no esperamos, y si es de más de un frame no
+	// intentamos recuperarlo para no encadenar frames sin pausa
+	if (now >= m_next_frame)
+	{
+		if (now - m_next_frame > m_frame_duration)
+		{
+			m_next_frame = now;
+		}
+		return;
+	}
+
+	// Dormimos lo que falta menos el exceso que suelen tener los sleep
+	request = m_next_frame - now - m_sleep_error;
+	if (request > std::chrono::microseconds(FRAME_PACER_MIN_SLEEP))
+	{
+		before = now;
+		sf::sleep(toTime(request));
+		now = Clock::now();
+		error = (now - before) - request;
+		if (error < Clock::duration::zero())
+		{
+			error = Clock::duration::zero();
+		}
+		// Limitamos cada medida para que un pico aislado no nos obligue a
+		// esperar de forma activa casi todo el frame
+		max_error = std::min<Clock::duration>(std::chrono::microseconds(FRAME_PACER_MAX_SLEEP_ERROR), m_frame_duration / 4);
+		if (error > max_error)
+		{
+			error = max_error;
+		}
+		// La estimación es el mayor exceso de los últimos sleep
+		m_sleep_errors[m_sleep_error_index] = error;
+		m_sleep_error_index = (m_sleep_error_index + 1) % ERROR_WINDOW;
+		m_sleep_error = Clock::duration::zero();
+		for (i = 0; i < ERROR_WINDOW; ++i)
+		{
+			m_sleep_error = std::max(m_sleep_error, m_sleep_errors[i]);
+		}
+	}
+
+	// El resto lo esperamos de forma activa, cediendo el procesador
+	while (now < m_next_frame)
+	{
+		std::this_thread::yield();
+		now = Clock::now();
+	}
+}
+
+} // namespace bmonkey
@@ -0,0 +1,143 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _FRAME_PACER_HPP_
+#define _FRAME_PACER_HPP_
+
+#include <SFML/System.hpp>
+#include <chrono>
+
+namespace bmonkey{
+
+/**
+ * Controla el ritmo del bucle principal
+ *
+ * Reparte el tiempo real transcurrido en actualizaciones de duración fija y
+ * espera al final de cada frame hasta el momento exacto del siguiente.
+ * La espera combina un sleep, que se queda corto según el mayor error medido
+ * en los últimos, con una espera activa para los últimos
+ * microsegundos, evitando tanto el consumo de una espera activa completa como
+ * el retraso de un sleep demasiado largo.
+ * Tras una parada larga, como al volver de un emulador, el número de
+ * actualizaciones de un frame se limita y el tiempo sobrante se descarta,
+ * para que no se acumulen más actualizaciones de las que da tiempo a hacer.
+ */
+class FramePacer
+{
+public:
+
+	/**
+	 * Constructor de la clase
+	 */
+	FramePacer(void);
+
+	/**
+	 * Destructor de la clase
+	 */
+	~FramePacer(void);
+
+	/**
+	 * Establece el número de frames por segundo a mantener
+	 * @param frame_rate Frames por segundo, 0 para no esperar entre frames
+	 * @note Con vsync habilitado conviene dejarlo a 0 o por encima del
+	 * refresco del monitor
+	 */
+	void setFrameRate(const float frame_rate);
+
+	/**
+	 * Establece el número de actualizaciones fijas por segundo
+	 * @param update_rate Actualizaciones por segundo
+	 */
+	void setUpdateRate(const float update_rate);
+
+	/**
+	 * Obtiene la duración de cada actualización fija
+	 * @return Duración de una actualización
+	 */
+	sf::Time getUpdateTime(void) const;
+
+	/**
+	 * Establece el número máximo de actualizaciones que se hacen en un frame
+	 * @param max_updates Máximo de actualizaciones por frame
+	 */
+	void setMaxUpdates(const unsigned int max_updates);
+
+	/**
+	 * Reinicia la medida del tiempo, por ejemplo al comenzar el bucle
+	 */
+	void start(void);
+
+	/**
+	 * Comienza un nuevo frame midiendo el tiempo transcurrido desde el
+	 * anterior
+	 * @return Número de actualizaciones fijas a realizar en este frame
+	 */
+	unsigned int beginFrame(void);
+
+	/**
+	 * Espera hasta el momento en que debe comenzar el siguiente frame
+	 */
+	void endFrame(void);
+
+	/**
+	 * Obtiene el tiempo real transcurrido entre el frame anterior y el actual
+	 * @return Duración del último frame
+	 */
+	sf::Time getFrameTime(void) const;
+
+	/**
+	 * Obtiene la fracción de actualización pendiente tras las del frame
+	 * actual, con la que interpolar el dibujado
+	 * @return Fracción entre 0 y 1
+	 */
+	float getInterpolation(void) const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	static const unsigned int ERROR_WINDOW = 16;	/**< Número de sleep recientes que se tienen en cuenta */
+
+	/**
+	 * Convierte una duración del reloj en un sf::Time
+	 * @param duration Duración a convertir
+	 * @return Duración equivalente
+	 */
+	static sf::Time toTime(const Clock::duration& duration);
+
+	Clock::duration m_frame_duration;	/**< Duración objetivo de cada frame */
+	Clock::duration m_update_duration;	/**< Duración de cada actualización fija */
+	Clock::duration m_accumulator;		/**< Tiempo pendiente de actualizar */
+	Clock::duration m_sleep_error;		/**< Estimación del exceso de los sleep */
+	Clock::duration m_sleep_errors[ERROR_WINDOW];	/**< Excesos de los últimos sleep */
+	unsigned int m_sleep_error_index;	/**< Posición del exceso más antiguo */
+	Clock::time_point m_last_frame;		/**< Comienzo del frame actual */
+	Clock::time_point m_next_frame;		/**< Comienzo previsto del siguiente frame */
+	unsigned int m_max_updates;			/**< Máximo de actualizaciones por frame */
+	sf::Time m_frame_time;				/**< Duración real del último frame */
+	float m_interpolation;				/**< Fracción de actualización pendiente */
+};
+
+// Inclusión de los métodos inline
+#include "frame_pacer.inl"
+
+} // namespace bmonkey
+
+#endif // _FRAME_PACER_HPP_
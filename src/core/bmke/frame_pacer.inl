@@ -0,0 +1,50 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _FRAME_PACER_INL_
+#define _FRAME_PACER_INL_
+
+inline sf::Time FramePacer::getUpdateTime(void) const
+{
+	return toTime(m_update_duration);
+}
+
+inline void FramePacer::setMaxUpdates(const unsigned int max_updates)
+{
+	m_max_updates = max_updates > 0 ? max_updates : 1;
+}
+
+inline sf::Time FramePacer::getFrameTime(void) const
+{
+	return m_frame_time;
+}
+
+inline float FramePacer::getInterpolation(void) const
+{
+	return m_interpolation;
+}
+
+inline sf::Time FramePacer::toTime(const FramePacer::Clock::duration& duration)
+{
+	return sf::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+
+#endif // _FRAME_PACER_INL_
@@ -29,7 +29,8 @@ bool Graphics::m_instantiated = false;
 
 Graphics::Graphics(Config* config):
 	m_config(config),
-	m_rotation(NONE)
+	m_rotation(NONE),
+	m_batch(&m_window)
 {
 	assert(config);
 
@@ -56,7 +57,6 @@ void Graphics::init(void)
 	sf::ContextSettings ctx_settings;
 	unsigned int antialiasing_level = 0;
 	bool vsync = false;
-	unsigned int fps_limit = 0;
 	float joystick_threshold = 75.f;
 	//float mouse_threshold;
 	unsigned int style;
@@ -119,16 +119,12 @@ void Graphics::init(void)
 	{
 		m_config->setKey(BMONKEY_CFG_CORE, "vertical_sync", vsync);
 	}
-	if (!m_config->getKey(BMONKEY_CFG_CORE, "framerate_limit", fps_limit))
-	{
-		m_config->setKey(BMONKEY_CFG_CORE, "framerate_limit", fps_limit);
-	}
 	if (!m_config->getKey(BMONKEY_CFG_CORE, "joystick_threshold", joystick_threshold))
 	{
 		m_config->setKey(BMONKEY_CFG_CORE, "joystick_threshold", joystick_threshold);
 	}
 
-	LOG_INFO("Graphics: Antialiasing level " << antialiasing_level << ", VSync " << vsync << ", Fps Limit " << fps_limit);
+	LOG_INFO("Graphics: Antialiasing level " << antialiasing_level << ", VSync " << vsync);
 
 	if (fullscreen)
 	{
@@ -142,8 +138,8 @@ void Graphics::init(void)
 	ctx_settings.antialiasingLevel = antialiasing_level;
 	m_window.create(sf::VideoMode(width, height, bpp), "BMonkey 0.1", style, ctx_settings);
 	m_window.setVerticalSyncEnabled(vsync);
-	// Si vsync está habilitado, el limite fps puede dar problemas
-	m_window.setFramerateLimit(fps_limit);
+	// El límite de fps lo mantiene el Director, que espera con más precisión
+	// que setFramerateLimit
 	rotate(rotation);
 
 	if (joystick_threshold != 0)
@@ -220,6 +216,7 @@ void Graphics::capture(void)
 
 	assert(isOpen());
 
+	m_batch.flush();
 	do
 	{
 		screenshot_file = Glib::build_filename(m_screenshot_dir, "screenshot_" + utils::toStr(id) + ".png");
@@ -25,6 +25,8 @@
 #include <SFML/Graphics.hpp>
 #include "../../defines.hpp"
 #include "../../utils/config.hpp"
+#include "entity.hpp"
+#include "sprite_batch.hpp"
 
 namespace bmonkey{
 
@@ -111,6 +113,22 @@ public:
 	 */
 	void draw(const sf::Drawable& drawable, const sf::RenderStates& states = sf::RenderStates::Default);
 
+	/**
+	 * Dibuja una entidad en la ventana de renderizado, agrupando sus quads con
+	 * los de las entidades dibujadas antes y después
+	 * @param entity Entidad a dibujar
+	 * @param states RenderStates a usar en el dibujado de la entidad
+	 * @note Los quads pendientes se dibujan al dibujar cualquier otro objeto o
+	 * al mostrar la ventana
+	 */
+	void draw(const Entity& entity, const sf::RenderStates& states = sf::RenderStates::Default);
+
+	/**
+	 * Obtiene el agrupador de quads de la ventana de renderizado
+	 * @return Agrupador de quads
+	 */
+	SpriteBatch* getSpriteBatch(void);
+
 	/**
 	 * Muestra en pantalla lo que se ha dibujado en la ventana de renderizado
 	 */
@@ -129,6 +147,7 @@ private:
 	Glib::ustring m_screenshot_dir;	/**< Path del directorio para guardar las capturas */
 	sf::RenderWindow m_window;		/**< Ventana de renderizado */
 	Rotation m_rotation;			/**< Rotación actual de la ventana */
+	SpriteBatch m_batch;			/**< Agrupador de quads de la ventana */
 };
 
 // Inclusión de los métodos inline
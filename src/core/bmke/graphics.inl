@@ -39,19 +39,33 @@ inline sf::Vector2u Graphics::getSize() const
 
 inline void Graphics::clear(const sf::Color& color)
 {
+	// Lo pendiente quedaría tapado por el borrado
+	m_batch.clear();
 	m_window.clear(color);
 }
 
 inline void Graphics::draw(const sf::Drawable& drawable, const sf::RenderStates& states)
 {
+	m_batch.flush();
 	m_window.draw(drawable, states);
 }
 
+inline void Graphics::draw(const Entity& entity, const sf::RenderStates& states)
+{
+	entity.drawBatched(m_batch, states);
+}
+
 inline void Graphics::display()
 {
+	m_batch.flush();
 	m_window.display();
 }
 
+inline SpriteBatch* Graphics::getSpriteBatch(void)
+{
+	return &m_batch;
+}
+
 inline sf::RenderWindow* Graphics::getRenderWindow(void)
 {
 	return &m_window;
@@ -0,0 +1,409 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "sdf_font.hpp"
+#include "../../defines.hpp"
+#include <vector>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+// Tamaño inicial del atlas, crece en altura según se necesita
+#define SDF_FONT_ATLAS_SIZE 512
+// Ancho mínimo de la zona donde se reúnen los caracteres nuevos
+#define SDF_FONT_STAGING_WIDTH 512
+// Valor usado como distancia infinita en la transformada
+#define SDF_FONT_INF 1e20f
+
+namespace bmonkey{
+
+// Programa de dibujado de textos SDF. El relleno y el borde se obtienen del
+// mismo campo de distancias con dos umbrales, y la sombra es una segunda capa
+// de vértices del mismo array que se distingue por su coordenada x negativa
+static const std::string SDF_VERTEX_SHADER =
+	"void main()"
+	"{"
+	"    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;"
+	"    gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;"
+	"    gl_FrontColor = gl_Color;"
+	"}";
+
+static const std::string SDF_FRAGMENT_SHADER =
+	"uniform sampler2D texture;"
+	"uniform vec4 fill_color;"
+	"uniform vec4 outline_color;"
+	"uniform float outline_width;"
+	"void main()"
+	"{"
+	"    vec2 coord = gl_TexCoord[0].xy;"
+	"    float shadow = 1.0 - step(0.0, coord.x);"
+	"    coord.x = abs(coord.x);"
+	"    float dist = texture2D(texture, coord).a;"
+	"    float smoothing = 0.7 * fwidth(dist);"
+	"    float fill = smoothstep(0.5 - smoothing, 0.5 + smoothing, dist);"
+	"    float edge = 0.5 - outline_width;"
+	"    float shape = smoothstep(edge - smoothing, edge + smoothing, dist);"
+	"    vec4 color = mix(outline_color, fill_color, fill);"
+	"    color.a *= shape;"
+	"    gl_FragColor = mix(color * gl_Color, vec4(gl_Color.rgb, gl_Color.a * fill), shadow);"
+	"}";
+
+SdfFont::SdfFont(const sf::Font* font):
+	m_font(font),
+	m_pen(1, 1),
+	m_row_height(0)
+{
+	assert(m_font);
+
+	// La primera fila y columna quedan libres para que ninguna coordenada de
+	// textura sea 0 y se pueda usar su signo para marcar la sombra
+	m_image.create(SDF_FONT_ATLAS_SIZE, SDF_FONT_ATLAS_SIZE, sf::Color(255, 255, 255, 0));
+	m_texture.loadFromImage(m_image);
+	m_texture.setSmooth(true);
+}
+
+SdfFont::~SdfFont(void)
+{
+}
+
+bool SdfFont::loadGlyphs(const sf::String& string, const bool bold)
+{
+	std::vector<sf::Uint32> missing;
+	std::vector<sf::Glyph> rasters;
+	std::vector<sf::Uint32>::iterator iter;
+	std::vector<sf::Glyph>::iterator raster_iter;
+	std::vector<sf::IntRect> rects;
+	std::vector<sf::IntRect>::iterator rect_iter;
+	sf::Image source;
+	sf::Vector2u size;
+	Glyph glyph;
+	bool ret = true;
+	std::size_t i;
+
+	// El espacio siempre es necesario para los tabuladores
+	if (!getGlyph(L' ', bold))
+	{
+		missing.push_back(L' ');
+	}
+	for (i = 0; i < string.getSize(); ++i)
+	{
+		if ((string[i] != L'\n') && (string[i] != L'\t') && !getGlyph(string[i], bold))
+		{
+			missing.push_back(string[i]);
+		}
+	}
+	if (missing.empty())
+	{
+		return true;
+	}
+	std::sort(missing.begin(), missing.end());
+	missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+
+	// Rasterizamos todos los caracteres antes de leer la textura de la fuente,
+	// ya que añadir uno puede reorganizarla
+	for (iter = missing.begin(); iter != missing.end(); ++iter)
+	{
+		rasters.push_back(m_font->getGlyph(*iter, BASE_SIZE, bold));
+	}
+	if (!stageGlyphs(rasters, source, rects))
+	{
+		// Sin la zona intermedia leemos la página completa de la fuente
+		source = m_font->getTexture(BASE_SIZE).copyToImage();
+		rects.clear();
+		for (raster_iter = rasters.begin(); raster_iter != rasters.end(); ++raster_iter)
+		{
+			rects.push_back(raster_iter->textureRect);
+		}
+	}
+
+	size = m_image.getSize();
+	for (iter = missing.begin(), raster_iter = rasters.begin(), rect_iter = rects.begin(); iter != missing.end(); ++iter, ++raster_iter, ++rect_iter)
+	{
+		glyph.advance = raster_iter->advance;
+		glyph.bounds = sf::FloatRect(0.f, 0.f, 0.f, 0.f);
+		glyph.rect = sf::IntRect(0, 0, 0, 0);
+		// Los caracteres sin forma, como el espacio, sólo aportan su avance
+		if ((raster_iter->textureRect.width > 0) && (raster_iter->textureRect.height > 0))
+		{
+			if (!allocate(raster_iter->textureRect.width + 2 * SPREAD, raster_iter->textureRect.height + 2 * SPREAD, glyph.rect))
+			{
+				ret = false;
+				continue;
+			}
+			glyph.bounds.left = raster_iter->bounds.left - static_cast<float>(SPREAD);
+			glyph.bounds.top = raster_iter->bounds.top - static_cast<float>(SPREAD);
+			glyph.bounds.width = glyph.rect.width;
+			glyph.bounds.height = glyph.rect.height;
+			render(source, *rect_iter, glyph.rect);
+		}
+		m_glyphs[getKey(*iter, bold)] = glyph;
+	}
+
+	// Subimos el atlas de una vez, recreando la textura si ha crecido
+	if (m_image.getSize() != size)
+	{
+		m_texture.loadFromImage(m_image);
+		m_texture.setSmooth(true);
+	}
+	else
+	{
+		m_texture.update(m_image);
+	}
+	return ret;
+}
+
+bool SdfFont::stageGlyphs(const std::vector<sf::Glyph>& rasters, sf::Image& image, std::vector<sf::IntRect>& rects)
+{
+	std::vector<sf::Glyph>::const_iterator iter;
+	std::vector<sf::IntRect>::iterator rect_iter;
+	sf::Sprite sprite;
+	sf::Vector2u size;
+	unsigned int width = SDF_FONT_STAGING_WIDTH;
+	unsigned int x = 0;
+	unsigned int y = 0;
+	unsigned int row_height = 0;
+
+	for (iter = rasters.begin(); iter != rasters.end(); ++iter)
+	{
+		width = std::max(width, static_cast<unsigned int>(iter->textureRect.width));
+	}
+	// Colocamos los caracteres en estantes, como en el atlas
+	rects.clear();
+	for (iter = rasters.begin(); iter != rasters.end(); ++iter)
+	{
+		if ((iter->textureRect.width <= 0) || (iter->textureRect.height <= 0))
+		{
+			rects.push_back(sf::IntRect(0, 0, 0, 0));
+			continue;
+		}
+		if (x + iter->textureRect.width > width)
+		{
+			x = 0;
+			y += row_height;
+			row_height = 0;
+		}
+		rects.push_back(sf::IntRect(x, y, iter->textureRect.width, iter->textureRect.height));
+		x += iter->textureRect.width;
+		row_height = std::max(row_height, static_cast<unsigned int>(iter->textureRect.height));
+	}
+	if (y + row_height == 0)
+	{
+		return true;
+	}
+
+	// La zona sólo se recrea cuando el bloque no cabe en ella
+	size = m_staging.getSize();
+	if ((size.x < width) || (size.y < y + row_height))
+	{
+		if (!m_staging.create(std::max(size.x, width), std::max(size.y, y + row_height)))
+		{
+			return false;
+		}
+	}
+	// Copiamos los pixels tal cual, sin mezclar con el fondo
+	m_staging.clear(sf::Color::Transparent);
+	sprite.setTexture(m_font->getTexture(BASE_SIZE));
+	for (iter = rasters.begin(), rect_iter = rects.begin(); iter != rasters.end(); ++iter, ++rect_iter)
+	{
+		if (rect_iter->width > 0)
+		{
+			sprite.setTextureRect(iter->textureRect);
+			sprite.setPosition(static_cast<float>(rect_iter->left), static_cast<float>(rect_iter->top));
+			m_staging.draw(sprite, sf::RenderStates(sf::BlendNone));
+		}
+	}
+	m_staging.display();
+	image = m_staging.getTexture().copyToImage();
+	return true;
+}
+
+bool SdfFont::loadShader(sf::Shader& shader)
+{
+	if (!sf::Shader::isAvailable())
+	{
+		return false;
+	}
+	if (!shader.loadFromMemory(SDF_VERTEX_SHADER, SDF_FRAGMENT_SHADER))
+	{
+		LOG_ERROR("SdfFont: Can't compile the SDF text shader");
+		return false;
+	}
+	return true;
+}
+
+bool SdfFont::allocate(const unsigned int width, const unsigned int height, sf::IntRect& rect)
+{
+	sf::Vector2u size;
+	sf::Image image;
+
+	size = m_image.getSize();
+	if (width + 2 > size.x)
+	{
+		return false;
+	}
+	// Si no cabe en el estante actual, abrimos uno nuevo
+	if (m_pen.x + width + 1 > size.x)
+	{
+		m_pen.x = 1;
+		m_pen.y += m_row_height + 1;
+		m_row_height = 0;
+	}
+	// Si no cabe en el atlas, duplicamos su altura
+	while (m_pen.y + height + 1 > size.y)
+	{
+		if (size.y * 2 > sf::Texture::getMaximumSize())
+		{
+			LOG_ERROR("SdfFont: The glyph atlas is full");
+			return false;
+		}
+		image.create(size.x, size.y * 2, sf::Color(255, 255, 255, 0));
+		image.copy(m_image, 0, 0);
+		m_image = image;
+		size = m_image.getSize();
+	}
+	rect = sf::IntRect(m_pen.x, m_pen.y, width, height);
+	m_pen.x += width + 1;
+	m_row_height = std::max(m_row_height, height);
+	return true;
+}
+
+void SdfFont::render(const sf::Image& source, const sf::IntRect& source_rect, const sf::IntRect& rect)
+{
+	std::vector<float> inside;
+	std::vector<float> outside;
+	std::vector<float> buffer;
+	const sf::Uint8* pixels;
+	unsigned int source_width;
+	unsigned int width;
+	unsigned int height;
+	unsigned int x;
+	unsigned int y;
+	int sx;
+	int sy;
+	bool in;
+	float distance;
+
+	width = rect.width;
+	height = rect.height;
+	inside.resize(width * height);
+	outside.resize(width * height);
+	buffer.resize(3 * std::max(width, height) + 1);
+	pixels = source.getPixelsPtr();
+	source_width = source.getSize().x;
+
+	// Separamos los pixels interiores de los exteriores. inside guardará la
+	// distancia de cada pixel interior al exterior más cercano y outside la
+	// de cada exterior al interior más cercano
+	for (y = 0; y < height; ++y)
+	{
+		for (x = 0; x < width; ++x)
+		{
+			sx = static_cast<int>(x) - static_cast<int>(SPREAD);
+			sy = static_cast<int>(y) - static_cast<int>(SPREAD);
+			in = (sx >= 0) && (sy >= 0) && (sx < source_rect.width) && (sy < source_rect.height) &&
+				(pixels[((source_rect.top + sy) * source_width + source_rect.left + sx) * 4 + 3] >= 128);
+			inside[y * width + x] = in ? SDF_FONT_INF : 0.f;
+			outside[y * width + x] = in ? 0.f : SDF_FONT_INF;
+		}
+	}
+
+	// La transformada en dos dimensiones se separa en columnas y filas
+	for (x = 0; x < width; ++x)
+	{
+		transform(&inside[x], height, width, &buffer[0]);
+		transform(&outside[x], height, width, &buffer[0]);
+	}
+	for (y = 0; y < height; ++y)
+	{
+		transform(&inside[y * width], width, 1, &buffer[0]);
+		transform(&outside[y * width], width, 1, &buffer[0]);
+	}
+
+	// El contorno queda a medio pixel entre un pixel interior y uno exterior
+	for (y = 0; y < height; ++y)
+	{
+		for (x = 0; x < width; ++x)
+		{
+			if (outside[y * width + x] == 0.f)
+			{
+				distance = std::sqrt(inside[y * width + x]) - 0.5f;
+			}
+			else
+			{
+				distance = 0.5f - std::sqrt(outside[y * width + x]);
+			}
+			distance = 0.5f + distance / (2.f * SPREAD);
+			distance = std::min(std::max(distance, 0.f), 1.f);
+			m_image.setPixel(rect.left + x, rect.top + y, sf::Color(255, 255, 255, static_cast<sf::Uint8>(distance * 255.f + 0.5f)));
+		}
+	}
+}
+
+void SdfFont::transform(float* data, const unsigned int count, const unsigned int step, float* buffer)
+{
+	float* f;
+	float* v;
+	float* z;
+	unsigned int q;
+	unsigned int k;
+	float s;
+	float vk;
+
+	// Envolvente inferior de parábolas (Felzenszwalb y Huttenlocher)
+	f = buffer;
+	v = f + count;
+	z = v + count;
+	for (q = 0; q < count; ++q)
+	{
+		f[q] = data[q * step];
+	}
+	k = 0;
+	v[0] = 0.f;
+	z[0] = -SDF_FONT_INF;
+	z[1] = SDF_FONT_INF;
+	for (q = 1; q < count; ++q)
+	{
+		vk = v[k];
+		s = ((f[q] + q * q) - (f[static_cast<unsigned int>(vk)] + vk * vk)) / (2.f * q - 2.f * vk);
+		while (s <= z[k])
+		{
+			--k;
+			vk = v[k];
+			s = ((f[q] + q * q) - (f[static_cast<unsigned int>(vk)] + vk * vk)) / (2.f * q - 2.f * vk);
+		}
+		++k;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = SDF_FONT_INF;
+	}
+	k = 0;
+	for (q = 0; q < count; ++q)
+	{
+		while (z[k + 1] < q)
+		{
+			++k;
+		}
+		vk = v[k];
+		data[q * step] = (q - vk) * (q - vk) + f[static_cast<unsigned int>(vk)];
+	}
+}
+
+} // namespace bmonkey
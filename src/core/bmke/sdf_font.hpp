@@ -0,0 +1,171 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _SDF_FONT_HPP_
+#define _SDF_FONT_HPP_
+
+#include <SFML/Graphics.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace bmonkey{
+
+/**
+ * Atlas de caracteres en campo de distancias (SDF) de una fuente
+ *
+ * En lugar de la cobertura de cada pixel, el atlas guarda la distancia con
+ * signo al contorno del carácter. Con ello un único atlas rasterizado a un
+ * tamaño base sirve para cualquier tamaño de texto, y el shader asociado
+ * puede obtener el relleno, el borde y la sombra de un texto en un solo
+ * dibujado, sin repetirlo desplazado como se hace con sf::Text.
+ * La distancia se guarda en el canal alfa: 0.5 es el contorno, los valores
+ * mayores quedan dentro del carácter y cada unidad equivale a 2 * SPREAD
+ * pixels del tamaño base.
+ */
+class SdfFont
+{
+public:
+	/**
+	 * Información de un carácter del atlas, en pixels del tamaño base
+	 */
+	struct Glyph
+	{
+		float advance;			/**< Desplazamiento hasta el siguiente carácter */
+		sf::FloatRect bounds;	/**< Caja del carácter respecto a la línea base, margen incluido */
+		sf::IntRect rect;		/**< Región del atlas que ocupa, margen incluido */
+	};
+
+	static const unsigned int BASE_SIZE = 64;	/**< Tamaño al que se rasterizan los caracteres */
+	static const unsigned int SPREAD = 8;		/**< Distancia máxima representada en pixels base */
+
+	/**
+	 * Constructor parametrizado
+	 * @param font Fuente de la que se generan los caracteres
+	 */
+	SdfFont(const sf::Font* font);
+
+	/**
+	 * Destructor de la clase
+	 */
+	~SdfFont(void);
+
+	/**
+	 * Genera en el atlas los caracteres de un texto que aún no estén en él
+	 * @param string Texto cuyos caracteres se necesitan
+	 * @param bold Indica si los caracteres se dibujan en negrita
+	 * @return True si todos los caracteres están disponibles, false si alguno
+	 * no cabe en el atlas
+	 * @note Los caracteres nuevos se generan en bloque, con una sola lectura
+	 * de la tarjeta limitada a sus regiones y una sola subida del atlas
+	 */
+	bool loadGlyphs(const sf::String& string, const bool bold);
+
+	/**
+	 * Obtiene un carácter del atlas
+	 * @param code_point Carácter buscado
+	 * @param bold Indica si el carácter se dibuja en negrita
+	 * @return Información del carácter o null si no se ha generado
+	 */
+	const Glyph* getGlyph(const sf::Uint32 code_point, const bool bold) const;
+
+	/**
+	 * Obtiene la fuente de la que se generan los caracteres
+	 * @return Fuente del atlas
+	 */
+	const sf::Font* getFont(void) const;
+
+	/**
+	 * Obtiene la textura del atlas
+	 * @return Textura con los campos de distancias
+	 */
+	const sf::Texture& getTexture(void) const;
+
+	/**
+	 * Carga en un shader el programa de dibujado de textos SDF
+	 * @param shader Shader donde cargar el programa
+	 * @return True si se pudo compilar el programa, false en otro caso
+	 * @note Uniforms del programa: texture (atlas), fill_color, outline_color y
+	 * outline_width (grosor del borde en unidades de distancia). Los vértices
+	 * con coordenada de textura x negativa pertenecen a la sombra y se
+	 * rellenan con su propio color
+	 */
+	static bool loadShader(sf::Shader& shader);
+
+private:
+	/**
+	 * Calcula la clave de un carácter en el atlas
+	 * @param code_point Carácter
+	 * @param bold Indica si el carácter se dibuja en negrita
+	 * @return Clave del carácter
+	 */
+	static sf::Uint64 getKey(const sf::Uint32 code_point, const bool bold);
+
+	/**
+	 * Reserva un hueco en el atlas, ampliándolo si es necesario
+	 * @param width Ancho del hueco
+	 * @param height Alto del hueco
+	 * @param rect Devuelve la región reservada
+	 * @return True si se pudo reservar, false si el atlas está lleno
+	 */
+	bool allocate(const unsigned int width, const unsigned int height, sf::IntRect& rect);
+
+	/**
+	 * Copia a memoria los caracteres rasterizados por la fuente, leyendo de
+	 * la tarjeta sólo sus regiones y no la página completa de la fuente
+	 * @param rasters Caracteres rasterizados por la fuente
+	 * @param image Devuelve la imagen con los caracteres
+	 * @param rects Devuelve la región de la imagen que ocupa cada carácter
+	 * @return True si se pudieron copiar, false en otro caso
+	 */
+	bool stageGlyphs(const std::vector<sf::Glyph>& rasters, sf::Image& image, std::vector<sf::IntRect>& rects);
+
+	/**
+	 * Genera el campo de distancias de un carácter y lo escribe en el atlas
+	 * @param source Imagen con la textura de la fuente
+	 * @param source_rect Región de la imagen que ocupa el carácter
+	 * @param rect Región del atlas donde escribir el resultado
+	 */
+	void render(const sf::Image& source, const sf::IntRect& source_rect, const sf::IntRect& rect);
+
+	/**
+	 * Transformada de distancias euclídea al cuadrado en una dimensión
+	 * @param data Valores de entrada y resultado
+	 * @param count Número de valores
+	 * @param step Separación entre valores consecutivos dentro de data
+	 * @param buffer Espacio auxiliar de al menos 3 * count + 1 floats
+	 */
+	static void transform(float* data, const unsigned int count, const unsigned int step, float* buffer);
+
+	const sf::Font* m_font;					/**< Fuente de la que se generan los caracteres */
+	std::unordered_map<sf::Uint64, Glyph> m_glyphs;	/**< Caracteres generados */
+	sf::Image m_image;						/**< Copia en memoria del atlas */
+	sf::Texture m_texture;					/**< Textura del atlas */
+	sf::RenderTexture m_staging;			/**< Zona donde se reúnen los caracteres nuevos para leerlos */
+	sf::Vector2u m_pen;						/**< Siguiente posición libre del estante actual */
+	unsigned int m_row_height;				/**< Altura del estante actual */
+};
+
+// Inclusión de los métodos inline
+#include "sdf_font.inl"
+
+} // namespace bmonkey
+
+#endif // _SDF_FONT_HPP_
@@ -0,0 +1,48 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _SDF_FONT_INL_
+#define _SDF_FONT_INL_
+
+inline const SdfFont::Glyph* SdfFont::getGlyph(const sf::Uint32 code_point, const bool bold) const
+{
+	std::unordered_map<sf::Uint64, Glyph>::const_iterator iter;
+
+	iter = m_glyphs.find(getKey(code_point, bold));
+	return (iter != m_glyphs.end()) ? &iter->second : nullptr;
+}
+
+inline const sf::Font* SdfFont::getFont(void) const
+{
+	return m_font;
+}
+
+inline const sf::Texture& SdfFont::getTexture(void) const
+{
+	return m_texture;
+}
+
+inline sf::Uint64 SdfFont::getKey(const sf::Uint32 code_point, const bool bold)
+{
+	return (static_cast<sf::Uint64>(bold) << 32) | code_point;
+}
+
+#endif // _SDF_FONT_INL_
@@ -0,0 +1,137 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "sprite_batch.hpp"
+#include <algorithm>
+#include <cassert>
+
+// Número máximo de lotes hacia atrás en los que se busca uno compatible
+#define SPRITE_BATCH_LOOKBACK 16
+
+namespace bmonkey{
+
+SpriteBatch::SpriteBatch(sf::RenderTarget* target):
+	m_target(target),
+	m_count(0),
+	m_draw_calls(0),
+	m_quads(0)
+{
+	assert(m_target);
+}
+
+SpriteBatch::~SpriteBatch(void)
+{
+}
+
+void SpriteBatch::add(const sf::Vertex* vertices, const std::size_t count, const sf::RenderStates& states)
+{
+	sf::Vertex quad[4];
+	sf::FloatRect bounds;
+	float right;
+	float bottom;
+	unsigned int found;
+	unsigned int i;
+	std::size_t j;
+	std::size_t k;
+
+	for (j = 0; j + 3 < count; j += 4)
+	{
+		// Pasamos el quad a coordenadas del target y calculamos su caja
+		for (k = 0; k < 4; ++k)
+		{
+			quad[k] = vertices[j + k];
+			quad[k].position = states.transform.transformPoint(quad[k].position);
+		}
+		bounds.left = right = quad[0].position.x;
+		bounds.top = bottom = quad[0].position.y;
+		for (k = 1; k < 4; ++k)
+		{
+			bounds.left = std::min(bounds.left, quad[k].position.x);
+			bounds.top = std::min(bounds.top, quad[k].position.y);
+			right = std::max(right, quad[k].position.x);
+			bottom = std::max(bottom, quad[k].position.y);
+		}
+		bounds.width = right - bounds.left;
+		bounds.height = bottom - bounds.top;
+
+		// Buscamos hacia atrás un lote compatible. No podemos saltar por
+		// encima de un lote con el que el quad se solape
+		found = m_count;
+		for (i = m_count; (i > 0) && (m_count - i < SPRITE_BATCH_LOOKBACK); --i)
+		{
+			if ((m_batches[i - 1].texture == states.texture) && (m_batches[i - 1].blend_mode == states.blendMode))
+			{
+				found = i - 1;
+				break;
+			}
+			if (m_batches[i - 1].bounds.intersects(bounds))
+			{
+				break;
+			}
+		}
+
+		// Si no hay ninguno, abrimos un lote nuevo al final
+		if (found == m_count)
+		{
+			if (m_count == m_batches.size())
+			{
+				m_batches.push_back(Batch());
+			}
+			m_batches[m_count].texture = states.texture;
+			m_batches[m_count].blend_mode = states.blendMode;
+			m_batches[m_count].bounds = bounds;
+			++m_count;
+		}
+		else
+		{
+			Batch& batch = m_batches[found];
+			right = std::max(batch.bounds.left + batch.bounds.width, bounds.left + bounds.width);
+			bottom = std::max(batch.bounds.top + batch.bounds.height, bounds.top + bounds.height);
+			batch.bounds.left = std::min(batch.bounds.left, bounds.left);
+			batch.bounds.top = std::min(batch.bounds.top, bounds.top);
+			batch.bounds.width = right - batch.bounds.left;
+			batch.bounds.height = bottom - batch.bounds.top;
+		}
+		m_batches[found].vertices.insert(m_batches[found].vertices.end(), quad, quad + 4);
+	}
+}
+
+void SpriteBatch::flush(void)
+{
+	std::vector<Batch>::iterator iter;
+	sf::RenderStates states;
+
+	for (iter = m_batches.begin(); iter != m_batches.begin() + m_count; ++iter)
+	{
+		if (!iter->vertices.empty())
+		{
+			states.texture = iter->texture;
+			states.blendMode = iter->blend_mode;
+			m_target->draw(&iter->vertices[0], iter->vertices.size(), sf::Quads, states);
+			++m_draw_calls;
+			m_quads += iter->vertices.size() / 4;
+			iter->vertices.clear();
+		}
+	}
+	m_count = 0;
+}
+
+} // namespace bmonkey
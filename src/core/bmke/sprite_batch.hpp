@@ -0,0 +1,123 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _SPRITE_BATCH_HPP_
+#define _SPRITE_BATCH_HPP_
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+namespace bmonkey{
+
+/**
+ * Agrupador de quads para reducir las llamadas de dibujado
+ *
+ * Recibe los quads de las entidades durante el recorrido de dibujado, ya
+ * transformados a coordenadas del target, y los acumula en lotes que comparten
+ * textura y modo de mezcla. Cada lote se dibuja después con una sola llamada.
+ * Un quad puede adelantarse a lotes posteriores a uno compatible siempre que
+ * no se solape con ninguno de ellos, de forma que el resultado es el mismo que
+ * dibujándolos en orden.
+ * Los quads con shader no se agrupan, ya que sus parámetros pueden cambiar
+ * entre un dibujado y otro.
+ */
+class SpriteBatch
+{
+public:
+	/**
+	 * Constructor parametrizado
+	 * @param target Target donde se dibujarán los lotes
+	 */
+	SpriteBatch(sf::RenderTarget* target);
+
+	/**
+	 * Destructor de la clase
+	 */
+	~SpriteBatch(void);
+
+	/**
+	 * Obtiene el target donde se dibujan los lotes
+	 * @return Target de dibujado
+	 */
+	sf::RenderTarget* getTarget(void);
+
+	/**
+	 * Añade quads al agrupador
+	 * @param vertices Vértices de los quads, cuatro por quad
+	 * @param count Número de vértices
+	 * @param states States con la transformación, textura y modo de mezcla
+	 * @note El shader de los states se ignora
+	 */
+	void add(const sf::Vertex* vertices, const std::size_t count, const sf::RenderStates& states);
+
+	/**
+	 * Dibuja los lotes pendientes en el target
+	 * @note Debe llamarse antes de dibujar cualquier cosa directamente en el
+	 * target, para mantener el orden
+	 */
+	void flush(void);
+
+	/**
+	 * Descarta los lotes pendientes sin dibujarlos
+	 */
+	void clear(void);
+
+	/**
+	 * Obtiene el número de llamadas de dibujado realizadas
+	 * @return Llamadas de dibujado desde el último reseteo
+	 */
+	unsigned int getDrawCalls(void) const;
+
+	/**
+	 * Obtiene el número de quads dibujados
+	 * @return Quads dibujados desde el último reseteo
+	 */
+	unsigned int getQuadCount(void) const;
+
+	/**
+	 * Resetea las estadísticas del agrupador
+	 */
+	void resetStats(void);
+
+private:
+
+	// Conjunto de quads que se dibujan con una sola llamada
+	struct Batch
+	{
+		const sf::Texture* texture;		/**< Textura de los quads */
+		sf::BlendMode blend_mode;		/**< Modo de mezcla de los quads */
+		std::vector<sf::Vertex> vertices;	/**< Vértices en coordenadas del target */
+		sf::FloatRect bounds;			/**< Caja que engloba todos los quads */
+	};
+
+	sf::RenderTarget* m_target;			/**< Target donde se dibujan los lotes */
+	std::vector<Batch> m_batches;		/**< Lotes, se reutilizan entre frames */
+	unsigned int m_count;				/**< Lotes pendientes de dibujar */
+	unsigned int m_draw_calls;			/**< Llamadas de dibujado realizadas */
+	unsigned int m_quads;				/**< Quads dibujados */
+};
+
+// Inclusión de los métodos inline
+#include "sprite_batch.inl"
+
+} // namespace bmonkey
+
+#endif // _SPRITE_BATCH_HPP_
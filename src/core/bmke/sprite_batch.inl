@@ -0,0 +1,57 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _SPRITE_BATCH_INL_
+#define _SPRITE_BATCH_INL_
+
+inline sf::RenderTarget* SpriteBatch::getTarget(void)
+{
+	return m_target;
+}
+
+inline void SpriteBatch::clear(void)
+{
+	std::vector<Batch>::iterator iter;
+
+	for (iter = m_batches.begin(); iter != m_batches.begin() + m_count; ++iter)
+	{
+		iter->vertices.clear();
+	}
+	m_count = 0;
+}
+
+inline unsigned int SpriteBatch::getDrawCalls(void) const
+{
+	return m_draw_calls;
+}
+
+inline unsigned int SpriteBatch::getQuadCount(void) const
+{
+	return m_quads;
+}
+
+inline void SpriteBatch::resetStats(void)
+{
+	m_draw_calls = 0;
+	m_quads = 0;
+}
+
+#endif // _SPRITE_BATCH_INL_
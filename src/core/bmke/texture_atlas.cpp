@@ -0,0 +1,358 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "texture_atlas.hpp"
+#include <algorithm>
+#include <cassert>
+
+// Separación transparente alrededor de cada imagen para evitar que el
+// suavizado mezcle pixels de imágenes vecinas
+#define TEXTURE_ATLAS_PADDING 1
+// Redondeo de la altura de los estantes para que los aprovechen imágenes de
+// alturas parecidas
+#define TEXTURE_ATLAS_SHELF_ROUND 8
+
+namespace bmonkey{
+
+TextureAtlas::TextureAtlas(const unsigned int page_size, const unsigned int max_pages):
+	m_page_size(page_size),
+	m_max_pages(max_pages),
+	m_smooth(false),
+	m_evictions(0)
+{
+	assert(m_page_size > 0);
+}
+
+TextureAtlas::~TextureAtlas(void)
+{
+	clear();
+}
+
+sf::Texture* TextureAtlas::add(const std::string& key, const sf::Image& image, sf::IntRect& rect)
+{
+	sf::Vector2u size;
+	sf::Image padded;
+	Slot slot;
+
+	// Si ya está en el atlas solo añadimos la referencia
+	if (m_slots.find(key) != m_slots.end())
+	{
+		return acquire(key, rect);
+	}
+	size = image.getSize();
+	if (!fits(size))
+	{
+		return nullptr;
+	}
+	// Buscamos primero en estantes de altura parecida, después en un estante
+	// nuevo y por último en cualquier estante donde quepa. Si no hay sitio
+	// desalojamos imágenes sin referencias hasta que lo haya
+	while (!find(size, true, slot) &&
+		!(addShelf(size.y + TEXTURE_ATLAS_PADDING * 2, slot) && find(size, true, slot)) &&
+		!find(size, false, slot))
+	{
+		if (!evict())
+		{
+			return nullptr;
+		}
+	}
+
+	// Subimos la imagen con su borde transparente, que limpia los restos de
+	// imágenes desalojadas
+	padded.create(size.x + TEXTURE_ATLAS_PADDING * 2, size.y + TEXTURE_ATLAS_PADDING * 2, sf::Color::Transparent);
+	padded.copy(image, TEXTURE_ATLAS_PADDING, TEXTURE_ATLAS_PADDING);
+	m_pages[slot.page].texture->update(padded, slot.rect.left - TEXTURE_ATLAS_PADDING, slot.rect.top - TEXTURE_ATLAS_PADDING);
+
+	slot.count = 1;
+	slot.lru = m_lru.end();
+	m_slots[key] = slot;
+	rect = slot.rect;
+	return m_pages[slot.page].texture;
+}
+
+sf::Texture* TextureAtlas::acquire(const std::string& key, sf::IntRect& rect)
+{
+	std::unordered_map<std::string, Slot>::iterator iter;
+
+	iter = m_slots.find(key);
+	if (iter == m_slots.end())
+	{
+		return nullptr;
+	}
+	// Si no tenía referencias deja de ser desalojable
+	if (iter->second.count == 0)
+	{
+		m_lru.erase(iter->second.lru);
+	}
+	++iter->second.count;
+	rect = iter->second.rect;
+	return m_pages[iter->second.page].texture;
+}
+
+bool TextureAtlas::release(const std::string& key)
+{
+	std::unordered_map<std::string, Slot>::iterator iter;
+
+	iter = m_slots.find(key);
+	if (iter == m_slots.end())
+	{
+		return false;
+	}
+	if (iter->second.count > 0)
+	{
+		--iter->second.count;
+		if (iter->second.count == 0)
+		{
+			iter->second.lru = m_lru.insert(m_lru.end(), iter->first);
+		}
+	}
+	return true;
+}
+
+bool TextureAtlas::update(const std::string& key, const sf::Image& image)
+{
+	std::unordered_map<std::string, Slot>::iterator iter;
+	sf::Vector2u size;
+
+	iter = m_slots.find(key);
+	if (iter == m_slots.end())
+	{
+		return false;
+	}
+	size = image.getSize();
+	if ((static_cast<int>(size.x) != iter->second.rect.width) || (static_cast<int>(size.y) != iter->second.rect.height))
+	{
+		return false;
+	}
+	m_pages[iter->second.page].texture->update(image, iter->second.rect.left, iter->second.rect.top);
+	return true;
+}
+
+bool TextureAtlas::fits(const sf::Vector2u& size) const
+{
+	// Las imágenes grandes desperdiciarían demasiado espacio de la página
+	return ((size.x > 0) && (size.y > 0) &&
+		(size.x + TEXTURE_ATLAS_PADDING * 2 <= m_page_size / 2) &&
+		(size.y + TEXTURE_ATLAS_PADDING * 2 <= m_page_size / 2));
+}
+
+void TextureAtlas::setSmooth(const bool smooth)
+{
+	std::vector<Page>::iterator iter;
+
+	for (iter = m_pages.begin(); iter != m_pages.end(); ++iter)
+	{
+		iter->texture->setSmooth(smooth);
+	}
+	m_smooth = smooth;
+}
+
+void TextureAtlas::clear(void)
+{
+	std::vector<Page>::iterator iter;
+
+	for (iter = m_pages.begin(); iter != m_pages.end(); ++iter)
+	{
+		delete iter->texture;
+	}
+	m_pages.clear();
+	m_slots.clear();
+	m_lru.clear();
+}
+
+bool TextureAtlas::find(const sf::Vector2u& size, const bool tight, Slot& slot)
+{
+	unsigned int width, height, waste, best_waste, max_height;
+	unsigned int page, shelf, gap;
+	Shelf* best_shelf = nullptr;
+	int best_gap = -1;
+
+	width = size.x + TEXTURE_ATLAS_PADDING * 2;
+	height = size.y + TEXTURE_ATLAS_PADDING * 2;
+	max_height = tight ? height + std::max(height / 4, static_cast<unsigned int>(TEXTURE_ATLAS_SHELF_ROUND)) : m_page_size;
+	best_waste = m_page_size + 1;
+
+	// Elegimos el estante que menos altura desperdicie, aprovechando antes los
+	// huecos de imágenes desalojadas que el espacio del final
+	for (page = 0; page < m_pages.size(); ++page)
+	{
+		for (shelf = 0; shelf < m_pages[page].shelves.size(); ++shelf)
+		{
+			Shelf& current = m_pages[page].shelves[shelf];
+			if ((current.height < height) || (current.height > max_height))
+			{
+				continue;
+			}
+			waste = current.height - height;
+			if (waste >= best_waste)
+			{
+				continue;
+			}
+			for (gap = 0; gap < current.gaps.size(); ++gap)
+			{
+				if (current.gaps[gap].width >= width)
+				{
+					break;
+				}
+			}
+			if ((gap < current.gaps.size()) || (current.x + width <= m_page_size))
+			{
+				best_waste = waste;
+				best_shelf = &current;
+				best_gap = (gap < current.gaps.size()) ? static_cast<int>(gap) : -1;
+				slot.page = page;
+				slot.shelf = shelf;
+			}
+		}
+	}
+	if (!best_shelf)
+	{
+		return false;
+	}
+
+	// Reservamos el espacio en el estante elegido
+	if (best_gap >= 0)
+	{
+		Gap& current = best_shelf->gaps[best_gap];
+		slot.rect.left = current.x;
+		current.x += width;
+		current.width -= width;
+		if (current.width == 0)
+		{
+			best_shelf->gaps.erase(best_shelf->gaps.begin() + best_gap);
+		}
+	}
+	else
+	{
+		slot.rect.left = best_shelf->x;
+		best_shelf->x += width;
+	}
+	slot.rect.left += TEXTURE_ATLAS_PADDING;
+	slot.rect.top = best_shelf->y + TEXTURE_ATLAS_PADDING;
+	slot.rect.width = size.x;
+	slot.rect.height = size.y;
+	return true;
+}
+
+bool TextureAtlas::addShelf(const unsigned int height, Slot& slot)
+{
+	unsigned int shelf_height, page;
+	sf::Texture* texture;
+	Shelf shelf;
+	Page new_page;
+
+	shelf_height = ((height + TEXTURE_ATLAS_SHELF_ROUND - 1) / TEXTURE_ATLAS_SHELF_ROUND) * TEXTURE_ATLAS_SHELF_ROUND;
+	shelf_height = std::min(shelf_height, m_page_size);
+
+	// Buscamos una página con altura libre suficiente
+	for (page = 0; page < m_pages.size(); ++page)
+	{
+		if (m_pages[page].height + shelf_height <= m_page_size)
+		{
+			break;
+		}
+	}
+	if (page == m_pages.size())
+	{
+		if (m_pages.size() >= m_max_pages)
+		{
+			return false;
+		}
+		texture = new sf::Texture();
+		if (!texture->create(m_page_size, m_page_size))
+		{
+			delete texture;
+			return false;
+		}
+		texture->setSmooth(m_smooth);
+		new_page.texture = texture;
+		new_page.height = 0;
+		m_pages.push_back(new_page);
+	}
+
+	shelf.y = m_pages[page].height;
+	shelf.height = shelf_height;
+	shelf.x = 0;
+	m_pages[page].shelves.push_back(shelf);
+	m_pages[page].height += shelf_height;
+	slot.page = page;
+	slot.shelf = m_pages[page].shelves.size() - 1;
+	return true;
+}
+
+bool TextureAtlas::evict(void)
+{
+	std::unordered_map<std::string, Slot>::iterator iter;
+	std::vector<Gap>::iterator gap_iter;
+	Gap gap;
+
+	if (m_lru.empty())
+	{
+		return false;
+	}
+	iter = m_slots.find(m_lru.front());
+	m_lru.pop_front();
+	if (iter == m_slots.end())
+	{
+		return true;
+	}
+
+	Page& page = m_pages[iter->second.page];
+	Shelf& shelf = page.shelves[iter->second.shelf];
+	gap.x = iter->second.rect.left - TEXTURE_ATLAS_PADDING;
+	gap.width = iter->second.rect.width + TEXTURE_ATLAS_PADDING * 2;
+	m_slots.erase(iter);
+	++m_evictions;
+
+	// Insertamos el hueco ordenado y lo unimos con los huecos contiguos
+	gap_iter = shelf.gaps.begin();
+	while ((gap_iter != shelf.gaps.end()) && (gap_iter->x < gap.x))
+	{
+		++gap_iter;
+	}
+	gap_iter = shelf.gaps.insert(gap_iter, gap);
+	if ((gap_iter + 1 != shelf.gaps.end()) && (gap_iter->x + gap_iter->width == (gap_iter + 1)->x))
+	{
+		gap_iter->width += (gap_iter + 1)->width;
+		shelf.gaps.erase(gap_iter + 1);
+	}
+	if ((gap_iter != shelf.gaps.begin()) && ((gap_iter - 1)->x + (gap_iter - 1)->width == gap_iter->x))
+	{
+		(gap_iter - 1)->width += gap_iter->width;
+		gap_iter = shelf.gaps.erase(gap_iter) - 1;
+	}
+	// Un hueco al final del estante se devuelve al espacio libre
+	if (gap_iter->x + gap_iter->width == shelf.x)
+	{
+		shelf.x = gap_iter->x;
+		shelf.gaps.erase(gap_iter);
+	}
+	// Los estantes vacíos del final de la página se devuelven a la página
+	// para que se puedan crear con otra altura
+	while (!page.shelves.empty() && (page.shelves.back().x == 0))
+	{
+		page.height = page.shelves.back().y;
+		page.shelves.pop_back();
+	}
+	return true;
+}
+
+} // namespace bmonkey
@@ -0,0 +1,218 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _TEXTURE_ATLAS_HPP_
+#define _TEXTURE_ATLAS_HPP_
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+
+namespace bmonkey{
+
+/**
+ * Atlas dinámico de texturas
+ *
+ * Empaqueta imágenes pequeñas, como los wheels o los iconos del interfaz,
+ * dentro de unas pocas texturas grandes (páginas), de forma que los elementos
+ * que comparten página se pueden dibujar sin cambiar de textura.
+ * Cada página se divide en estantes horizontales que se van llenando de
+ * izquierda a derecha. Las imágenes sin referencias permanecen en el atlas
+ * hasta que se necesita su hueco para otra, momento en que se desalojan las
+ * usadas hace más tiempo.
+ */
+class TextureAtlas
+{
+public:
+	/**
+	 * Constructor parametrizado
+	 * @param page_size Tamaño en pixels del lado de cada página
+	 * @param max_pages Número máximo de páginas del atlas
+	 */
+	TextureAtlas(const unsigned int page_size, const unsigned int max_pages);
+
+	/**
+	 * Destructor de la clase
+	 */
+	~TextureAtlas(void);
+
+	/**
+	 * Agrega una imagen al atlas
+	 * @param key Clave de la imagen, normalmente el path de su fichero
+	 * @param image Imagen a agregar
+	 * @param rect Devuelve la región de la página que ocupa la imagen
+	 * @return Página donde se ha colocado la imagen o null si la imagen es
+	 * demasiado grande o no queda sitio en el atlas
+	 * @note La imagen queda con una referencia
+	 */
+	sf::Texture* add(const std::string& key, const sf::Image& image, sf::IntRect& rect);
+
+	/**
+	 * Añade una referencia a una imagen del atlas
+	 * @param key Clave de la imagen
+	 * @param rect Devuelve la región de la página que ocupa la imagen
+	 * @return Página donde se encuentra la imagen o null si no está en el atlas
+	 */
+	sf::Texture* acquire(const std::string& key, sf::IntRect& rect);
+
+	/**
+	 * Quita una referencia a una imagen del atlas
+	 * @param key Clave de la imagen
+	 * @return true si la imagen estaba en el atlas, false en otro caso
+	 * @note La imagen sin referencias se conserva hasta que se necesita su
+	 * hueco
+	 */
+	bool release(const std::string& key);
+
+	/**
+	 * Reemplaza el contenido de una imagen del atlas
+	 * @param key Clave de la imagen
+	 * @param image Nueva imagen
+	 * @return true si se actualizó, false si no está en el atlas o su tamaño
+	 * ha cambiado
+	 */
+	bool update(const std::string& key, const sf::Image& image);
+
+	/**
+	 * Indica si una imagen está en el atlas
+	 * @param key Clave de la imagen
+	 * @return true si la imagen está en el atlas, false en otro caso
+	 */
+	bool contains(const std::string& key) const;
+
+	/**
+	 * Indica si una imagen se puede agregar al atlas por su tamaño
+	 * @param size Tamaño de la imagen
+	 * @return true si la imagen cabe en el atlas, false en otro caso
+	 */
+	bool fits(const sf::Vector2u& size) const;
+
+	/**
+	 * Activa o desactiva el filtro de suavizado en las páginas
+	 * @param smooth Indica si se debe activar o no el filtro
+	 */
+	void setSmooth(const bool smooth);
+
+	/**
+	 * Obtiene el número de páginas creadas
+	 * @return Número de páginas
+	 */
+	unsigned int getPageCount(void) const;
+
+	/**
+	 * Obtiene el número de imágenes del atlas
+	 * @return Número de imágenes, con o sin referencias
+	 */
+	unsigned int getImageCount(void) const;
+
+	/**
+	 * Obtiene la memoria ocupada por las páginas del atlas
+	 * @return Número de bytes de memoria de textura ocupados
+	 */
+	std::size_t getMemoryUsage(void) const;
+
+	/**
+	 * Obtiene el número de imágenes desalojadas para hacer sitio
+	 * @return Número de imágenes desalojadas
+	 */
+	unsigned int getEvictions(void) const;
+
+	/**
+	 * Libera todas las imágenes y páginas del atlas
+	 */
+	void clear(void);
+
+private:
+	// Hueco libre dentro de un estante
+	struct Gap
+	{
+		unsigned int x;				/**< Posición horizontal del hueco */
+		unsigned int width;			/**< Anchura del hueco */
+	};
+
+	// Fila de imágenes de igual o menor altura
+	struct Shelf
+	{
+		unsigned int y;				/**< Posición vertical del estante */
+		unsigned int height;		/**< Altura del estante */
+		unsigned int x;				/**< Posición del espacio libre del final */
+		std::vector<Gap> gaps;		/**< Huecos libres por desalojos */
+	};
+
+	// Textura grande que contiene las imágenes
+	struct Page
+	{
+		sf::Texture* texture;		/**< Textura de la página */
+		unsigned int height;		/**< Altura ocupada por los estantes */
+		std::vector<Shelf> shelves;	/**< Estantes de la página */
+	};
+
+	// Imagen colocada en el atlas
+	struct Slot
+	{
+		unsigned int page;			/**< Página de la imagen */
+		unsigned int shelf;			/**< Estante de la imagen */
+		sf::IntRect rect;			/**< Región de la imagen en la página */
+		unsigned int count;			/**< Número de referencias */
+		std::list<std::string>::iterator lru;	/**< Posición entre las imágenes sin referencias */
+	};
+
+	/**
+	 * Busca y reserva un hueco para una imagen en los estantes existentes
+	 * @param size Tamaño de la imagen
+	 * @param tight Indica si solo se admiten estantes de altura parecida
+	 * @param slot Devuelve la página, estante y región reservada
+	 * @return true si se encontró hueco, false en otro caso
+	 */
+	bool find(const sf::Vector2u& size, const bool tight, Slot& slot);
+
+	/**
+	 * Crea un nuevo estante en alguna página con sitio, creando una nueva
+	 * página si es necesario y posible
+	 * @param height Altura necesaria incluyendo la separación
+	 * @param slot Devuelve la página y estante creados
+	 * @return true si se pudo crear el estante, false en otro caso
+	 */
+	bool addShelf(const unsigned int height, Slot& slot);
+
+	/**
+	 * Desaloja la imagen sin referencias usada hace más tiempo
+	 * @return true si se desalojó una imagen, false si no había ninguna
+	 */
+	bool evict(void);
+
+	unsigned int m_page_size;			/**< Lado de cada página */
+	unsigned int m_max_pages;			/**< Máximo de páginas */
+	bool m_smooth;						/**< Suavizado de las páginas */
+	std::vector<Page> m_pages;			/**< Páginas del atlas */
+	std::unordered_map<std::string, Slot> m_slots;	/**< Imágenes del atlas */
+	std::list<std::string> m_lru;		/**< Imágenes sin referencias, de la más antigua a la más reciente */
+	unsigned int m_evictions;			/**< Imágenes desalojadas */
+};
+
+// Inclusión de los métodos inline
+#include "texture_atlas.inl"
+
+} // namespace bmonkey
+
+#endif // _TEXTURE_ATLAS_HPP_
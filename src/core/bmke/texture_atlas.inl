@@ -0,0 +1,50 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _TEXTURE_ATLAS_INL_
+#define _TEXTURE_ATLAS_INL_
+
+inline bool TextureAtlas::contains(const std::string& key) const
+{
+	return (m_slots.find(key) != m_slots.end());
+}
+
+inline unsigned int TextureAtlas::getPageCount(void) const
+{
+	return m_pages.size();
+}
+
+inline unsigned int TextureAtlas::getImageCount(void) const
+{
+	return m_slots.size();
+}
+
+inline std::size_t TextureAtlas::getMemoryUsage(void) const
+{
+	return static_cast<std::size_t>(m_page_size) * m_page_size * 4 * m_pages.size();
+}
+
+inline unsigned int TextureAtlas::getEvictions(void) const
+{
+	return m_evictions;
+}
+
+#endif // _TEXTURE_ATLAS_INL_
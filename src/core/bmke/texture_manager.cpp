@@ -21,13 +21,33 @@
 
 #include "texture_manager.hpp"
 #include <cassert>
+#include "../../utils/utils.hpp"
+#include "../../utils/log.hpp"
+
+// Número de hilos para la decodificación de imágenes en segundo plano
+#define TEXTURE_MANAGER_THREADS 2
+// Memoria de textura permitida por defecto (64MB)
+#define TEXTURE_MANAGER_DEFAULT_BUDGET (64 * 1024 * 1024)
+// Lado de las páginas del atlas de texturas
+#define TEXTURE_MANAGER_ATLAS_SIZE 1024
+// Número máximo de páginas del atlas de texturas (16MB)
+#define TEXTURE_MANAGER_ATLAS_PAGES 4
 
 namespace bmonkey{
 
 bool TextureManager::m_instantiated = false;
 
 TextureManager::TextureManager(void):
-	m_smooth(false)
+	m_smooth(false),
+	m_compression(false),
+	m_placeholder(nullptr),
+	m_budget(TEXTURE_MANAGER_DEFAULT_BUDGET),
+	m_bytes(0),
+	m_hits(0),
+	m_misses(0),
+	m_evictions(0),
+	m_atlas(TEXTURE_MANAGER_ATLAS_SIZE, TEXTURE_MANAGER_ATLAS_PAGES),
+	m_pool(TEXTURE_MANAGER_THREADS)
 {
 	// Con este assert forzamos una instancia única de la clase
 	assert(!m_instantiated);
@@ -37,11 +57,12 @@ TextureManager::TextureManager(void):
 TextureManager::~TextureManager(void)
 {
 	clean();
+	delete m_placeholder;
 	// Si se destruye la instancia, permitimos que se cree de nuevo
 	m_instantiated = false;
 }
 
-sf::Texture* TextureManager::loadTexture(const Glib::ustring& file, const bool repeated)
+sf::Texture* TextureManager::loadTexture(const Glib::ustring& file, const bool repeated, const sf::Vector2u& size)
 {
 	std::unordered_map<std::string, Resource >::iterator iter;
 	Resource resource;
@@ -52,19 +73,34 @@ sf::Texture* TextureManager::loadTexture(const Glib::ustring& file, const bool r
 	}
 
 	// Comprobamos si ya tenemos la textura cargada
-	iter = m_textures.find(file);
+	iter = m_textures.find(getKey(file, size));
 	if (iter != m_textures.end() )
 	{
+		// Si se está cargando en segundo plano la cargamos ya, el resultado
+		// de la decodificación se descartará
+		if (!iter->second.ready)
+		{
+			if (!loadSource(*iter->second.texture, iter->second.file, iter->second.size, iter->second.compressed))
+			{
+				return nullptr;
+			}
+			iter->second.texture->setSmooth(m_smooth);
+			iter->second.ready = true;
+			applyMipmap(iter->second);
+			updateBytes(iter->second);
+		}
 		// Incrementamos contador de referencias
-		++iter->second.count;
+		acquire(iter->second);
 		iter->second.texture->setRepeated(repeated);
 		return iter->second.texture;
 	}
 	else
 	{
 		resource.texture = new sf::Texture();
+		resource.file = file.raw();
+		resource.size = ThumbnailCache::getBucket(size);
 		// Cargamos la nueva textura y la almacenamos
-		if (!resource.texture->loadFromFile(file))
+		if (!loadSource(*resource.texture, resource.file, resource.size, resource.compressed))
 		{
 			delete resource.texture;
 			return nullptr;
@@ -72,15 +108,134 @@ sf::Texture* TextureManager::loadTexture(const Glib::ustring& file, const bool r
 		else
 		{
 			resource.count = 1;
+			resource.ready = true;
+			resource.bytes = 0;
+			resource.mipmap = false;
+			resource.atlas = false;
+			resource.page = nullptr;
 			resource.texture->setRepeated(repeated);
 			resource.texture->setSmooth(m_smooth);
-			m_textures[file] = resource;
+			iter = m_textures.insert(std::make_pair(getKey(file, size), resource)).first;
+			applyMipmap(iter->second);
+			updateBytes(iter->second);
+			++m_misses;
+			evict();
 		}
 		return resource.texture;
 	}
 }
 
-sf::Texture* TextureManager::getTexture(const Glib::ustring& file)
+TextureManager::Handle TextureManager::loadTextureAsync(const Glib::ustring& file, const bool repeated, const sf::Vector2u& size)
+{
+	std::unordered_map<std::string, Resource >::iterator iter;
+	Resource resource;
+	std::string key;
+
+	if (file.empty())
+	{
+		return Handle();
+	}
+
+	key = getKey(file, size);
+	iter = m_textures.find(key);
+	if (iter != m_textures.end())
+	{
+		acquire(iter->second);
+		iter->second.texture->setRepeated(repeated);
+		return Handle(&iter->second, getPlaceholder());
+	}
+
+	// Registramos la textura vacía y encargamos la decodificación
+	++m_misses;
+	resource.count = 1;
+	resource.ready = false;
+	resource.bytes = 0;
+	resource.mipmap = false;
+	resource.compressed = 0;
+	resource.atlas = false;
+	resource.page = nullptr;
+	resource.file = file.raw();
+	resource.size = ThumbnailCache::getBucket(size);
+	resource.texture = new sf::Texture();
+	resource.texture->setRepeated(repeated);
+	resource.texture->setSmooth(m_smooth);
+	iter = m_textures.insert(std::make_pair(key, resource)).first;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pending.insert(key);
+	}
+	m_pool.addTask(std::bind(&TextureManager::decode, this, key, resource.file, resource.size, m_compression));
+	return Handle(&iter->second, getPlaceholder());
+}
+
+TextureManager::Handle TextureManager::loadAtlasTextureAsync(const Glib::ustring& file)
+{
+	std::unordered_map<std::string, Resource >::iterator iter;
+	Resource resource;
+	std::string key;
+
+	if (file.empty())
+	{
+		return Handle();
+	}
+
+	key = getAtlasKey(file);
+	iter = m_textures.find(key);
+	if (iter != m_textures.end())
+	{
+		acquire(iter->second);
+		return Handle(&iter->second, getPlaceholder());
+	}
+
+	resource.count = 1;
+	resource.ready = false;
+	resource.bytes = 0;
+	resource.mipmap = false;
+	resource.compressed = 0;
+	resource.atlas = true;
+	resource.file = file.raw();
+	resource.size = sf::Vector2u(0, 0);
+	resource.texture = new sf::Texture();
+	resource.texture->setSmooth(m_smooth);
+	// Si la imagen sigue en el atlas no hace falta volver a decodificarla
+	resource.page = m_atlas.acquire(file, resource.rect);
+	if (resource.page)
+	{
+		++m_hits;
+		resource.ready = true;
+		iter = m_textures.insert(std::make_pair(key, resource)).first;
+		return Handle(&iter->second, getPlaceholder());
+	}
+
+	// Registramos la imagen vacía y encargamos la decodificación. Se coloca
+	// en el atlas al subirla en update
+	++m_misses;
+	iter = m_textures.insert(std::make_pair(key, resource)).first;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pending.insert(key);
+	}
+	m_pool.addTask(std::bind(&TextureManager::decode, this, key, resource.file, resource.size, false));
+	return Handle(&iter->second, getPlaceholder());
+}
+
+void TextureManager::deleteAtlasTexture(const Glib::ustring& file)
+{
+	std::unordered_map<std::string, Resource >::iterator iter;
+
+	if (file.empty())
+	{
+		return;
+	}
+
+	iter = m_textures.find(getAtlasKey(file));
+	if (iter != m_textures.end())
+	{
+		release(iter);
+	}
+}
+
+sf::Texture* TextureManager::getTexture(const Glib::ustring& file, const sf::Vector2u& size)
 {
 	std::unordered_map<std::string, Resource >::iterator iter;
 
@@ -90,7 +245,7 @@ sf::Texture* TextureManager::getTexture(const Glib::ustring& file)
 	}
 
 	// Buscamos la textura
-	iter = m_textures.find(file);
+	iter = m_textures.find(getKey(file, size));
 	if (iter != m_textures.end() )
 	{
 		return iter->second.texture;
@@ -101,7 +256,63 @@ sf::Texture* TextureManager::getTexture(const Glib::ustring& file)
 	}
 }
 
-void TextureManager::deleteTexture(const Glib::ustring& file)
+bool TextureManager::reloadTexture(const Glib::ustring& file)
+{
+	std::unordered_map<std::string, Resource >::iterator iter;
+	sf::Texture texture;
+	sf::Image image;
+	bool reloaded = false;
+
+	if (file.empty())
+	{
+		return false;
+	}
+
+	// Las imágenes del atlas solo se pueden recargar si conservan su tamaño
+	if (m_atlas.contains(file))
+	{
+		reloaded = (image.loadFromFile(file) && m_atlas.update(file, image));
+	}
+
+	// Recargamos la textura completa y todas sus versiones reducidas. Las
+	// colocadas en el atlas ya se han recargado en él
+	for (iter = m_textures.begin(); iter != m_textures.end(); ++iter)
+	{
+		if ((iter->second.file != file.raw()) || iter->second.page)
+		{
+			continue;
+		}
+		// Las versiones comprimidas se recargan sobre su textura, ya que la
+		// copia de texturas de SFML las convertiría a RGBA
+		if (m_compression && (iter->second.size.x != 0))
+		{
+			if (!loadSource(*iter->second.texture, iter->second.file, iter->second.size, iter->second.compressed))
+			{
+				continue;
+			}
+		}
+		// El resto se cargan sobre una textura temporal para conservar la
+		// actual si falla
+		else
+		{
+			if (!loadSource(texture, iter->second.file, iter->second.size, iter->second.compressed))
+			{
+				continue;
+			}
+			texture.setRepeated(iter->second.texture->isRepeated());
+			texture.setSmooth(m_smooth);
+			*iter->second.texture = texture;
+		}
+		iter->second.ready = true;
+		applyMipmap(iter->second);
+		updateBytes(iter->second);
+		reloaded = true;
+	}
+	evict();
+	return reloaded;
+}
+
+void TextureManager::deleteTexture(const Glib::ustring& file, const sf::Vector2u& size)
 {
 	std::unordered_map<std::string, Resource >::iterator iter;
 
@@ -111,40 +322,392 @@ void TextureManager::deleteTexture(const Glib::ustring& file)
 	}
 
 	// Buscamos la textura
-	iter = m_textures.find(file);
+	iter = m_textures.find(getKey(file, size));
 	if (iter != m_textures.end() )
 	{
-		// Decrementamos el contador de referencias
-		--iter->second.count;
-		// Si no hay más referencias descargamos la textura
-		if (iter->second.count == 0)
+		release(iter);
+	}
+}
+
+int TextureManager::update(const sf::Time time_limit)
+{
+	std::unordered_map<std::string, Resource >::iterator iter;
+	std::vector<Decoded> decoded;
+	std::vector<Decoded>::iterator decoded_iter;
+	sf::Clock clock;
+	bool loaded;
+	int count = 0;
+
+	// Recogemos las imágenes decodificadas bloqueando lo mínimo a los hilos
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_decoded.empty())
 		{
-			delete iter->second.texture;
-			m_textures.erase(iter);
+			return 0;
+		}
+		decoded.swap(m_decoded);
+	}
+	for (decoded_iter = decoded.begin(); decoded_iter != decoded.end(); ++decoded_iter)
+	{
+		// Las que no entren en el tiempo disponible quedan para otro frame
+		if ((count > 0) && (clock.getElapsedTime() >= time_limit))
+		{
+			break;
+		}
+		iter = m_textures.find(decoded_iter->file);
+		if ((iter != m_textures.end()) && !iter->second.ready)
+		{
+			loaded = false;
+			if (decoded_iter->compressed)
+			{
+				loaded = uploadCompressed(*iter->second.texture, *decoded_iter->compressed, iter->second.compressed);
+				// Si la tarjeta rechaza la imagen comprimida encargamos de
+				// nuevo su decodificación sin comprimir, sin bloquear el frame
+				if (!loaded)
+				{
+					{
+						std::lock_guard<std::mutex> lock(m_mutex);
+						m_pending.insert(iter->first);
+					}
+					m_pool.addTask(std::bind(&TextureManager::decode, this, iter->first, iter->second.file, iter->second.size, false));
+				}
+			}
+			else if (decoded_iter->image)
+			{
+				// Las imágenes pequeñas se colocan en el atlas si queda sitio
+				if (iter->second.atlas)
+				{
+					iter->second.page = m_atlas.add(iter->second.file, *decoded_iter->image, iter->second.rect);
+				}
+				loaded = iter->second.page || iter->second.texture->loadFromImage(*decoded_iter->image);
+			}
+			if (loaded)
+			{
+				iter->second.texture->setSmooth(m_smooth);
+				iter->second.ready = true;
+				applyMipmap(iter->second);
+				updateBytes(iter->second);
+				++count;
+			}
 		}
+		delete decoded_iter->image;
+		delete decoded_iter->compressed;
+	}
+	if (decoded_iter != decoded.end())
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_decoded.insert(m_decoded.begin(), decoded_iter, decoded.end());
+	}
+	if (count > 0)
+	{
+		evict();
+	}
+	return count;
+}
+
+bool TextureManager::setPlaceholder(const Glib::ustring& file)
+{
+	sf::Texture* texture;
+
+	texture = getPlaceholder();
+	if (!texture->loadFromFile(file))
+	{
+		return false;
 	}
+	texture->setSmooth(m_smooth);
+	return true;
+}
+
+sf::Texture* TextureManager::getPlaceholder(void)
+{
+	sf::Image image;
+
+	// Se crea bajo demanda, necesita el contexto de la ventana
+	if (!m_placeholder)
+	{
+		image.create(1, 1, sf::Color::Transparent);
+		m_placeholder = new sf::Texture();
+		m_placeholder->loadFromImage(image);
+	}
+	return m_placeholder;
+}
+
+void TextureManager::setMemoryBudget(const std::size_t bytes)
+{
+	m_budget = bytes;
+	evict();
+}
+
+void TextureManager::resetStats(void)
+{
+	m_hits = 0;
+	m_misses = 0;
+	m_evictions = 0;
 }
 
 void TextureManager::setSmooth(const bool smooth)
 {
 	std::unordered_map<std::string, Resource >::iterator iter;
 
+	m_smooth = smooth;
 	for (iter = m_textures.begin(); iter != m_textures.end(); ++iter)
 	{
 		iter->second.texture->setSmooth(smooth);
+		// Al activar el suavizado las versiones reducidas necesitan mipmaps
+		if (iter->second.ready && !iter->second.mipmap)
+		{
+			applyMipmap(iter->second);
+			updateBytes(iter->second);
+		}
 	}
-	m_smooth = smooth;
+	if (m_placeholder)
+	{
+		m_placeholder->setSmooth(smooth);
+	}
+	m_atlas.setSmooth(smooth);
 }
 
 void TextureManager::clean(void)
 {
 	std::unordered_map<std::string, Resource >::iterator iter;
+	std::vector<Decoded>::iterator decoded_iter;
+
+	// Descartamos las cargas en segundo plano
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pending.clear();
+	}
+	m_pool.clear();
+	m_pool.wait();
+	for (decoded_iter = m_decoded.begin(); decoded_iter != m_decoded.end(); ++decoded_iter)
+	{
+		delete decoded_iter->image;
+		delete decoded_iter->compressed;
+	}
+	m_decoded.clear();
 
 	for (iter = m_textures.begin(); iter != m_textures.end(); ++iter)
 	{
 		delete iter->second.texture;
 	}
 	m_textures.clear();
+	m_lru.clear();
+	m_bytes = 0;
+	m_atlas.clear();
+}
+
+void TextureManager::acquire(Resource& resource)
+{
+	// Si no tenía referencias estaba en la caché, deja de ser desalojable
+	if (resource.count == 0)
+	{
+		m_lru.erase(resource.lru);
+	}
+	++resource.count;
+	++m_hits;
+}
+
+void TextureManager::release(std::unordered_map<std::string, Resource >::iterator iter)
+{
+	// Decrementamos el contador de referencias
+	--iter->second.count;
+	if (iter->second.count > 0)
+	{
+		return;
+	}
+	// Si no hay más referencias y no se ha terminado de cargar la descargamos
+	// cancelando su decodificación
+	if (!iter->second.ready)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pending.erase(iter->first);
+		}
+		delete iter->second.texture;
+		m_textures.erase(iter);
+		return;
+	}
+	// Las imágenes del atlas las conserva el propio atlas hasta que necesita
+	// su hueco
+	if (iter->second.page)
+	{
+		m_atlas.release(iter->second.file);
+		delete iter->second.texture;
+		m_textures.erase(iter);
+		return;
+	}
+	// En otro caso la conservamos en la caché como la más reciente
+	iter->second.lru = m_lru.insert(m_lru.end(), iter->first);
+	evict();
+}
+
+void TextureManager::updateBytes(Resource& resource)
+{
+	sf::Vector2u size;
+
+	// Las texturas se almacenan en la tarjeta como RGBA de 8 bits
+	size = resource.texture->getSize();
+	m_bytes -= resource.bytes;
+	resource.bytes = static_cast<std::size_t>(size.x) * size.y * 4;
+	if (resource.compressed > 0)
+	{
+		resource.bytes = resource.compressed;
+	}
+	// Los mipmaps ocupan un tercio más
+	else if (resource.mipmap)
+	{
+		resource.bytes += resource.bytes / 3;
+	}
+	m_bytes += resource.bytes;
+}
+
+void TextureManager::applyMipmap(Resource& resource)
+{
+	resource.mipmap = false;
+	// Solo las versiones reducidas se dibujan escaladas. Las comprimidas no
+	// los admiten en todas las tarjetas
+	if (!m_smooth || (resource.size.x == 0) || (resource.compressed > 0))
+	{
+		return;
+	}
+#if (SFML_VERSION_MAJOR > 2) || ((SFML_VERSION_MAJOR == 2) && (SFML_VERSION_MINOR >= 4))
+	resource.mipmap = resource.texture->generateMipmap();
+#endif
+}
+
+bool TextureManager::loadSource(sf::Texture& texture, const std::string& file, const sf::Vector2u& size, std::size_t& compressed)
+{
+	CompressedImage compressed_image;
+	sf::Image image;
+
+	compressed = 0;
+	if (size.x == 0)
+	{
+		return texture.loadFromFile(file);
+	}
+	if (m_compression && m_thumbnails.loadCompressed(file, size, compressed_image) &&
+		uploadCompressed(texture, compressed_image, compressed))
+	{
+		return true;
+	}
+	return (m_thumbnails.load(file, size, image) && texture.loadFromImage(image));
+}
+
+bool TextureManager::uploadCompressed(sf::Texture& texture, const CompressedImage& image, std::size_t& compressed)
+{
+	compressed = 0;
+	if (!image.upload(texture))
+	{
+		// No insistimos con una tarjeta que rechaza las texturas comprimidas
+		LOG_ERROR("TextureManager: Can't upload compressed texture, falling back to RGBA");
+		m_compression = false;
+		return false;
+	}
+	compressed = image.getDataSize();
+	return true;
+}
+
+bool TextureManager::setCompression(const bool compression)
+{
+	m_compression = compression && CompressedImage::isSupported();
+	if (compression && !m_compression)
+	{
+		LOG_INFO("TextureManager: Compressed textures not supported, using RGBA");
+	}
+	return m_compression;
+}
+
+std::string TextureManager::getKey(const Glib::ustring& file, const sf::Vector2u& size)
+{
+	sf::Vector2u bucket;
+
+	// Las versiones reducidas se indexan junto con su tamaño redondeado
+	bucket = ThumbnailCache::getBucket(size);
+	if ((bucket.x == 0) || (bucket.y == 0))
+	{
+		return file.raw();
+	}
+	return file.raw() + "#" + utils::toStr(bucket.x).raw() + "x" + utils::toStr(bucket.y).raw();
+}
+
+std::string TextureManager::getAtlasKey(const Glib::ustring& file)
+{
+	// Se distinguen de la textura completa de la misma imagen
+	return file.raw() + "#atlas";
+}
+
+void TextureManager::evict(void)
+{
+	std::unordered_map<std::string, Resource >::iterator iter;
+
+	while ((m_bytes > m_budget) && !m_lru.empty())
+	{
+		iter = m_textures.find(m_lru.front());
+		m_lru.pop_front();
+		if (iter != m_textures.end())
+		{
+			m_bytes -= iter->second.bytes;
+			delete iter->second.texture;
+			m_textures.erase(iter);
+			++m_evictions;
+		}
+	}
+}
+
+void TextureManager::decode(const std::string key, const std::string file, const sf::Vector2u size, const bool compression)
+{
+	Decoded decoded;
+	bool loaded;
+
+	// Comprobamos que no se haya cancelado mientras esperaba
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_pending.find(key) == m_pending.end())
+		{
+			return;
+		}
+	}
+	decoded.file = key;
+	decoded.image = nullptr;
+	decoded.compressed = nullptr;
+	// Las versiones reducidas se preparan comprimidas si está activado
+	if (compression && (size.x != 0))
+	{
+		decoded.compressed = new CompressedImage();
+		if (!m_thumbnails.loadCompressed(file, size, *decoded.compressed))
+		{
+			delete decoded.compressed;
+			decoded.compressed = nullptr;
+		}
+	}
+	else
+	{
+		decoded.image = new sf::Image();
+		if (size.x == 0)
+		{
+			loaded = decoded.image->loadFromFile(file);
+		}
+		else
+		{
+			loaded = m_thumbnails.load(file, size, *decoded.image);
+		}
+		if (!loaded)
+		{
+			delete decoded.image;
+			decoded.image = nullptr;
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		// Si se canceló durante la decodificación descartamos la imagen
+		if (m_pending.erase(key) == 0)
+		{
+			delete decoded.image;
+			delete decoded.compressed;
+			return;
+		}
+		m_decoded.push_back(decoded);
+	}
 }
 
 } // namespace bmonkey
@@ -25,7 +25,14 @@
 #include <SFML/Graphics.hpp>
 #include <glibmm/ustring.h>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <list>
+#include <mutex>
 #include "../../defines.hpp"
+#include "../../utils/thread_pool.hpp"
+#include "texture_atlas.hpp"
+#include "thumbnail_cache.hpp"
 
 namespace bmonkey{
 
@@ -36,12 +43,87 @@ namespace bmonkey{
  * frontend.
  * Actua como una especie de almacén para las texturas que se van cargando desde
  * fichero, proporcionando métodos para su carga y descarga.
+ * Las texturas pueden cargarse en segundo plano: la decodificación de la
+ * imagen se realiza en hilos de trabajo y la subida a la tarjeta gráfica se
+ * completa en el hilo de render mediante update, con un límite de tiempo por
+ * frame.
+ * Las texturas sin referencias se conservan como caché hasta que la memoria
+ * ocupada por todas las texturas supera el presupuesto establecido, momento en
+ * que se liberan las usadas hace más tiempo.
+ * Las imágenes pequeñas, como los wheels, pueden cargarse en un atlas que las
+ * agrupa en unas pocas texturas grandes para dibujarlas sin cambiar de
+ * textura. Se decodifican en los mismos hilos y se colocan en el atlas al
+ * subirlas.
+ * Las texturas que se dibujan a un tamaño menor que el de su imagen pueden
+ * cargarse a partir de una versión reducida, generada una única vez y
+ * guardada en disco por la caché de miniaturas. Opcionalmente esas versiones
+ * se guardan y suben a la tarjeta comprimidas, si la tarjeta lo soporta.
  * Únicamente permite una instancia de la clase al mismo tiempo.
  */
 class TextureManager
 {
+private:
+	// Declaración adelantada del recurso de cada textura
+	struct Resource;
+
 public:
 
+	/**
+	 * Referencia a una textura cargada en segundo plano.
+	 *
+	 * Mientras la textura no está lista devuelve la textura provisional del
+	 * manager. La referencia es válida hasta que se elimina la textura del
+	 * manager con deleteTexture.
+	 */
+	class Handle
+	{
+	public:
+		/**
+		 * Constructor básico, crea una referencia vacía
+		 */
+		Handle(void);
+
+		/**
+		 * Indica si la referencia apunta a alguna textura
+		 * @return true si la referencia es válida, false en otro caso
+		 */
+		bool isValid(void) const;
+
+		/**
+		 * Indica si la textura ya se ha cargado
+		 * @return true si la textura está lista, false en otro caso
+		 */
+		bool isReady(void) const;
+
+		/**
+		 * Obtiene la textura referenciada
+		 * @return La textura si está lista, la textura provisional si aún se
+		 * está cargando o null si la referencia no es válida
+		 */
+		sf::Texture* getTexture(void) const;
+
+		/**
+		 * Obtiene la región de la textura que ocupa la imagen referenciada
+		 * @return Región de la imagen dentro de la página del atlas, o la
+		 * textura completa si no está en el atlas o aún se está cargando
+		 */
+		sf::IntRect getRect(void) const;
+
+	private:
+		// El manager es el único que crea referencias válidas
+		friend class TextureManager;
+
+		/**
+		 * Constructor parametrizado
+		 * @param resource Recurso de la textura referenciada
+		 * @param placeholder Textura provisional mientras se carga
+		 */
+		Handle(Resource* resource, sf::Texture* placeholder);
+
+		Resource* m_resource;			/**< Recurso de la textura */
+		sf::Texture* m_placeholder;		/**< Textura provisional */
+	};
+
 	/**
 	 * Constructor de la clase
 	 */
@@ -56,26 +138,193 @@ public:
 	 * Carga una textura en el manager y la devuelve
 	 * @param file Path del fichero de la textura
 	 * @param repeated Indica si la textura se debe repetir en el eje x e y
+	 * @param size Tamaño al que se dibujará la textura o cero para cargarla a
+	 * su resolución original
 	 * @return Textura cargada o null si no se pudo cargar
 	 * @note Si la textura ya existe en el manager, no volverá a cargarla
+	 * @note Con un tamaño dado se carga una versión reducida de la imagen que
+	 * quepa en él, con mipmaps si el suavizado está activado. Cada tamaño es
+	 * una textura distinta en el manager
 	 * @note La lista de formatos de imagenes soportados es la siguiente: bmp,
 	 * png, tga, jpg, gif, psd, hdr y pic. Algunas opciones de determinados
 	 * formatos no son soportadas, como el jpeg progresivo
 	 */
-	sf::Texture* loadTexture(const Glib::ustring& file, const bool repeated = false);
+	sf::Texture* loadTexture(const Glib::ustring& file, const bool repeated = false, const sf::Vector2u& size = sf::Vector2u(0, 0));
+
+	/**
+	 * Solicita la carga de una textura en segundo plano
+	 * @param file Path del fichero de la textura
+	 * @param repeated Indica si la textura se debe repetir en el eje x e y
+	 * @param size Tamaño al que se dibujará la textura o cero para cargarla a
+	 * su resolución original
+	 * @return Referencia a la textura, que estará lista tras alguna llamada a
+	 * update, o una referencia vacía si el path está vacío
+	 * @note Cuenta como una referencia más de la textura, igual que loadTexture
+	 * @note Si la imagen no se puede leer la referencia nunca estará lista y
+	 * seguirá devolviendo la textura provisional
+	 */
+	Handle loadTextureAsync(const Glib::ustring& file, const bool repeated = false, const sf::Vector2u& size = sf::Vector2u(0, 0));
+
+	/**
+	 * Solicita la carga en segundo plano de una imagen pequeña en el atlas de
+	 * texturas
+	 * @param file Path del fichero de la imagen
+	 * @return Referencia a la imagen, cuya textura y región estarán listas
+	 * tras alguna llamada a update, o una referencia vacía si el path está
+	 * vacío
+	 * @note Si la imagen es demasiado grande o el atlas está lleno se carga
+	 * como una textura independiente y la región ocupa toda la textura
+	 * @note Las imágenes cargadas así se liberan con deleteAtlasTexture
+	 */
+	Handle loadAtlasTextureAsync(const Glib::ustring& file);
+
+	/**
+	 * Libera una imagen cargada con loadAtlasTextureAsync
+	 * @param file Path del fichero de la imagen
+	 * @note La imagen se conserva en el atlas hasta que se necesita su hueco
+	 */
+	void deleteAtlasTexture(const Glib::ustring& file);
+
+	/**
+	 * Establece el directorio donde se guardan las versiones reducidas
+	 * @param dir Directorio de la caché de miniaturas
+	 */
+	void setThumbnailDir(const Glib::ustring& dir);
+
+	/**
+	 * Activa o desactiva el uso de texturas comprimidas para las versiones
+	 * reducidas
+	 * @param compression Indica si se deben usar texturas comprimidas
+	 * @return true si quedan activadas, false si se desactivan o la tarjeta no
+	 * las soporta
+	 * @note Debe llamarse desde el hilo de render con la ventana creada. Solo
+	 * afecta a las texturas que se carguen después
+	 */
+	bool setCompression(const bool compression);
+
+	/**
+	 * Indica si se usan texturas comprimidas para las versiones reducidas
+	 * @return true si se usan texturas comprimidas, false en otro caso
+	 */
+	bool getCompression(void) const;
+
+	/**
+	 * Obtiene la caché de miniaturas del manager
+	 * @return Caché de miniaturas
+	 */
+	ThumbnailCache& getThumbnails(void);
+
+	/**
+	 * Obtiene el atlas de texturas del manager
+	 * @return Atlas de texturas
+	 */
+	const TextureAtlas& getAtlas(void) const;
 
 	/**
 	 * Devuelve una textura indexada por su fichero
 	 * @param file Path del fichero de la textura
+	 * @param size Tamaño con el que se cargó la textura
 	 * @return Textura cargada o null si no se encuentra
 	 */
-	sf::Texture* getTexture(const Glib::ustring& file);
+	sf::Texture* getTexture(const Glib::ustring& file, const sf::Vector2u& size = sf::Vector2u(0, 0));
+
+	/**
+	 * Vuelve a cargar desde su fichero una textura ya cargada
+	 * @param file Path del fichero de la textura
+	 * @return true si se recargó la textura, false si no estaba cargada o no
+	 * se pudo leer el fichero
+	 * @note La textura se recarga sobre la misma instancia, por lo que sus
+	 * usuarios no necesitan volver a obtenerla
+	 * @note También se recargan todas sus versiones reducidas
+	 */
+	bool reloadTexture(const Glib::ustring& file);
 
 	/**
 	 * Elimina una textura del almacen interno del manager
 	 * @param file Path del fichero de la textura
+	 * @param size Tamaño con el que se cargó la textura
+	 * @note Si la textura se estaba cargando en segundo plano, se cancela su
+	 * carga
+	 */
+	void deleteTexture(const Glib::ustring& file, const sf::Vector2u& size = sf::Vector2u(0, 0));
+
+	/**
+	 * Sube a la tarjeta gráfica las imágenes decodificadas en segundo plano
+	 * @param time_limit Tiempo máximo a emplear en la llamada
+	 * @return Número de texturas que han quedado listas
+	 * @note Debe llamarse en cada frame desde el hilo de render. Siempre se
+	 * sube al menos una imagen si hay alguna disponible
+	 */
+	int update(const sf::Time time_limit);
+
+	/**
+	 * Establece la imagen a mostrar mientras se cargan las texturas
+	 * @param file Path del fichero de la imagen provisional
+	 * @return true si se pudo cargar la imagen, false en otro caso
+	 */
+	bool setPlaceholder(const Glib::ustring& file);
+
+	/**
+	 * Obtiene la textura a mostrar mientras se cargan las texturas
+	 * @return Textura provisional, transparente si no se ha establecido otra
+	 */
+	sf::Texture* getPlaceholder(void);
+
+	/**
+	 * Obtiene el número de texturas pendientes de cargar en segundo plano
+	 * @return Número de texturas pendientes
+	 */
+	unsigned int getPendingCount(void);
+
+	/**
+	 * Establece la memoria máxima a ocupar por las texturas
+	 * @param bytes Número de bytes de memoria de textura permitidos
+	 * @note Solo se liberan texturas sin referencias, por lo que las texturas
+	 * en uso pueden superar el presupuesto
 	 */
-	void deleteTexture(const Glib::ustring& file);
+	void setMemoryBudget(const std::size_t bytes);
+
+	/**
+	 * Obtiene la memoria máxima a ocupar por las texturas
+	 * @return Número de bytes de memoria de textura permitidos
+	 */
+	std::size_t getMemoryBudget(void) const;
+
+	/**
+	 * Obtiene la memoria ocupada por las texturas cargadas
+	 * @return Número de bytes de memoria de textura ocupados, incluyendo las
+	 * páginas del atlas
+	 */
+	std::size_t getMemoryUsage(void) const;
+
+	/**
+	 * Obtiene el número de texturas sin referencias conservadas en la caché
+	 * @return Número de texturas en caché
+	 */
+	unsigned int getCachedCount(void) const;
+
+	/**
+	 * Obtiene el número de peticiones de texturas que ya estaban cargadas
+	 * @return Número de aciertos
+	 */
+	unsigned int getHits(void) const;
+
+	/**
+	 * Obtiene el número de peticiones de texturas que hubo que cargar
+	 * @return Número de fallos
+	 */
+	unsigned int getMisses(void) const;
+
+	/**
+	 * Obtiene el número de texturas liberadas por exceder el presupuesto
+	 * @return Número de texturas desalojadas
+	 */
+	unsigned int getEvictions(void) const;
+
+	/**
+	 * Reinicia los contadores de aciertos, fallos y texturas desalojadas
+	 */
+	void resetStats(void);
 
 	/**
 	 * Activa o desactiva el filtro de suavizado en las texturas
@@ -95,14 +344,130 @@ private:
 	{
 		unsigned int count;
 		sf::Texture* texture;
+		bool ready;					/**< Indica si la textura está cargada */
+		std::size_t bytes;			/**< Memoria ocupada por la textura */
+		std::string file;			/**< Path del fichero de la textura */
+		sf::Vector2u size;			/**< Tamaño de la versión reducida o cero */
+		bool mipmap;				/**< Indica si la textura tiene mipmaps */
+		std::size_t compressed;		/**< Memoria ocupada si está comprimida o cero */
+		bool atlas;					/**< Indica si se intenta colocar la imagen en el atlas */
+		sf::Texture* page;			/**< Página del atlas con la imagen o null si no está en él */
+		sf::IntRect rect;			/**< Región de la imagen en la página del atlas */
+		std::list<std::string>::iterator lru;	/**< Posición en la caché si no tiene referencias */
 	};
 
+	// Imagen decodificada por los hilos de trabajo pendiente de subir
+	struct Decoded
+	{
+		std::string file;			/**< Clave de la textura de la imagen */
+		sf::Image* image;			/**< Imagen decodificada o null si falló */
+		CompressedImage* compressed;	/**< Imagen comprimida o null si no se usa o falló */
+	};
+
+	/**
+	 * Añade una referencia a una textura existente, sacándola de la caché si
+	 * no tenía ninguna
+	 * @param resource Recurso de la textura
+	 */
+	void acquire(Resource& resource);
+
+	/**
+	 * Quita una referencia a una textura, conservándola en la caché si se
+	 * queda sin ninguna
+	 * @param iter Posición de la textura en el almacén
+	 * @note Las texturas que no han terminado de cargarse se descartan
+	 * cancelando su carga, y las del atlas se devuelven a éste
+	 */
+	void release(std::unordered_map<std::string, Resource >::iterator iter);
+
+	/**
+	 * Actualiza la memoria ocupada por una textura tras cargarla
+	 * @param resource Recurso de la textura
+	 */
+	void updateBytes(Resource& resource);
+
+	/**
+	 * Genera los mipmaps de una versión reducida si el suavizado está activado
+	 * @param resource Recurso de la textura
+	 */
+	void applyMipmap(Resource& resource);
+
+	/**
+	 * Carga una textura desde su fichero o desde su versión reducida
+	 * @param texture Textura donde se realiza la carga
+	 * @param file Path del fichero de la textura
+	 * @param size Tamaño de la versión reducida o cero para la original
+	 * @param compressed Devuelve la memoria ocupada si se cargó comprimida o
+	 * cero en otro caso
+	 * @return true si se pudo cargar, false en otro caso
+	 */
+	bool loadSource(sf::Texture& texture, const std::string& file, const sf::Vector2u& size, std::size_t& compressed);
+
+	/**
+	 * Sube una imagen comprimida, desactivando la compresión si falla
+	 * @param texture Textura donde se sube la imagen
+	 * @param image Imagen comprimida
+	 * @param compressed Devuelve la memoria ocupada por la textura o cero si
+	 * falló
+	 * @return true si se pudo subir, false en otro caso
+	 */
+	bool uploadCompressed(sf::Texture& texture, const CompressedImage& image, std::size_t& compressed);
+
+	/**
+	 * Obtiene la clave con la que se almacena una textura
+	 * @param file Path del fichero de la textura
+	 * @param size Tamaño pedido para la textura
+	 * @return Clave de la textura
+	 */
+	static std::string getKey(const Glib::ustring& file, const sf::Vector2u& size);
+
+	/**
+	 * Obtiene la clave con la que se almacena una imagen del atlas
+	 * @param file Path del fichero de la imagen
+	 * @return Clave de la imagen
+	 */
+	static std::string getAtlasKey(const Glib::ustring& file);
+
+	/**
+	 * Libera las texturas de la caché usadas hace más tiempo hasta cumplir el
+	 * presupuesto de memoria
+	 */
+	void evict(void);
+
+	/**
+	 * Decodifica una imagen desde un hilo de trabajo
+	 * @param key Clave de la textura
+	 * @param file Path del fichero de la imagen
+	 * @param size Tamaño de la versión reducida o cero para la original
+	 * @param compression Indica si la versión reducida se prepara comprimida
+	 */
+	void decode(const std::string key, const std::string file, const sf::Vector2u size, const bool compression);
+
 	static bool m_instantiated;		/**< Indica si ya hay una instancia de la clase */
 
 	std::unordered_map<std::string, Resource > m_textures;	/**< Almacen de texturas */
 	bool m_smooth;								/**< Indica si se debe aplicar suavizado a las texturas */
+	bool m_compression;							/**< Indica si se usan texturas comprimidas */
+	sf::Texture* m_placeholder;					/**< Textura provisional durante las cargas */
+
+	std::list<std::string> m_lru;				/**< Texturas sin referencias, de la más antigua a la más reciente */
+	std::size_t m_budget;						/**< Memoria de textura permitida */
+	std::size_t m_bytes;						/**< Memoria de textura ocupada */
+	unsigned int m_hits;						/**< Peticiones de texturas ya cargadas */
+	unsigned int m_misses;						/**< Peticiones de texturas no cargadas */
+	unsigned int m_evictions;					/**< Texturas liberadas por el presupuesto */
+	TextureAtlas m_atlas;						/**< Atlas de imágenes pequeñas */
+	ThumbnailCache m_thumbnails;				/**< Caché de versiones reducidas */
+
+	ThreadPool m_pool;							/**< Hilos de decodificación de imágenes */
+	std::mutex m_mutex;							/**< Protección de las cargas en segundo plano */
+	std::unordered_set<std::string> m_pending;	/**< Ficheros pendientes de decodificar */
+	std::vector<Decoded> m_decoded;				/**< Imágenes pendientes de subir */
 };
 
+// Inclusión de los métodos inline
+#include "texture_manager.inl"
+
 } // namespace bmonkey
 
 #endif // _TEXTURE_MANAGER_HPP_
@@ -0,0 +1,132 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _TEXTURE_MANAGER_INL_
+#define _TEXTURE_MANAGER_INL_
+
+inline TextureManager::Handle::Handle(void):
+	m_resource(nullptr),
+	m_placeholder(nullptr)
+{
+}
+
+inline TextureManager::Handle::Handle(Resource* resource, sf::Texture* placeholder):
+	m_resource(resource),
+	m_placeholder(placeholder)
+{
+}
+
+inline bool TextureManager::Handle::isValid(void) const
+{
+	return (m_resource != nullptr);
+}
+
+inline bool TextureManager::Handle::isReady(void) const
+{
+	return (m_resource && m_resource->ready);
+}
+
+inline sf::Texture* TextureManager::Handle::getTexture(void) const
+{
+	if (!m_resource)
+	{
+		return nullptr;
+	}
+	if (!m_resource->ready)
+	{
+		return m_placeholder;
+	}
+	return (m_resource->page ? m_resource->page : m_resource->texture);
+}
+
+inline sf::IntRect TextureManager::Handle::getRect(void) const
+{
+	sf::Texture* texture;
+
+	if (m_resource && m_resource->ready && m_resource->page)
+	{
+		return m_resource->rect;
+	}
+	texture = getTexture();
+	if (!texture)
+	{
+		return sf::IntRect();
+	}
+	return sf::IntRect(0, 0, texture->getSize().x, texture->getSize().y);
+}
+
+inline unsigned int TextureManager::getPendingCount(void)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_pending.size() + m_decoded.size();
+}
+
+inline std::size_t TextureManager::getMemoryBudget(void) const
+{
+	return m_budget;
+}
+
+inline void TextureManager::setThumbnailDir(const Glib::ustring& dir)
+{
+	m_thumbnails.setDir(dir);
+}
+
+inline bool TextureManager::getCompression(void) const
+{
+	return m_compression;
+}
+
+inline ThumbnailCache& TextureManager::getThumbnails(void)
+{
+	return m_thumbnails;
+}
+
+inline const TextureAtlas& TextureManager::getAtlas(void) const
+{
+	return m_atlas;
+}
+
+inline std::size_t TextureManager::getMemoryUsage(void) const
+{
+	return m_bytes + m_atlas.getMemoryUsage();
+}
+
+inline unsigned int TextureManager::getCachedCount(void) const
+{
+	return m_lru.size();
+}
+
+inline unsigned int TextureManager::getHits(void) const
+{
+	return m_hits;
+}
+
+inline unsigned int TextureManager::getMisses(void) const
+{
+	return m_misses;
+}
+
+inline unsigned int TextureManager::getEvictions(void) const
+{
+	return m_evictions;
+}
+
+#endif // _TEXTURE_MANAGER_INL_
@@ -0,0 +1,391 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "thumbnail_cache.hpp"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <glibmm/miscutils.h>
+#include "../../utils/crc32.hpp"
+#include "../../utils/utils.hpp"
+#include "../../utils/log.hpp"
+#include "../../utils/os_detect.hpp"
+#if defined(OS_POSIX)
+	#include <unistd.h>
+#else
+	#include <process.h>
+	#include <thread>
+	#include <sstream>
+#endif
+
+// Múltiplo al que se redondean los tamaños pedidos
+#define THUMBNAIL_CACHE_BUCKET 64
+// Identificación y versión del formato de los ficheros de la caché
+#define THUMBNAIL_CACHE_MAGIC "BMTC"
+#define THUMBNAIL_CACHE_VERSION 3
+// Extensión de los ficheros de la caché sin comprimir y comprimidos
+#define THUMBNAIL_CACHE_EXTENSION ".bmt"
+#define THUMBNAIL_CACHE_COMPRESSED_EXTENSION ".bmc"
+// Formatos de los pixels de los ficheros de la caché
+#define THUMBNAIL_CACHE_FORMAT_RGBA 0
+#define THUMBNAIL_CACHE_FORMAT_DXT1 1
+#define THUMBNAIL_CACHE_FORMAT_DXT5 2
+
+namespace bmonkey{
+
+// Cabecera de los ficheros de la caché. Le siguen el path de la imagen
+// original y los pixels, en RGBA o comprimidos
+struct ThumbnailHeader
+{
+	char magic[4];					/**< Identificación del formato */
+	uint32_t version;				/**< Versión del formato */
+	uint32_t format;				/**< Formato de los pixels */
+	uint32_t width;					/**< Anchura de la imagen */
+	uint32_t height;				/**< Altura de la imagen */
+	int64_t mtime;					/**< Fecha de la imagen original */
+	int64_t mtime_nsec;				/**< Nanosegundos de la fecha de la imagen original */
+	int64_t size;					/**< Tamaño de la imagen original */
+	uint32_t path_size;				/**< Longitud del path de la imagen original */
+};
+
+/**
+ * Obtiene los nanosegundos de la fecha de modificación de un fichero
+ * @param info Información del fichero
+ * @return Nanosegundos de la fecha o cero si el sistema no los proporciona
+ */
+static long long getMtimeNsec(const struct stat& info)
+{
+	// Con sólo segundos, una imagen reescrita en el mismo segundo y con el
+	// mismo tamaño devolvería la versión reducida anterior
+#if defined(OS_MACOSX)
+	return info.st_mtimespec.tv_nsec;
+#elif defined(OS_POSIX)
+	return info.st_mtim.tv_nsec;
+#else
+	return 0;
+#endif
+}
+
+ThumbnailCache::ThumbnailCache(void):
+	m_hits(0),
+	m_misses(0)
+{
+}
+
+bool ThumbnailCache::load(const Glib::ustring& file, const sf::Vector2u& size, sf::Image& image)
+{
+	struct stat info;
+	MappedFile mapped;
+	Glib::ustring thumbnail;
+	sf::Vector2u bucket, thumbnail_size;
+	const sf::Uint8* data;
+	unsigned int format;
+	bool reduced;
+
+	bucket = getBucket(size);
+	if ((bucket.x == 0) || (bucket.y == 0) || (stat(file.c_str(), &info) != 0))
+	{
+		return image.loadFromFile(file);
+	}
+
+	if (!m_dir.empty())
+	{
+		thumbnail = getThumbnailFile(file, bucket, false);
+		if (read(thumbnail, file, info.st_mtime, getMtimeNsec(info), info.st_size, mapped, format, thumbnail_size, data) &&
+			(format == THUMBNAIL_CACHE_FORMAT_RGBA))
+		{
+			image.create(thumbnail_size.x, thumbnail_size.y, data);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			++m_hits;
+			return true;
+		}
+	}
+
+	if (!loadSource(file, bucket, image, reduced))
+	{
+		return false;
+	}
+	// Si la imagen ya cabía no merece la pena guardar una copia
+	if (!reduced)
+	{
+		return true;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_misses;
+	}
+	if (!m_dir.empty())
+	{
+		write(thumbnail, file, info.st_mtime, getMtimeNsec(info), info.st_size, THUMBNAIL_CACHE_FORMAT_RGBA, image.getSize(),
+			image.getPixelsPtr(), static_cast<std::size_t>(image.getSize().x) * image.getSize().y * 4);
+	}
+	return true;
+}
+
+bool ThumbnailCache::loadCompressed(const Glib::ustring& file, const sf::Vector2u& size, CompressedImage& image)
+{
+	struct stat info;
+	MappedFile mapped;
+	Glib::ustring thumbnail;
+	sf::Vector2u bucket, thumbnail_size;
+	const sf::Uint8* data;
+	sf::Image source;
+	unsigned int format;
+	bool reduced;
+
+	bucket = getBucket(size);
+	if ((bucket.x == 0) || (bucket.y == 0) || (stat(file.c_str(), &info) != 0))
+	{
+		return (source.loadFromFile(file) && image.compress(source));
+	}
+
+	if (!m_dir.empty())
+	{
+		thumbnail = getThumbnailFile(file, bucket, true);
+		if (read(thumbnail, file, info.st_mtime, getMtimeNsec(info), info.st_size, mapped, format, thumbnail_size, data) &&
+			(format != THUMBNAIL_CACHE_FORMAT_RGBA))
+		{
+			image.create(thumbnail_size, (format == THUMBNAIL_CACHE_FORMAT_DXT1) ?
+				CompressedImage::FORMAT_DXT1 : CompressedImage::FORMAT_DXT5, data);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			++m_hits;
+			return true;
+		}
+	}
+
+	// La compresión es costosa, así que se guarda aunque no haya reducción
+	if (!loadSource(file, bucket, source, reduced) || !image.compress(source))
+	{
+		return false;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_misses;
+	}
+	if (!m_dir.empty())
+	{
+		write(thumbnail, file, info.st_mtime, getMtimeNsec(info), info.st_size, (image.getFormat() == CompressedImage::FORMAT_DXT1) ?
+			THUMBNAIL_CACHE_FORMAT_DXT1 : THUMBNAIL_CACHE_FORMAT_DXT5, image.getSize(), image.getData(), image.getDataSize());
+	}
+	return true;
+}
+
+sf::Vector2u ThumbnailCache::getBucket(const sf::Vector2u& size)
+{
+	return sf::Vector2u(
+		((size.x + THUMBNAIL_CACHE_BUCKET - 1) / THUMBNAIL_CACHE_BUCKET) * THUMBNAIL_CACHE_BUCKET,
+		((size.y + THUMBNAIL_CACHE_BUCKET - 1) / THUMBNAIL_CACHE_BUCKET) * THUMBNAIL_CACHE_BUCKET);
+}
+
+void ThumbnailCache::downscale(const sf::Image& source, const sf::Vector2u& size, sf::Image& dest)
+{
+	const sf::Uint8* pixels;
+	const sf::Uint8* pixel;
+	std::vector<sf::Uint8> result;
+	sf::Vector2u source_size;
+	unsigned int x, y, sx, sy, x0, x1, y0, y1, count, pos;
+	unsigned long long red, green, blue, alpha;
+
+	source_size = source.getSize();
+	pixels = source.getPixelsPtr();
+	result.resize(static_cast<std::size_t>(size.x) * size.y * 4);
+	pos = 0;
+	for (y = 0; y < size.y; ++y)
+	{
+		// Filas de la imagen original que cubre el pixel destino
+		y0 = (static_cast<unsigned long long>(y) * source_size.y) / size.y;
+		y1 = std::max(y0 + 1, static_cast<unsigned int>((static_cast<unsigned long long>(y + 1) * source_size.y) / size.y));
+		for (x = 0; x < size.x; ++x)
+		{
+			x0 = (static_cast<unsigned long long>(x) * source_size.x) / size.x;
+			x1 = std::max(x0 + 1, static_cast<unsigned int>((static_cast<unsigned long long>(x + 1) * source_size.x) / size.x));
+			red = green = blue = alpha = 0;
+			for (sy = y0; sy < y1; ++sy)
+			{
+				pixel = pixels + (static_cast<std::size_t>(sy) * source_size.x + x0) * 4;
+				for (sx = x0; sx < x1; ++sx, pixel += 4)
+				{
+					red += pixel[0] * pixel[3];
+					green += pixel[1] * pixel[3];
+					blue += pixel[2] * pixel[3];
+					alpha += pixel[3];
+				}
+			}
+			count = (x1 - x0) * (y1 - y0);
+			if (alpha > 0)
+			{
+				result[pos] = red / alpha;
+				result[pos + 1] = green / alpha;
+				result[pos + 2] = blue / alpha;
+			}
+			else
+			{
+				result[pos] = result[pos + 1] = result[pos + 2] = 0;
+			}
+			result[pos + 3] = alpha / count;
+			pos += 4;
+		}
+	}
+	dest.create(size.x, size.y, &result[0]);
+}
+
+bool ThumbnailCache::loadSource(const Glib::ustring& file, const sf::Vector2u& size, sf::Image& image, bool& reduced)
+{
+	sf::Image source;
+	sf::Vector2u source_size, dest_size;
+	float scale;
+
+	if (!source.loadFromFile(file))
+	{
+		return false;
+	}
+	source_size = source.getSize();
+	reduced = (source_size.x > size.x) || (source_size.y > size.y);
+	if (!reduced)
+	{
+		image = source;
+		return true;
+	}
+	scale = std::min(static_cast<float>(size.x) / source_size.x, static_cast<float>(size.y) / source_size.y);
+	dest_size.x = std::max(1u, static_cast<unsigned int>(source_size.x * scale + 0.5f));
+	dest_size.y = std::max(1u, static_cast<unsigned int>(source_size.y * scale + 0.5f));
+	downscale(source, dest_size, image);
+	return true;
+}
+
+Glib::ustring ThumbnailCache::getThumbnailFile(const Glib::ustring& file, const sf::Vector2u& size, const bool compressed) const
+{
+	Glib::ustring name;
+
+	name = Crc32::toString(Crc32::getCrc32(file.data(), file.bytes())) + "_" +
+		utils::toStr(size.x) + "x" + utils::toStr(size.y) +
+		(compressed ? THUMBNAIL_CACHE_COMPRESSED_EXTENSION : THUMBNAIL_CACHE_EXTENSION);
+	return Glib::build_filename(m_dir, name);
+}
+
+bool ThumbnailCache::read(const Glib::ustring& thumbnail, const Glib::ustring& file, const long long mtime, const long long mtime_nsec,
+	const long long file_size, MappedFile& mapped, unsigned int& format, sf::Vector2u& size, const sf::Uint8*& data)
+{
+	ThumbnailHeader header;
+	std::size_t data_size;
+
+	if (!mapped.open(thumbnail) || (mapped.getSize() < sizeof(header)))
+	{
+		return false;
+	}
+	std::memcpy(&header, mapped.getData(), sizeof(header));
+	size.x = header.width;
+	size.y = header.height;
+	switch (header.format)
+	{
+	case THUMBNAIL_CACHE_FORMAT_RGBA:
+		data_size = static_cast<std::size_t>(size.x) * size.y * 4;
+		break;
+	case THUMBNAIL_CACHE_FORMAT_DXT1:
+		data_size = CompressedImage::getDataSize(CompressedImage::FORMAT_DXT1, size);
+		break;
+	case THUMBNAIL_CACHE_FORMAT_DXT5:
+		data_size = CompressedImage::getDataSize(CompressedImage::FORMAT_DXT5, size);
+		break;
+	default:
+		return false;
+	}
+	// Comprobamos el formato y que la imagen original no haya cambiado. El
+	// path evita confundir imágenes con el mismo crc
+	if ((std::memcmp(header.magic, THUMBNAIL_CACHE_MAGIC, 4) != 0) || (header.version != THUMBNAIL_CACHE_VERSION) ||
+		(header.mtime != mtime) || (header.mtime_nsec != mtime_nsec) || (header.size != file_size) || (header.width == 0) || (header.height == 0) ||
+		(mapped.getSize() != sizeof(header) + header.path_size + data_size) ||
+		(header.path_size != file.bytes()) ||
+		(std::memcmp(mapped.getData() + sizeof(header), file.data(), header.path_size) != 0))
+	{
+		return false;
+	}
+	format = header.format;
+	data = reinterpret_cast<const sf::Uint8*>(mapped.getData() + sizeof(header) + header.path_size);
+	return true;
+}
+
+bool ThumbnailCache::write(const Glib::ustring& thumbnail, const Glib::ustring& file, const long long mtime, const long long mtime_nsec,
+	const long long file_size, const unsigned int format, const sf::Vector2u& size, const sf::Uint8* data, const std::size_t data_size)
+{
+	std::ofstream stream;
+	ThumbnailHeader header;
+	Glib::ustring tmp_file;
+#if defined(OS_POSIX)
+	std::string tmp_name;
+	int fd;
+#else
+	std::ostringstream tmp_name;
+#endif
+
+	std::memcpy(header.magic, THUMBNAIL_CACHE_MAGIC, 4);
+	header.version = THUMBNAIL_CACHE_VERSION;
+	header.format = format;
+	header.width = size.x;
+	header.height = size.y;
+	header.mtime = mtime;
+	header.mtime_nsec = mtime_nsec;
+	header.size = file_size;
+	header.path_size = file.bytes();
+
+	// Escribimos en un fichero temporal y lo renombramos para que nunca se
+	// lea una versión a medio escribir. Su nombre es único porque varios hilos
+	// o instancias pueden generar la misma versión a la vez
+#if defined(OS_POSIX)
+	tmp_name = thumbnail.raw() + ".XXXXXX";
+	fd = mkstemp(&tmp_name[0]);
+	if (fd == -1)
+	{
+		LOG_ERROR("ThumbnailCache: Can't create temporary file for \"" << thumbnail << "\"");
+		return false;
+	}
+	close(fd);
+	tmp_file = tmp_name;
+#else
+	tmp_name << thumbnail.raw() << "." << _getpid() << "_" << std::this_thread::get_id() << ".tmp";
+	tmp_file = tmp_name.str();
+#endif
+	stream.open(tmp_file.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!stream.good())
+	{
+		LOG_ERROR("ThumbnailCache: Can't open thumbnail file \"" << tmp_file << "\" for writing");
+		return false;
+	}
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	stream.write(file.data(), file.bytes());
+	stream.write(reinterpret_cast<const char*>(data), data_size);
+	stream.close();
+	if (stream.fail() || (std::rename(tmp_file.c_str(), thumbnail.c_str()) != 0))
+	{
+		LOG_ERROR("ThumbnailCache: Can't write thumbnail file \"" << thumbnail << "\"");
+		std::remove(tmp_file.c_str());
+		return false;
+	}
+	return true;
+}
+
+} // namespace bmonkey
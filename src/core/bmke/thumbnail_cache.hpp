@@ -0,0 +1,185 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _THUMBNAIL_CACHE_HPP_
+#define _THUMBNAIL_CACHE_HPP_
+
+#include <SFML/Graphics.hpp>
+#include <glibmm/ustring.h>
+#include <mutex>
+#include "compressed_image.hpp"
+#include "../../utils/mapped_file.hpp"
+
+namespace bmonkey{
+
+/**
+ * Caché en disco de versiones reducidas de las imágenes
+ *
+ * Los snaps y fondos suelen tener una resolución mucho mayor que la que se
+ * usa al dibujarlos. La caché genera la primera vez que se solicitan versiones
+ * reducidas de las imágenes al tamaño pedido y las guarda en disco sin
+ * comprimir, de forma que en las siguientes ejecuciones se leen directamente
+ * sin decodificar la imagen original.
+ * Las versiones se regeneran si cambia la fecha o el tamaño de la imagen
+ * original.
+ * También puede guardar las versiones comprimidas en un formato de textura de
+ * la tarjeta gráfica, listas para subirse sin conversiones.
+ * Los tamaños pedidos se redondean para que tamaños parecidos compartan la
+ * misma versión reducida.
+ * Puede usarse desde varios hilos a la vez.
+ */
+class ThumbnailCache
+{
+public:
+	/**
+	 * Constructor de la clase
+	 */
+	ThumbnailCache(void);
+
+	/**
+	 * Establece el directorio donde se guardan las versiones reducidas
+	 * @param dir Directorio de la caché
+	 * @note Con un directorio vacío las versiones se generan pero no se
+	 * guardan
+	 */
+	void setDir(const Glib::ustring& dir);
+
+	/**
+	 * Obtiene el directorio donde se guardan las versiones reducidas
+	 * @return Directorio de la caché
+	 */
+	const Glib::ustring& getDir(void) const;
+
+	/**
+	 * Carga una imagen reducida para que quepa en un tamaño dado
+	 * @param file Path del fichero de la imagen original
+	 * @param size Tamaño máximo de la imagen, redondeado con getBucket
+	 * @param image Imagen donde se carga el resultado
+	 * @return true si se pudo cargar la imagen, false en otro caso
+	 * @note La imagen conserva su relación de aspecto. Si la original ya cabe
+	 * en el tamaño pedido se carga sin reducir y no se guarda en la caché
+	 */
+	bool load(const Glib::ustring& file, const sf::Vector2u& size, sf::Image& image);
+
+	/**
+	 * Carga una imagen reducida y comprimida para que quepa en un tamaño dado
+	 * @param file Path del fichero de la imagen original
+	 * @param size Tamaño máximo de la imagen, redondeado con getBucket
+	 * @param image Imagen comprimida donde se carga el resultado
+	 * @return true si se pudo cargar la imagen, false en otro caso
+	 * @note A diferencia de load, la imagen se guarda en la caché aunque no
+	 * se haya reducido, para no repetir la compresión
+	 */
+	bool loadCompressed(const Glib::ustring& file, const sf::Vector2u& size, CompressedImage& image);
+
+	/**
+	 * Obtiene el número de imágenes servidas desde la caché
+	 * @return Número de aciertos
+	 */
+	unsigned int getHits(void);
+
+	/**
+	 * Obtiene el número de imágenes que hubo que generar
+	 * @return Número de fallos
+	 */
+	unsigned int getMisses(void);
+
+	/**
+	 * Redondea un tamaño pedido al de la versión reducida que lo atiende
+	 * @param size Tamaño pedido
+	 * @return Tamaño redondeado
+	 */
+	static sf::Vector2u getBucket(const sf::Vector2u& size);
+
+	/**
+	 * Reduce una imagen promediando los pixels que cubre cada pixel destino
+	 * @param source Imagen original
+	 * @param size Tamaño de la imagen reducida
+	 * @param dest Imagen donde se genera el resultado
+	 * @note El promedio se pondera con la transparencia para que los bordes
+	 * de las zonas transparentes no se oscurezcan
+	 */
+	static void downscale(const sf::Image& source, const sf::Vector2u& size, sf::Image& dest);
+
+private:
+	/**
+	 * Carga la imagen original reduciéndola si no cabe en un tamaño dado
+	 * @param file Path del fichero de la imagen original
+	 * @param size Tamaño máximo de la imagen
+	 * @param image Imagen donde se carga el resultado
+	 * @param reduced Indica si se tuvo que reducir la imagen
+	 * @return true si se pudo cargar la imagen, false en otro caso
+	 */
+	bool loadSource(const Glib::ustring& file, const sf::Vector2u& size, sf::Image& image, bool& reduced);
+
+	/**
+	 * Obtiene el path de la versión reducida de una imagen
+	 * @param file Path del fichero de la imagen original
+	 * @param size Tamaño redondeado de la versión
+	 * @param compressed Indica si se trata de la versión comprimida
+	 * @return Path del fichero de la versión reducida
+	 */
+	Glib::ustring getThumbnailFile(const Glib::ustring& file, const sf::Vector2u& size, const bool compressed) const;
+
+	/**
+	 * Lee una versión reducida de la caché
+	 * @param thumbnail Path del fichero de la versión reducida
+	 * @param file Path del fichero de la imagen original
+	 * @param mtime Fecha de modificación de la imagen original
+	 * @param mtime_nsec Nanosegundos de la fecha de modificación
+	 * @param file_size Tamaño de la imagen original
+	 * @param mapped Fichero proyectado que mantiene los datos leídos
+	 * @param format Devuelve el formato de los pixels
+	 * @param size Devuelve el tamaño de la imagen
+	 * @param data Devuelve el comienzo de los pixels dentro del fichero
+	 * @return true si la versión existe y está al día, false en otro caso
+	 */
+	bool read(const Glib::ustring& thumbnail, const Glib::ustring& file, const long long mtime, const long long mtime_nsec,
+		const long long file_size, MappedFile& mapped, unsigned int& format, sf::Vector2u& size, const sf::Uint8*& data);
+
+	/**
+	 * Guarda una versión reducida en la caché
+	 * @param thumbnail Path del fichero de la versión reducida
+	 * @param file Path del fichero de la imagen original
+	 * @param mtime Fecha de modificación de la imagen original
+	 * @param mtime_nsec Nanosegundos de la fecha de modificación
+	 * @param file_size Tamaño de la imagen original
+	 * @param format Formato de los pixels
+	 * @param size Tamaño de la imagen
+	 * @param data Pixels de la imagen
+	 * @param data_size Tamaño en bytes de los pixels
+	 * @return true si se pudo guardar, false en otro caso
+	 */
+	bool write(const Glib::ustring& thumbnail, const Glib::ustring& file, const long long mtime, const long long mtime_nsec,
+		const long long file_size, const unsigned int format, const sf::Vector2u& size, const sf::Uint8* data, const std::size_t data_size);
+
+	Glib::ustring m_dir;			/**< Directorio de la caché */
+	std::mutex m_mutex;				/**< Protección de los contadores */
+	unsigned int m_hits;			/**< Imágenes servidas desde la caché */
+	unsigned int m_misses;			/**< Imágenes generadas */
+};
+
+// Inclusión de los métodos inline
+#include "thumbnail_cache.inl"
+
+} // namespace bmonkey
+
+#endif // _THUMBNAIL_CACHE_HPP_
@@ -0,0 +1,47 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _THUMBNAIL_CACHE_INL_
+#define _THUMBNAIL_CACHE_INL_
+
+inline void ThumbnailCache::setDir(const Glib::ustring& dir)
+{
+	m_dir = dir;
+}
+
+inline const Glib::ustring& ThumbnailCache::getDir(void) const
+{
+	return m_dir;
+}
+
+inline unsigned int ThumbnailCache::getHits(void)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_hits;
+}
+
+inline unsigned int ThumbnailCache::getMisses(void)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_misses;
+}
+
+#endif // _THUMBNAIL_CACHE_INL_
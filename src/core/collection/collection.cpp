@@ -96,6 +96,7 @@ bool Collection::loadPlatforms(void)
 		iter->second->loadConfig();
 		iter->second->loadGames();
 		iter->second->loadGamelists();
+		iter->second->loadMedia();
 	}
 	// Una vez cargadas las plataformas, generamos las tablas de fabricantes y Géneros
 	generateDinamicTables();
@@ -44,6 +44,7 @@ struct Filter
 		RATING,				/**< Filtro por puntuación */
 		LETTER,				/**< Filtro por letra inicial */
 		TIMES_PLAYED,		/**< Filtro por partidas jugadas */
+		STATE,				/**< Filtro por estado de verificación de la rom */
 		COUNT				/**< Contador de filtros */
 	};
 
@@ -67,8 +67,9 @@ bool Gamelist::loadGames(void)
 	XmlNode root;
 	XmlNode::iterator game_iter, field_iter;
 	Game* game = NULL;
-	Game game_tmp(m_resources_dir);
+	std::vector<Game*> games;
 	Glib::ustring name;
+	int state;
 
 	LOG_INFO("Gamelist: Loading games from file \"" << m_file << "\"...");
 	if (xml.open(m_file))
@@ -91,6 +92,11 @@ bool Gamelist::loadGames(void)
 					game_iter->getAttribute("rating", game->rating);
 					game_iter->getAttribute("timesplayed", game->times_played);
 					game_iter->getAttribute("favorite", game->favorite);
+					if (game_iter->getAttribute("state", state) &&
+						(state >= Game::STATE_UNKNOWN) && (state <= Game::STATE_INCORRECT))
+					{
+						game->state = static_cast<Game::State>(state);
+					}
 					for (field_iter = game_iter->begin(); field_iter != game_iter->end(); ++field_iter)
 					{
 						name = field_iter->getName();
@@ -124,17 +130,24 @@ bool Gamelist::loadGames(void)
 							field_iter->getContent(game->players);
 						}
 					}
+					game_iter->getAttribute("name", game->name);
 				}
 				else
 				{
-					game = &game_tmp;
-				}
-				game_iter->getAttribute("name", game->name);
-				if (!gameAdd(game) && isMaster())
-				{
-					delete game;
+					// Las listas genéricas enlazan directamente los juegos de
+					// la master, por lo que no necesitamos juegos temporales
+					name.clear();
+					game_iter->getAttribute("name", name);
+					if (name.empty() || !(game = m_master->gameGet(name)))
+					{
+						continue;
+					}
 				}
+				games.push_back(game);
 			}
+			// Insertamos todos los juegos de una sola vez. En las listas
+			// genéricas ya son los de la master y no hay que volver a buscarlos
+			gameAdd(games, !isMaster());
 			xml.close();
 			return true;
 		}
@@ -179,6 +192,7 @@ bool Gamelist::saveGames(void)
 				xml.writeAttribute("rating", game->rating);
 				xml.writeAttribute("timesplayed", game->times_played);
 				xml.writeAttribute("favorite", game->favorite);
+				xml.writeAttribute("state", static_cast<int>(game->state));
 				xml.startElement("title");
 					xml.writeContent(game->title);
 				xml.endElement();
@@ -337,6 +351,92 @@ bool Gamelist::gameAdd(Game* game)
 	return true;
 }
 
+int Gamelist::gameAdd(std::vector<Game*>& games, const bool from_master)
+{
+	std::vector<Game*>::iterator iter;
+	Game* master_game = NULL;
+	GameNode* nodes = NULL;
+	GameNode* node = NULL;
+	NodeBlock block;
+	unsigned int count = 0;
+
+	if (games.empty())
+	{
+		return 0;
+	}
+
+	// Reservamos de una vez el mapa y los nodos para todo el bloque
+	m_games_map.reserve(m_size + games.size());
+	nodes = new GameNode[games.size()];
+
+	for (iter = games.begin(); iter != games.end(); ++iter)
+	{
+		master_game = *iter;
+		assert(master_game);
+		if (master_game->name.empty())
+		{
+			if (isMaster())
+			{
+				delete master_game;
+			}
+			continue;
+		}
+		if (isMaster())
+		{
+			// Forzamos el name en lowercase
+			master_game->name = master_game->name.lowercase();
+		}
+		else if (!from_master)
+		{
+			// Buscamos el juego original en la master para enlazarlo
+			master_game = m_master->gameGet(master_game->name);
+			if (!master_game)
+			{
+				continue;
+			}
+		}
+		// La inserción en el mapa nos indica si el juego ya existía
+		node = &nodes[count];
+		if (!m_games_map.insert(std::make_pair(master_game->name.raw(), node)).second)
+		{
+			if (isMaster())
+			{
+				delete master_game;
+			}
+			continue;
+		}
+		node->setGame(master_game);
+		// Enlazamos el nodo al final de la lista
+		if (m_size == 0)
+		{
+			m_first = node;
+		}
+		else
+		{
+			node->setPrev(m_last);
+			m_last->setNext(node);
+		}
+		m_last = node;
+		++m_size;
+		++count;
+	}
+
+	if (count == 0)
+	{
+		delete[] nodes;
+		return 0;
+	}
+	// Cerramos la lista circular
+	m_last->setNext(m_first);
+	m_first->setPrev(m_last);
+
+	block.nodes = nodes;
+	block.size = games.size();
+	m_node_blocks.push_back(block);
+
+	return count;
+}
+
 Game* Gamelist::gameGet(Item* item)
 {
 	GameNode* node = NULL;
@@ -431,7 +531,7 @@ bool Gamelist::gameDelete(const Glib::ustring& name)
 		{
 			delete node->getGame();
 		}
-		delete node;
+		nodeFree(node);
 		return true;
 	}
 	else
@@ -699,6 +799,12 @@ bool Gamelist::applyFilters(GameNode* node, std::vector<Filter* >& filters)
 					return false;
 				}
 				break;
+			case Filter::STATE:
+				if (game->state != filters[i]->value)
+				{
+					return false;
+				}
+				break;
 			}
 		}
 	}
@@ -720,11 +826,27 @@ GameNode* Gamelist::nodeGet(const Glib::ustring& name)
 	return NULL;
 }
 
+void Gamelist::nodeFree(GameNode* node)
+{
+	std::vector<NodeBlock>::iterator iter;
+
+	// Los nodos de un bloque se liberan al liberar el bloque completo
+	for (iter = m_node_blocks.begin(); iter != m_node_blocks.end(); ++iter)
+	{
+		if ((node >= iter->nodes) && (node < iter->nodes + iter->size))
+		{
+			return;
+		}
+	}
+	delete node;
+}
+
 void Gamelist::clean(void)
 {
 	GameNode node_tmp;
 	GameNode* node = NULL;
 	GameNode* node_pos = NULL;
+	std::vector<NodeBlock>::iterator block_iter;
 
 	if (m_size)
 	{
@@ -739,7 +861,7 @@ void Gamelist::clean(void)
 			{
 				delete (node_pos->getGame());
 			}
-			delete node_pos;
+			nodeFree(node_pos);
 		}
 		m_games_map.clear();
 		m_is_filtered = false;
@@ -750,6 +872,12 @@ void Gamelist::clean(void)
 		m_first_filtered = NULL;
 		m_last_filtered = NULL;
 	}
+	// Liberamos los bloques de nodos reservados en las inserciones masivas
+	for (block_iter = m_node_blocks.begin(); block_iter != m_node_blocks.end(); ++block_iter)
+	{
+		delete[] block_iter->nodes;
+	}
+	m_node_blocks.clear();
 }
 
 } // namespace bmonkey
@@ -25,6 +25,7 @@
 #include <glibmm/ustring.h>
 #include <glibmm/regex.h>
 #include <unordered_map>
+#include <vector>
 #include "../iterable.hpp"
 #include "filter.hpp"
 #include "../../defines.hpp"
@@ -114,6 +115,19 @@ public:
 	 */
 	bool gameAdd(Game* game);
 
+	/**
+	 * Añade un bloque de juegos a la lista de una sola vez
+	 * @param games Juegos a añadir a la lista
+	 * @param from_master Indica si los juegos son ya los originales de la
+	 * master, con lo que no se vuelven a buscar en ella
+	 * @return Número de juegos añadidos
+	 * @note En las listas master, la lista pasa a ser propietaria de los juegos
+	 * y libera directamente los que no se pudieron añadir (repetidos o sin
+	 * nombre). En el resto, salvo que se indique from_master, los juegos solo
+	 * se usan para localizar por nombre el juego original en la master.
+	 */
+	int gameAdd(std::vector<Game*>& games, const bool from_master = false);
+
 	/**
 	 * Obtiene un juego a partir de un item
 	 * @param item Item a partir del cual obtener el juego
@@ -228,11 +242,27 @@ private:
 	 */
 	GameNode* nodeGet(const Glib::ustring& name);
 
+	/**
+	 * Libera la memoria de un nodo de la lista
+	 * @param node Nodo a liberar
+	 * @note Los nodos reservados en bloque se liberan junto con su bloque
+	 */
+	void nodeFree(GameNode* node);
+
 	/**
 	 * Se encarga de limpiar los almacenes internos de los datos
 	 */
 	void clean(void);
 
+	/**
+	 * Bloque de nodos reservados de una sola vez en una inserción masiva
+	 */
+	struct NodeBlock
+	{
+		GameNode* nodes;				/**< Nodos del bloque */
+		unsigned int size;				/**< Número de nodos del bloque */
+	};
+
 	Glib::ustring& m_resources_dir;		/**< Referencia al directorio de recursos */
 	Gamelist* m_master;
 	Glib::ustring m_name;				/**< Nombre de la lista */
@@ -248,6 +278,7 @@ private:
 	GameNode* m_last_filtered;			/**< Último elemento filtrado de la lista */
 
 	std::unordered_map<std::string, GameNode*> m_games_map;	/**< Mapa de juegos para acceso rápido por nombre */
+	std::vector<NodeBlock> m_node_blocks;	/**< Bloques de nodos de las inserciones masivas */
 
 	Glib::RefPtr<Glib::Regex> m_regex;	/**< Expresión regular para el filtrado por nombre */
 };
@@ -0,0 +1,236 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "media_index.hpp"
+#include <cassert>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glibmm/miscutils.h>
+#include "../../defines.hpp"
+#include "../../utils/dir_scanner.hpp"
+#include "../../utils/log.hpp"
+
+namespace bmonkey{
+
+// Extensiones reconocidas para cada tipo de fichero en orden de preferencia
+static const char* const MEDIA_IMAGE_EXTENSIONS[] = {"png", "jpg", "jpeg", "bmp", "tga", "gif", NULL};
+static const char* const MEDIA_VIDEO_EXTENSIONS[] = {"mp4", "mkv", "avi", "flv", "mpg", "mpeg", "wmv", NULL};
+
+MediaIndex::MediaIndex(void):
+	m_count(0)
+{
+}
+
+MediaIndex::~MediaIndex(void)
+{
+	clear();
+}
+
+void MediaIndex::setDir(const Glib::ustring& dir)
+{
+	assert(!dir.empty());
+
+	clear();
+	m_dirs[MEDIA_SNAP] = Glib::build_filename(dir, PLATFORM_SNAPS_DIR);
+	m_dirs[MEDIA_WHEEL] = Glib::build_filename(dir, PLATFORM_WHEELS_DIR);
+	m_dirs[MEDIA_VIDEO] = Glib::build_filename(dir, PLATFORM_VIDEOS_DIR);
+	m_dirs[MEDIA_BACKGROUND] = Glib::build_filename(dir, PLATFORM_BACKGROUNDS_DIR);
+}
+
+int MediaIndex::build(void)
+{
+	std::vector<DirScanner::Entry> entries;
+	std::vector<DirScanner::Entry>::iterator iter;
+	int type;
+
+	assert(!m_dirs[MEDIA_SNAP].empty());
+
+	clear();
+	LOG_INFO("MediaIndex: Indexing media files in \"" << Glib::path_get_dirname(m_dirs[MEDIA_SNAP]) << "\"...");
+	// Una única lectura por directorio, el tipo de las entradas no requiere
+	// consultar cada fichero
+	for (type = MEDIA_SNAP; type < MEDIA_COUNT; ++type)
+	{
+		entries.clear();
+		if (!DirScanner::readDir(m_dirs[type], entries))
+		{
+			continue;
+		}
+		m_media[type].reserve(entries.size());
+		for (iter = entries.begin(); iter != entries.end(); ++iter)
+		{
+			if (iter->type == DirScanner::ENTRY_FILE)
+			{
+				fileAdd(static_cast<MediaType>(type), iter->name);
+			}
+		}
+	}
+	LOG_INFO("MediaIndex: " << m_count << " media files indexed");
+	return m_count;
+}
+
+void MediaIndex::clear(void)
+{
+	int type;
+
+	for (type = MEDIA_SNAP; type < MEDIA_COUNT; ++type)
+	{
+		m_media[type].clear();
+	}
+	m_count = 0;
+}
+
+const MediaIndex::Media* MediaIndex::get(const MediaType type, const Game* game) const
+{
+	const Media* media;
+
+	assert(game);
+
+	media = get(type, game->name);
+	// Los clones pueden compartir los ficheros de su juego original
+	if (!media && !game->cloneof.empty())
+	{
+		media = get(type, game->cloneof);
+	}
+	return media;
+}
+
+const MediaIndex::Media* MediaIndex::get(const MediaType type, const Glib::ustring& name) const
+{
+	MediaMap::const_iterator iter;
+
+	assert(type < MEDIA_COUNT);
+
+	if (name.empty())
+	{
+		return NULL;
+	}
+	iter = m_media[type].find(name.lowercase());
+	if (iter != m_media[type].end())
+	{
+		return &iter->second.front();
+	}
+	return NULL;
+}
+
+bool MediaIndex::fileAdd(const MediaType type, const Glib::ustring& name)
+{
+	struct stat info;
+	std::string key;
+	Media media;
+
+	assert(type < MEDIA_COUNT);
+
+	media.priority = getPriority(type, name, key);
+	if (media.priority < 0)
+	{
+		return false;
+	}
+	media.file = Glib::build_filename(m_dirs[type], name);
+	media.size = 0;
+	if (stat(media.file.c_str(), &info) == 0)
+	{
+		media.size = info.st_size;
+	}
+	// Si se modifica un fichero ya indexado, reemplazamos su entrada
+	fileRemove(type, name);
+	insert(type, key, media);
+	return true;
+}
+
+bool MediaIndex::fileRemove(const MediaType type, const Glib::ustring& name)
+{
+	MediaMap::iterator iter;
+	std::vector<Media>::iterator media_iter;
+	std::string key;
+	Glib::ustring file;
+
+	assert(type < MEDIA_COUNT);
+
+	if (getPriority(type, name, key) < 0)
+	{
+		return false;
+	}
+	iter = m_media[type].find(key);
+	if (iter == m_media[type].end())
+	{
+		return false;
+	}
+	file = Glib::build_filename(m_dirs[type], name);
+	for (media_iter = iter->second.begin(); media_iter != iter->second.end(); ++media_iter)
+	{
+		if (media_iter->file == file)
+		{
+			iter->second.erase(media_iter);
+			if (iter->second.empty())
+			{
+				m_media[type].erase(iter);
+			}
+			--m_count;
+			return true;
+		}
+	}
+	return false;
+}
+
+int MediaIndex::getPriority(const MediaType type, const Glib::ustring& name, std::string& key)
+{
+	const char* const* extensions;
+	Glib::ustring extension;
+	Glib::ustring::size_type pos;
+	int i;
+
+	pos = name.rfind('.');
+	if ((pos == Glib::ustring::npos) || (pos == 0))
+	{
+		return -1;
+	}
+	extension = name.substr(pos + 1).lowercase();
+	extensions = (type == MEDIA_VIDEO) ? MEDIA_VIDEO_EXTENSIONS : MEDIA_IMAGE_EXTENSIONS;
+	for (i = 0; extensions[i]; ++i)
+	{
+		if (extension.raw() == extensions[i])
+		{
+			key = name.substr(0, pos).lowercase();
+			return i;
+		}
+	}
+	return -1;
+}
+
+void MediaIndex::insert(const MediaType type, const std::string& key, const Media& media)
+{
+	std::vector<Media>& candidates = m_media[type][key];
+	std::vector<Media>::iterator iter;
+
+	// Mantenemos los candidatos ordenados por preferencia
+	for (iter = candidates.begin(); iter != candidates.end(); ++iter)
+	{
+		if (media.priority < iter->priority)
+		{
+			break;
+		}
+	}
+	candidates.insert(iter, media);
+	++m_count;
+}
+
+} // namespace bmonkey
@@ -0,0 +1,172 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _MEDIA_INDEX_HPP_
+#define _MEDIA_INDEX_HPP_
+
+#include <glibmm/ustring.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "game.hpp"
+
+namespace bmonkey{
+
+/**
+ * Índice de los ficheros multimedia de los juegos de una plataforma.
+ *
+ * Relaciona el set name de cada juego con sus snaps, wheels, vídeos y fondos
+ * a partir de una única lectura de cada directorio, de forma que obtener los
+ * ficheros de un juego no requiere ningún acceso al sistema de ficheros.
+ * Si un juego no tiene fichero propio se utiliza el de su juego original.
+ * Cuando existen varios ficheros para el mismo juego se elige según la
+ * preferencia de su extensión.
+ */
+class MediaIndex
+{
+public:
+
+	/**
+	 * Tipos de ficheros multimedia indexados
+	 */
+	enum MediaType
+	{
+		MEDIA_SNAP = 0,			/**< Capturas de los juegos */
+		MEDIA_WHEEL,			/**< Logotipos de los juegos */
+		MEDIA_VIDEO,			/**< Vídeos de los juegos */
+		MEDIA_BACKGROUND,		/**< Fondos de los juegos */
+		MEDIA_COUNT				/**< Número de tipos de ficheros */
+	};
+
+	/**
+	 * Fichero multimedia resuelto
+	 */
+	struct Media
+	{
+		Glib::ustring file;				/**< Path completo del fichero */
+		unsigned long long size;		/**< Tamaño del fichero en bytes */
+		int priority;					/**< Preferencia de su extensión, menor es mejor */
+	};
+
+	/**
+	 * Constructor de la clase
+	 */
+	MediaIndex(void);
+
+	/**
+	 * Destructor de la clase
+	 */
+	~MediaIndex(void);
+
+	/**
+	 * Establece los directorios multimedia a partir del de una plataforma
+	 * @param dir Directorio de trabajo de la plataforma
+	 */
+	void setDir(const Glib::ustring& dir);
+
+	/**
+	 * Construye el índice leyendo los directorios multimedia
+	 * @return Número de ficheros indexados
+	 */
+	int build(void);
+
+	/**
+	 * Descarta todos los ficheros del índice
+	 */
+	void clear(void);
+
+	/**
+	 * Obtiene el fichero multimedia de un juego
+	 * @param type Tipo de fichero buscado
+	 * @param game Juego del que obtener el fichero
+	 * @return Fichero del juego, el de su original o null si no existe
+	 */
+	const Media* get(const MediaType type, const Game* game) const;
+
+	/**
+	 * Obtiene el fichero multimedia asociado a un set name
+	 * @param type Tipo de fichero buscado
+	 * @param name Set name del juego
+	 * @return Fichero del juego o null si no existe
+	 */
+	const Media* get(const MediaType type, const Glib::ustring& name) const;
+
+	/**
+	 * Agrega o actualiza un fichero en el índice
+	 * @param type Tipo del fichero
+	 * @param name Nombre del fichero dentro de su directorio
+	 * @return true si el fichero se indexó, false si su extensión no es válida
+	 */
+	bool fileAdd(const MediaType type, const Glib::ustring& name);
+
+	/**
+	 * Elimina un fichero del índice
+	 * @param type Tipo del fichero
+	 * @param name Nombre del fichero dentro de su directorio
+	 * @return true si el fichero estaba indexado, false en otro caso
+	 */
+	bool fileRemove(const MediaType type, const Glib::ustring& name);
+
+	/**
+	 * Obtiene el directorio de un tipo de ficheros
+	 * @param type Tipo de fichero
+	 * @return Path del directorio de ese tipo de ficheros
+	 */
+	const Glib::ustring& getDir(const MediaType type) const;
+
+	/**
+	 * Obtiene el número de ficheros indexados
+	 * @return Número de ficheros del índice
+	 */
+	int getCount(void) const;
+
+private:
+	/** Tipo para los ficheros candidatos de cada set name */
+	typedef std::unordered_map<std::string, std::vector<Media> > MediaMap;
+
+	/**
+	 * Obtiene la preferencia de un fichero según su extensión
+	 * @param type Tipo del fichero
+	 * @param name Nombre del fichero
+	 * @param key Lugar de retorno para el set name en minúsculas
+	 * @return Preferencia de la extensión o -1 si no es válida para el tipo
+	 */
+	static int getPriority(const MediaType type, const Glib::ustring& name, std::string& key);
+
+	/**
+	 * Agrega un fichero candidato a un set name manteniendo el mejor primero
+	 * @param type Tipo del fichero
+	 * @param key Set name en minúsculas
+	 * @param media Fichero a agregar
+	 */
+	void insert(const MediaType type, const std::string& key, const Media& media);
+
+	Glib::ustring m_dirs[MEDIA_COUNT];		/**< Directorios de cada tipo de fichero */
+	MediaMap m_media[MEDIA_COUNT];			/**< Ficheros de cada tipo por set name */
+	int m_count;							/**< Número de ficheros indexados */
+};
+
+// Inclusión de los métodos inline
+#include "media_index.inl"
+
+} // namespace bmonkey
+
+#endif // _MEDIA_INDEX_HPP_
@@ -44,6 +44,8 @@ Platform::Platform(const Glib::ustring& name, const Glib::ustring& library_dir):
 	m_resources_dir = Glib::build_filename(library_dir, USER_COLLECTION_DIR);
 	// Directorio de roms por defecto
 	m_roms_dir = Glib::build_filename(m_dir, PLATFORM_ROMS_DIR);
+	// Directorios de los ficheros multimedia
+	m_media.setDir(m_dir);
 
 	// Creamos la lista master
 	m_master = new Gamelist("", m_dir, NULL);
@@ -183,6 +185,11 @@ bool Platform::loadGamelists(void)
 	return false;
 }
 
+bool Platform::loadMedia(void)
+{
+	return (m_media.build() > 0);
+}
+
 bool Platform::saveConfig(void)
 {
 	Glib::ustring file;
@@ -302,6 +309,50 @@ Gamelist* Platform::gamelistCreate(const Glib::ustring& name)
 	return list;
 }
 
+Gamelist* Platform::gamelistLoad(const Glib::ustring& name)
+{
+	Gamelist* list = NULL;
+
+	assert(!name.empty());
+
+	list = gamelistGet(name);
+	if (!list)
+	{
+		list = gamelistCreate(name);
+	}
+	if (!list->loadGames())
+	{
+		gamelistDelete(name);
+		return NULL;
+	}
+	return list;
+}
+
+bool Platform::gamelistDelete(const Glib::ustring& name)
+{
+	std::unordered_map<std::string, Gamelist* >::iterator iter;
+	std::vector<Glib::ustring>::iterator name_iter;
+
+	assert(!name.empty());
+
+	iter = m_lists_map.find(name.lowercase());
+	if (iter == m_lists_map.end())
+	{
+		return false;
+	}
+	delete iter->second;
+	m_lists_map.erase(iter);
+	for (name_iter = m_lists_names.begin(); name_iter != m_lists_names.end(); ++name_iter)
+	{
+		if (name_iter->lowercase() == name.lowercase())
+		{
+			m_lists_names.erase(name_iter);
+			break;
+		}
+	}
+	return true;
+}
+
 void Platform::clean(void)
 {
 	std::unordered_map<std::string, Gamelist* >::iterator iter;
@@ -314,6 +365,7 @@ void Platform::clean(void)
 	delete m_master;
 
 	m_lists_map.clear();
+	m_media.clear();
 	m_lists_names.clear();
 }
 
@@ -28,6 +28,7 @@
 #include "../item.hpp"
 #include "../../defines.hpp"
 #include "gamelist.hpp"
+#include "media_index.hpp"
 
 namespace bmonkey{
 
@@ -233,6 +234,18 @@ public:
 	 */
 	bool loadGamelists(void);
 
+	/**
+	 * Construye el índice de ficheros multimedia de los juegos de la plataforma
+	 * @return true si se indexó algún fichero, falso en otro caso
+	 */
+	bool loadMedia(void);
+
+	/**
+	 * Obtiene el índice de ficheros multimedia de la plataforma
+	 * @return Índice de ficheros multimedia
+	 */
+	MediaIndex* getMediaIndex(void);
+
 	/**
 	 * Guarda la configuración de la plataforma en su fichero correspondiente
 	 * @return true si se pudo realizar la operación, falso en otro caso
@@ -288,6 +301,22 @@ public:
 	 */
 	Gamelist* gamelistCreate(const Glib::ustring& name);
 
+	/**
+	 * Carga o recarga una lista de juegos desde su fichero
+	 * @param name Nombre de la lista de juegos
+	 * @return Lista de juegos cargada o null si no se pudo cargar
+	 * @note Si la lista ya existe se recarga sobre la misma instancia
+	 */
+	Gamelist* gamelistLoad(const Glib::ustring& name);
+
+	/**
+	 * Elimina una lista de juegos de la plataforma
+	 * @param name Nombre de la lista de juegos a eliminar
+	 * @return true si se eliminó la lista, false si no existe
+	 * @note Únicamente se elimina de memoria, su fichero no se modifica
+	 */
+	bool gamelistDelete(const Glib::ustring& name);
+
 	/**
 	 * Obtiene el número de listas de juegos disponibles en la plataforma
 	 * @return Número de listas de juegos de la plataforma
@@ -344,6 +373,7 @@ private:
 	Gamelist* m_master;
 	std::unordered_map<std::string, Gamelist* > m_lists_map;	/**< Mapa de listas para acceso rápido por nombre */
 	std::vector<Glib::ustring> m_lists_names;	/**< Vector con los nombres de las listas */
+	MediaIndex m_media;				/**< Índice de ficheros multimedia de los juegos */
 };
 
 // Inclusión de los métodos inline
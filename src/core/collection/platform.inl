@@ -157,6 +157,11 @@ inline Gamelist* Platform::gamelistGet(void)
 	return m_master;
 }
 
+inline MediaIndex* Platform::getMediaIndex(void)
+{
+	return &m_media;
+}
+
 inline int Platform::gamelistCount(void)
 {
 	return m_lists_names.size();
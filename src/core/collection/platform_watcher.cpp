@@ -0,0 +1,374 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "platform_watcher.hpp"
+#include <cassert>
+#include <glibmm/miscutils.h>
+#include "../../utils/log.hpp"
+
+// Número de hilos usados para verificar las roms modificadas
+#define PLATFORM_WATCHER_THREADS 2
+
+namespace bmonkey{
+
+PlatformWatcher::PlatformWatcher(void):
+	m_verifier(PLATFORM_WATCHER_THREADS),
+	m_verifying(NULL)
+{
+}
+
+PlatformWatcher::~PlatformWatcher(void)
+{
+	clear();
+}
+
+bool PlatformWatcher::watch(Platform* platform)
+{
+	MediaIndex::MediaType media;
+	bool watched = false;
+	int type;
+
+	assert(platform);
+
+	if (!m_watcher.isSupported())
+	{
+		return false;
+	}
+	LOG_INFO("PlatformWatcher: Watching directories of platform \"" << platform->getName() << "\"...");
+	watched |= addWatch(platform, platform->getRomsDir(), DIR_ROMS);
+	watched |= addWatch(platform, Glib::build_filename(platform->getDir(), PLATFORM_GAMELISTS_DIR), DIR_GAMELISTS);
+	for (type = MediaIndex::MEDIA_SNAP; type < MediaIndex::MEDIA_COUNT; ++type)
+	{
+		media = static_cast<MediaIndex::MediaType>(type);
+		watched |= addWatch(platform, platform->getMediaIndex()->getDir(media), DIR_MEDIA, media);
+	}
+	return watched;
+}
+
+void PlatformWatcher::unwatch(Platform* platform)
+{
+	std::unordered_map<int, Watch>::iterator iter;
+
+	assert(platform);
+
+	iter = m_watches.begin();
+	while (iter != m_watches.end())
+	{
+		if (iter->second.platform == platform)
+		{
+			m_watcher.removeWatch(iter->first);
+			iter = m_watches.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+	m_pending.erase(platform);
+	m_gamelists.erase(platform);
+	if (m_verifying == platform)
+	{
+		m_verifier.stop();
+		m_verifying = NULL;
+		m_verifying_names.clear();
+	}
+}
+
+void PlatformWatcher::clear(void)
+{
+	m_verifier.stop();
+	m_verifying = NULL;
+	m_verifying_names.clear();
+	m_watcher.clear();
+	m_watches.clear();
+	m_pending.clear();
+	m_media.clear();
+	m_gamelists.clear();
+}
+
+int PlatformWatcher::update(void)
+{
+	std::vector<FileWatcher::Event> events;
+	std::vector<FileWatcher::Event>::iterator iter;
+	std::unordered_map<int, Watch>::iterator watch_iter;
+	int count = 0;
+
+	if (m_watcher.pollEvents(events))
+	{
+		for (iter = events.begin(); iter != events.end(); ++iter)
+		{
+			if (iter->type == FileWatcher::EVENT_OVERFLOW)
+			{
+				rescan();
+				++count;
+				continue;
+			}
+			watch_iter = m_watches.find(iter->watch);
+			if (watch_iter == m_watches.end())
+			{
+				continue;
+			}
+			switch (watch_iter->second.type)
+			{
+			case DIR_ROMS:
+				count += romChanged(watch_iter->second.platform, *iter);
+				break;
+			case DIR_GAMELISTS:
+				count += gamelistChanged(watch_iter->second.platform, *iter);
+				break;
+			case DIR_MEDIA:
+				count += mediaChanged(watch_iter->second, *iter);
+				break;
+			}
+		}
+	}
+	// Aplicamos los resultados de las verificaciones en curso
+	count += m_verifier.update();
+	verifyPending();
+	return count;
+}
+
+bool PlatformWatcher::pollMedia(std::vector<Glib::ustring>& files)
+{
+	if (m_media.empty())
+	{
+		return false;
+	}
+	files.insert(files.end(), m_media.begin(), m_media.end());
+	m_media.clear();
+	return true;
+}
+
+bool PlatformWatcher::pollGamelists(std::vector<Platform*>& platforms)
+{
+	if (m_gamelists.empty())
+	{
+		return false;
+	}
+	platforms.insert(platforms.end(), m_gamelists.begin(), m_gamelists.end());
+	m_gamelists.clear();
+	return true;
+}
+
+bool PlatformWatcher::addWatch(Platform* platform, const Glib::ustring& dir, const DirType type,
+	const MediaIndex::MediaType media)
+{
+	Watch watch;
+	int id;
+
+	id = m_watcher.addWatch(dir);
+	if (id < 0)
+	{
+		return false;
+	}
+	watch.platform = platform;
+	watch.type = type;
+	watch.media = media;
+	m_watches[id] = watch;
+	return true;
+}
+
+bool PlatformWatcher::romChanged(Platform* platform, const FileWatcher::Event& event)
+{
+	Glib::ustring name, extension;
+	Game* game;
+
+	// Obtenemos el set name a partir del nombre del fichero de la rom
+	extension = platform->getRomsExtension();
+	if (!extension.empty() && (extension[0] != '.'))
+	{
+		extension = "." + extension;
+	}
+	name = event.name;
+	if (!extension.empty() && (name.size() > extension.size()) &&
+		(name.substr(name.size() - extension.size()).lowercase() == extension.lowercase()))
+	{
+		name = name.substr(0, name.size() - extension.size());
+	}
+	game = platform->gamelistGet()->gameGet(name);
+	if (!game)
+	{
+		return false;
+	}
+
+	if (event.type == FileWatcher::EVENT_REMOVED)
+	{
+		LOG_DEBUG("PlatformWatcher: Rom \"" << event.name << "\" removed");
+		game->state = Game::STATE_INCORRECT;
+		m_pending[platform].erase(game->name.raw());
+	}
+	else
+	{
+		LOG_DEBUG("PlatformWatcher: Rom \"" << event.name << "\" added or changed");
+		game->state = Game::STATE_UNKNOWN;
+		m_pending[platform].insert(game->name.raw());
+	}
+	return true;
+}
+
+bool PlatformWatcher::gamelistChanged(Platform* platform, const FileWatcher::Event& event)
+{
+	Glib::ustring name, extension;
+
+	// Solamente nos interesan los xml
+	if (event.name.size() <= 4)
+	{
+		return false;
+	}
+	name = event.name.substr(0, event.name.size() - 4);
+	extension = event.name.substr(event.name.size() - 4, 4);
+	if (extension.lowercase() != ".xml")
+	{
+		return false;
+	}
+
+	// Las listas se liberan o recargan sobre la misma instancia, los
+	// verificadores no pueden seguir usando sus juegos
+	suspendVerify(platform);
+	m_gamelists.insert(platform);
+	if (event.type == FileWatcher::EVENT_REMOVED)
+	{
+		LOG_INFO("PlatformWatcher: Gamelist \"" << name << "\" removed");
+		return platform->gamelistDelete(name);
+	}
+	LOG_INFO("PlatformWatcher: Gamelist \"" << name << "\" added or changed");
+	return (platform->gamelistLoad(name) != NULL);
+}
+
+bool PlatformWatcher::mediaChanged(const Watch& watch, const FileWatcher::Event& event)
+{
+	MediaIndex* index;
+
+	index = watch.platform->getMediaIndex();
+	if (event.type == FileWatcher::EVENT_REMOVED)
+	{
+		return index->fileRemove(watch.media, event.name);
+	}
+	if (!index->fileAdd(watch.media, event.name))
+	{
+		return false;
+	}
+	m_media.push_back(Glib::build_filename(index->getDir(watch.media), event.name));
+	return true;
+}
+
+void PlatformWatcher::rescan(void)
+{
+	std::unordered_map<int, Watch>::iterator iter;
+	std::vector<Glib::ustring> names;
+	std::vector<Glib::ustring>::iterator name_iter;
+	std::unordered_set<Platform*> platforms;
+	std::unordered_set<Platform*>::iterator platform_iter;
+	Platform* platform;
+	Gamelist* master;
+	Item* item;
+	int count;
+
+	LOG_INFO("PlatformWatcher: Events lost, checking all watched platforms...");
+	for (iter = m_watches.begin(); iter != m_watches.end(); ++iter)
+	{
+		platforms.insert(iter->second.platform);
+	}
+	for (platform_iter = platforms.begin(); platform_iter != platforms.end(); ++platform_iter)
+	{
+		platform = *platform_iter;
+		suspendVerify(platform);
+		// Las roms se comprueban todas, la caché de crc evita releerlas
+		master = platform->gamelistGet();
+		item = master->itemFirst();
+		for (count = master->gameCount(); count > 0; --count)
+		{
+			m_pending[platform].insert(master->gameGet(item)->name.raw());
+			item = master->itemNext(item);
+		}
+		// Recargamos las listas de juegos conocidas
+		m_gamelists.insert(platform);
+		names = platform->getGamelists();
+		for (name_iter = names.begin(); name_iter != names.end(); ++name_iter)
+		{
+			platform->gamelistLoad(*name_iter);
+		}
+		// Y volvemos a indexar sus ficheros multimedia
+		platform->loadMedia();
+	}
+}
+
+void PlatformWatcher::suspendVerify(Platform* platform)
+{
+	if (m_verifying != platform)
+	{
+		return;
+	}
+	if (m_verifier.isRunning())
+	{
+		// Los resultados ya obtenidos se aplican, el resto se verificará de
+		// nuevo; la caché de crc evita releer las roms ya calculadas
+		m_verifier.update();
+		m_verifier.stop();
+		m_pending[platform].insert(m_verifying_names.begin(), m_verifying_names.end());
+	}
+	m_verifying = NULL;
+	m_verifying_names.clear();
+}
+
+void PlatformWatcher::verifyPending(void)
+{
+	std::unordered_map<Platform*, std::unordered_set<std::string> >::iterator iter;
+	std::unordered_set<std::string>::iterator name_iter;
+	std::vector<Game*> games;
+	Gamelist* master;
+	Game* game;
+
+	if (m_verifier.isRunning())
+	{
+		return;
+	}
+	m_verifying = NULL;
+	m_verifying_names.clear();
+	iter = m_pending.begin();
+	if (iter == m_pending.end())
+	{
+		return;
+	}
+	// Los juegos se obtienen por nombre al comenzar, descartando los que ya
+	// no están en la lista master
+	master = iter->first->gamelistGet();
+	for (name_iter = iter->second.begin(); name_iter != iter->second.end(); ++name_iter)
+	{
+		game = master->gameGet(*name_iter);
+		if (game)
+		{
+			games.push_back(game);
+			m_verifying_names.push_back(*name_iter);
+		}
+	}
+	if (m_verifier.start(iter->first, games))
+	{
+		m_verifying = iter->first;
+	}
+	else
+	{
+		m_verifying_names.clear();
+	}
+	m_pending.erase(iter);
+}
+
+} // namespace bmonkey
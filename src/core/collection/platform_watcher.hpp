@@ -0,0 +1,204 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _PLATFORM_WATCHER_HPP_
+#define _PLATFORM_WATCHER_HPP_
+
+#include <glibmm/ustring.h>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "../../utils/file_watcher.hpp"
+#include "rom_verifier.hpp"
+#include "platform.hpp"
+
+namespace bmonkey{
+
+/**
+ * Vigila los directorios de las plataformas y aplica sus cambios en caliente.
+ *
+ * Por cada plataforma vigila sus directorios de roms, listas de juegos, snaps,
+ * wheels, vídeos y fondos, actualizando los datos afectados sin necesidad de reiniciar
+ * ni de volver a recorrer los directorios:
+ * - Las roms eliminadas marcan su juego como incorrecto y las añadidas o
+ * modificadas se verifican en segundo plano.
+ * - Las listas de juegos añadidas o modificadas se recargan y las eliminadas
+ * se quitan de la plataforma.
+ * - Los ficheros multimedia se actualizan en el índice multimedia de la
+ * plataforma y los modificados se informan para que sus cachés los puedan
+ * recargar.
+ * Todos los cambios se aplican desde el hilo que llama a update.
+ */
+class PlatformWatcher
+{
+public:
+	/**
+	 * Constructor de la clase
+	 */
+	PlatformWatcher(void);
+
+	/**
+	 * Destructor de la clase
+	 */
+	~PlatformWatcher(void);
+
+	/**
+	 * Indica si el sistema permite vigilar los directorios
+	 * @return true si la vigilancia está disponible, false en otro caso
+	 */
+	bool isSupported(void) const;
+
+	/**
+	 * Comienza a vigilar los directorios de una plataforma
+	 * @param platform Plataforma a vigilar
+	 * @return true si se vigila algún directorio de la plataforma, false en
+	 * otro caso
+	 */
+	bool watch(Platform* platform);
+
+	/**
+	 * Deja de vigilar los directorios de una plataforma
+	 * @param platform Plataforma que se dejará de vigilar
+	 */
+	void unwatch(Platform* platform);
+
+	/**
+	 * Deja de vigilar todas las plataformas
+	 */
+	void clear(void);
+
+	/**
+	 * Procesa los cambios producidos en los directorios vigilados
+	 * @return Número de cambios aplicados
+	 * @note Debe llamarse periódicamente desde el hilo que gestiona la colección
+	 */
+	int update(void);
+
+	/**
+	 * Obtiene los ficheros multimedia modificados desde la última llamada
+	 * @param files Vector donde se añaden los paths de los ficheros
+	 * @return true si hay algún fichero modificado, false en otro caso
+	 */
+	bool pollMedia(std::vector<Glib::ustring>& files);
+
+	/**
+	 * Obtiene las plataformas cuyas listas de juegos se han recargado o
+	 * eliminado desde la última llamada
+	 * @param platforms Vector donde se añaden las plataformas
+	 * @return true si hay alguna plataforma afectada, false en otro caso
+	 * @note Las listas recargadas liberan sus elementos y las eliminadas se
+	 * liberan por completo, por lo que quien guarde punteros a sus listas,
+	 * elementos o juegos debe volver a obtenerlos por nombre
+	 */
+	bool pollGamelists(std::vector<Platform*>& platforms);
+
+private:
+
+	/**
+	 * Tipos de directorios vigilados en cada plataforma
+	 */
+	enum DirType
+	{
+		DIR_ROMS = 0,
+		DIR_GAMELISTS,
+		DIR_MEDIA
+	};
+
+	/**
+	 * Información de cada directorio vigilado
+	 */
+	struct Watch
+	{
+		Platform* platform;		/**< Plataforma a la que pertenece el directorio */
+		DirType type;			/**< Tipo de directorio */
+		MediaIndex::MediaType media;	/**< Tipo de fichero multimedia del directorio */
+	};
+
+	/**
+	 * Comienza a vigilar un directorio de una plataforma
+	 * @param platform Plataforma a la que pertenece el directorio
+	 * @param dir Path del directorio
+	 * @param type Tipo del directorio
+	 * @param media Tipo de fichero multimedia si el directorio es multimedia
+	 * @return true si se pudo vigilar el directorio, false en otro caso
+	 */
+	bool addWatch(Platform* platform, const Glib::ustring& dir, const DirType type,
+		const MediaIndex::MediaType media = MediaIndex::MEDIA_COUNT);
+
+	/**
+	 * Aplica un cambio en una rom de una plataforma
+	 * @param platform Plataforma de la rom
+	 * @param event Evento producido sobre la rom
+	 * @return true si se actualizó algún juego, false en otro caso
+	 */
+	bool romChanged(Platform* platform, const FileWatcher::Event& event);
+
+	/**
+	 * Aplica un cambio en una lista de juegos de una plataforma
+	 * @param platform Plataforma de la lista
+	 * @param event Evento producido sobre el fichero de la lista
+	 * @return true si se actualizó alguna lista, false en otro caso
+	 */
+	bool gamelistChanged(Platform* platform, const FileWatcher::Event& event);
+
+	/**
+	 * Aplica un cambio en un fichero multimedia de una plataforma
+	 * @param watch Directorio vigilado del fichero
+	 * @param event Evento producido sobre el fichero
+	 * @return true si se actualizó el índice multimedia, false en otro caso
+	 */
+	bool mediaChanged(const Watch& watch, const FileWatcher::Event& event);
+
+	/**
+	 * Vuelve a comprobar todas las plataformas tras perder eventos
+	 */
+	void rescan(void);
+
+	/**
+	 * Detiene la verificación en curso de una plataforma antes de modificar
+	 * sus listas, devolviendo sus juegos a los pendientes de verificar
+	 * @param platform Plataforma cuyas listas se van a modificar
+	 */
+	void suspendVerify(Platform* platform);
+
+	/**
+	 * Comienza la verificación de las roms pendientes de una plataforma si no
+	 * hay otra en curso
+	 */
+	void verifyPending(void);
+
+	FileWatcher m_watcher;					/**< Vigilancia de los directorios */
+	std::unordered_map<int, Watch> m_watches;	/**< Directorios vigilados */
+	std::unordered_map<Platform*, std::unordered_set<std::string> > m_pending;	/**< Nombres de los juegos pendientes de verificar */
+	RomVerifier m_verifier;					/**< Verificador de las roms modificadas */
+	Platform* m_verifying;					/**< Plataforma en verificación */
+	std::vector<std::string> m_verifying_names;	/**< Nombres de los juegos en verificación */
+	std::vector<Glib::ustring> m_media;		/**< Ficheros multimedia modificados */
+	std::unordered_set<Platform*> m_gamelists;	/**< Plataformas con listas recargadas o eliminadas */
+};
+
+// Inclusión de los métodos inline
+#include "platform_watcher.inl"
+
+} // namespace bmonkey
+
+#endif // _PLATFORM_WATCHER_HPP_
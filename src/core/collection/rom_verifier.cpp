@@ -0,0 +1,260 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "rom_verifier.hpp"
+#include <cassert>
+#include <cstdlib>
+#include <algorithm>
+#include <glibmm/miscutils.h>
+#include <glibmm/fileutils.h>
+#include "../../utils/crc32.hpp"
+#include "../../utils/zip_file.hpp"
+#include "../../utils/log.hpp"
+
+// Número de juegos verificados en cada tarea de los hilos de trabajo
+#define ROM_VERIFIER_BATCH_SIZE 64
+
+namespace bmonkey{
+
+RomVerifier::RomVerifier(const unsigned int threads):
+	m_pool(threads),
+	m_cancel(false),
+	m_total(0),
+	m_verified(0),
+	m_correct(0),
+	m_deep_check(false),
+	m_full_check(false)
+{
+}
+
+RomVerifier::~RomVerifier(void)
+{
+	stop();
+}
+
+bool RomVerifier::start(Platform* platform)
+{
+	Gamelist* list;
+	Item* item;
+	std::vector<Game*> games;
+	int count;
+
+	assert(platform);
+
+	list = platform->gamelistGet();
+	games.reserve(list->gameCount());
+	item = list->itemFirst();
+	for (count = list->gameCount(); count > 0; --count)
+	{
+		games.push_back(list->gameGet(item));
+		item = list->itemNext(item);
+	}
+	return start(platform, games);
+}
+
+bool RomVerifier::start(Platform* platform, const std::vector<Game*>& games)
+{
+	std::vector<Game*>::const_iterator iter;
+	Job job;
+	Glib::ustring roms_dir, extension, cache_file;
+	unsigned int i;
+
+	assert(platform);
+
+	stop();
+
+	roms_dir = platform->getRomsDir();
+	extension = platform->getRomsExtension();
+	if (!extension.empty() && (extension[0] != '.'))
+	{
+		extension = "." + extension;
+	}
+
+	// Cargamos los crc calculados en verificaciones anteriores si no los
+	// tenemos ya de una verificación previa de la misma plataforma
+	cache_file = Glib::build_filename(platform->getDir(), BMONKEY_HASHES_FILE);
+	if ((m_cache.getFile() != cache_file) || (m_cache.getBaseDir() != roms_dir))
+	{
+		m_cache.load(cache_file, roms_dir);
+	}
+
+	LOG_INFO("RomVerifier: Verifying " << games.size() << " roms of platform \"" << platform->getName() << "\" in \"" << roms_dir << "\"...");
+	// Preparamos en este hilo todos los datos que necesitarán los hilos de
+	// trabajo, de forma que no accedan a los juegos
+	m_jobs.reserve(games.size());
+	for (iter = games.begin(); iter != games.end(); ++iter)
+	{
+		job.game = *iter;
+		job.file = Glib::build_filename(roms_dir, job.game->name + extension);
+		job.crc = job.game->crc;
+		m_jobs.push_back(job);
+	}
+	m_full_check = (static_cast<int>(m_jobs.size()) == platform->gamelistGet()->gameCount());
+	// Una verificación completa vuelve a consultar todas las roms, así al
+	// terminar se descartan las eliminadas desde la anterior
+	if (m_full_check)
+	{
+		m_cache.resetUsed();
+	}
+	m_total = m_jobs.size();
+	if (m_total == 0)
+	{
+		return false;
+	}
+	// Repartimos los juegos en bloques entre los hilos de trabajo
+	for (i = 0; i < m_jobs.size(); i += ROM_VERIFIER_BATCH_SIZE)
+	{
+		m_pool.addTask(std::bind(&RomVerifier::verify, this, i,
+			std::min<unsigned int>(i + ROM_VERIFIER_BATCH_SIZE, m_jobs.size())));
+	}
+	return true;
+}
+
+void RomVerifier::stop(void)
+{
+	// Descartamos los bloques pendientes y esperamos a los que están en curso
+	m_cancel = true;
+	m_pool.clear();
+	m_pool.wait();
+	m_cancel = false;
+
+	// Conservamos los crc calculados hasta el momento
+	m_cache.save();
+
+	m_jobs.clear();
+	m_results.clear();
+	m_total = 0;
+	m_verified = 0;
+	m_correct = 0;
+}
+
+int RomVerifier::update(void)
+{
+	std::vector<Result> results;
+	std::vector<Result>::iterator iter;
+
+	// Recogemos los resultados bloqueando lo mínimo a los hilos de trabajo
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		results.swap(m_results);
+	}
+	for (iter = results.begin(); iter != results.end(); ++iter)
+	{
+		iter->game->state = iter->state;
+		if (iter->state == Game::STATE_CORRECT)
+		{
+			++m_correct;
+		}
+	}
+	m_verified += results.size();
+	if ((m_total > 0) && (m_verified == m_total) && !results.empty())
+	{
+		LOG_INFO("RomVerifier: Verification finished, " << m_correct << " of " << m_total << " roms are correct");
+		LOG_DEBUG("RomVerifier: Hash cache hits: " << m_cache.getHits() << ", misses: " << m_cache.getMisses());
+		// Con todas las roms consultadas podemos descartar las que ya no existen
+		m_cache.save(m_full_check);
+	}
+	return results.size();
+}
+
+bool RomVerifier::isRunning(void)
+{
+	return (m_verified < m_total);
+}
+
+void RomVerifier::verify(const unsigned int begin, const unsigned int end)
+{
+	std::vector<Result> results;
+	Result result;
+	unsigned int i;
+
+	results.reserve(end - begin);
+	for (i = begin; (i < end) && !m_cancel; ++i)
+	{
+		result.game = m_jobs[i].game;
+		result.state = verifyJob(m_jobs[i]);
+		results.push_back(result);
+	}
+	// Publicamos el bloque completo de una sola vez
+	if (!m_cancel)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_results.insert(m_results.end(), results.begin(), results.end());
+	}
+}
+
+Game::State RomVerifier::verifyJob(const Job& job)
+{
+	Crc32::Crc crc;
+
+	// Las roms en zip se comprueban a partir de su contenido
+	if ((job.file.size() > 4) && (job.file.substr(job.file.size() - 4).lowercase() == ".zip"))
+	{
+		return verifyZipJob(job);
+	}
+	// Sin crc de referencia nos basta con que la rom exista
+	if (job.crc.empty())
+	{
+		return Glib::file_test(job.file, Glib::FILE_TEST_IS_REGULAR) ? Game::STATE_CORRECT : Game::STATE_INCORRECT;
+	}
+	// El crc solo se calcula si la rom no está en la caché o ha cambiado
+	if (!m_cache.getCrc32(job.file, crc))
+	{
+		return Game::STATE_INCORRECT;
+	}
+	if (crc == std::strtoul(job.crc.c_str(), NULL, 16))
+	{
+		return Game::STATE_CORRECT;
+	}
+	return Game::STATE_INCORRECT;
+}
+
+Game::State RomVerifier::verifyZipJob(const Job& job)
+{
+	ZipFile zip;
+	std::vector<ZipFile::Entry>::const_iterator iter;
+	Crc32::Crc crc;
+
+	// Solamente se lee el directorio central del zip
+	if (!zip.open(job.file))
+	{
+		return Game::STATE_INCORRECT;
+	}
+	if (job.crc.empty())
+	{
+		return Game::STATE_CORRECT;
+	}
+	crc = std::strtoul(job.crc.c_str(), NULL, 16);
+	for (iter = zip.getEntries().begin(); iter != zip.getEntries().end(); ++iter)
+	{
+		if (iter->crc == crc)
+		{
+			// Comprobamos los datos reales únicamente si se ha solicitado
+			if (!m_deep_check || zip.verify(*iter))
+			{
+				return Game::STATE_CORRECT;
+			}
+		}
+	}
+	return Game::STATE_INCORRECT;
+}
+
+} // namespace bmonkey
@@ -0,0 +1,189 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _ROM_VERIFIER_HPP_
+#define _ROM_VERIFIER_HPP_
+
+#include <glibmm/ustring.h>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include "../../utils/thread_pool.hpp"
+#include "../../utils/hash_cache.hpp"
+#include "platform.hpp"
+
+namespace bmonkey{
+
+/**
+ * Verificador de las roms de los juegos de una plataforma.
+ *
+ * Localiza la rom de cada juego de la lista master en el directorio de roms de
+ * la plataforma y calcula su crc32 en un conjunto de hilos de trabajo,
+ * comparándolo con el crc del juego.
+ * Las roms comprimidas en zip se comprueban con los crc almacenados en su
+ * directorio central, sin descomprimir sus datos salvo que se active la
+ * comprobación completa.
+ * Los crc calculados se almacenan en una caché en el directorio de la
+ * plataforma, de forma que en las siguientes verificaciones solo se leen las
+ * roms nuevas o modificadas.
+ * El proceso no bloquea al llamante. Los resultados se aplican sobre el estado
+ * de los juegos únicamente al llamar a update, de forma que los juegos solo son
+ * modificados desde el hilo que los gestiona.
+ */
+class RomVerifier
+{
+public:
+	/**
+	 * Constructor parametrizado
+	 * @param threads Número de hilos de trabajo a usar, 0 para usar uno por
+	 * cada núcleo disponible
+	 */
+	RomVerifier(const unsigned int threads = 0);
+
+	/**
+	 * Destructor de la clase
+	 */
+	~RomVerifier(void);
+
+	/**
+	 * Comienza la verificación de los juegos de una plataforma
+	 * @param platform Plataforma cuyos juegos se verificarán
+	 * @return true si se pudo comenzar la verificación, false en otro caso
+	 * @note La lista master de la plataforma no debe modificarse hasta que
+	 * finalice o se detenga la verificación
+	 */
+	bool start(Platform* platform);
+
+	/**
+	 * Comienza la verificación de un grupo de juegos de una plataforma
+	 * @param platform Plataforma a la que pertenecen los juegos
+	 * @param games Juegos de la lista master a verificar
+	 * @return true si se pudo comenzar la verificación, false en otro caso
+	 * @note Los juegos no deben eliminarse hasta que finalice o se detenga la
+	 * verificación
+	 */
+	bool start(Platform* platform, const std::vector<Game*>& games);
+
+	/**
+	 * Detiene la verificación en curso descartando los resultados pendientes
+	 */
+	void stop(void);
+
+	/**
+	 * Activa o desactiva la comprobación completa de las roms comprimidas
+	 * @param deep true para descomprimir y comprobar los datos de las roms
+	 * comprimidas, false para confiar en los crc almacenados en el zip
+	 * @note Debe establecerse antes de comenzar la verificación
+	 */
+	void setDeepCheck(const bool deep);
+
+	/**
+	 * Aplica sobre los juegos los resultados disponibles hasta el momento
+	 * @return Número de juegos actualizados
+	 * @note Debe llamarse periódicamente desde el hilo que gestiona los juegos
+	 */
+	int update(void);
+
+	/**
+	 * Indica si hay una verificación en curso o resultados por aplicar
+	 * @return true si la verificación no ha finalizado, false en otro caso
+	 */
+	bool isRunning(void);
+
+	/**
+	 * Obtiene el número total de juegos a verificar
+	 * @return Número de juegos de la verificación
+	 */
+	int getTotal(void) const;
+
+	/**
+	 * Obtiene el número de juegos verificados y actualizados
+	 * @return Número de juegos verificados
+	 */
+	int getVerified(void) const;
+
+	/**
+	 * Obtiene el número de juegos cuyo estado es correcto
+	 * @return Número de juegos con el estado correcto
+	 */
+	int getCorrect(void) const;
+
+private:
+
+	/**
+	 * Datos necesarios para verificar un juego
+	 */
+	struct Job
+	{
+		Game* game;				/**< Juego a verificar */
+		Glib::ustring file;		/**< Path de la rom del juego */
+		Glib::ustring crc;		/**< Crc esperado para la rom */
+	};
+
+	/**
+	 * Resultado de la verificación de un juego
+	 */
+	struct Result
+	{
+		Game* game;				/**< Juego verificado */
+		Game::State state;		/**< Estado obtenido en la verificación */
+	};
+
+	/**
+	 * Verifica un bloque de juegos desde un hilo de trabajo
+	 * @param begin Posición del primer trabajo del bloque
+	 * @param end Posición siguiente al último trabajo del bloque
+	 */
+	void verify(const unsigned int begin, const unsigned int end);
+
+	/**
+	 * Obtiene el estado de un juego a partir de su rom
+	 * @param job Datos del juego a verificar
+	 * @return Estado del juego
+	 */
+	Game::State verifyJob(const Job& job);
+
+	/**
+	 * Obtiene el estado de un juego cuya rom está comprimida en un zip
+	 * @param job Datos del juego a verificar
+	 * @return Estado del juego
+	 */
+	Game::State verifyZipJob(const Job& job);
+
+	ThreadPool m_pool;					/**< Hilos de trabajo para la verificación */
+	HashCache m_cache;					/**< Caché de los crc de las roms */
+	std::vector<Job> m_jobs;			/**< Trabajos de la verificación en curso */
+	std::vector<Result> m_results;		/**< Resultados pendientes de aplicar */
+	std::mutex m_mutex;					/**< Protección de los resultados */
+	std::atomic<bool> m_cancel;			/**< Indica a los hilos que deben parar */
+	int m_total;						/**< Número de juegos a verificar */
+	int m_verified;						/**< Número de juegos verificados */
+	int m_correct;						/**< Número de juegos correctos */
+	bool m_deep_check;					/**< Comprobación completa de las roms comprimidas */
+	bool m_full_check;					/**< Indica si se verifican todos los juegos de la plataforma */
+};
+
+// Inclusión de los métodos inline
+#include "rom_verifier.inl"
+
+} // namespace bmonkey
+
+#endif // _ROM_VERIFIER_HPP_
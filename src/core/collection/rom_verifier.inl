@@ -0,0 +1,45 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _ROM_VERIFIER_INL_
+#define _ROM_VERIFIER_INL_
+
+inline void RomVerifier::setDeepCheck(const bool deep)
+{
+	m_deep_check = deep;
+}
+
+inline int RomVerifier::getTotal(void) const
+{
+	return m_total;
+}
+
+inline int RomVerifier::getVerified(void) const
+{
+	return m_verified;
+}
+
+inline int RomVerifier::getCorrect(void) const
+{
+	return m_correct;
+}
+
+#endif // _ROM_VERIFIER_INL_
@@ -26,6 +26,7 @@
 #include <vector>
 #include <glibmm/ustring.h>
 #include "dat_set.hpp"
+#include "../../utils/mapped_file.hpp"
 
 
 namespace bmonkey{
@@ -42,7 +43,8 @@ public:
 	 * Constructor, se encarga de iniciar el lector
 	 */
 	DatReader(void):
-		m_loaded(false)
+		m_loaded(false),
+		m_file(NULL)
 	{
 	}
 
@@ -51,6 +53,7 @@ public:
 	 */
 	virtual ~DatReader(void)
 	{
+		delete m_file;
 	}
 
 	/**
@@ -61,6 +64,17 @@ public:
 	 */
 	virtual bool load(const char* buffer, const unsigned int size);
 
+	/**
+	 * Carga un dat desde un fichero proyectado en memoria
+	 * @param file Fichero proyectado con los datos del dat
+	 * @return true si se pudo cargar el dat, false en otro caso
+	 * @note Si la carga es correcta, el lector pasa a ser el propietario del
+	 * fichero y lo libera en su destrucción, ya que algunos lectores trabajan
+	 * directamente sobre sus datos sin copiarlos. En otro caso el fichero
+	 * sigue perteneciendo al llamante, que puede probar con otro lector
+	 */
+	bool loadFile(MappedFile* file);
+
 	/**
 	 * Obtiene los datos de los sets contenidos en el dat
 	 * @param set_collection Mapa donde se almacenarán los sets del dat
@@ -91,7 +105,8 @@ public:
 	virtual Glib::ustring getType(void);
 
 protected:
-	bool m_loaded;	/**< Indica si se cargó el dat correctamente */
+	bool m_loaded;			/**< Indica si se cargó el dat correctamente */
+	MappedFile* m_file;		/**< Fichero proyectado con los datos del dat */
 };
 
 // Inclusión de los métodos inline
@@ -27,6 +27,21 @@ inline bool DatReader::load(const char* buffer, const unsigned int size)
 	return false;
 }
 
+inline bool DatReader::loadFile(MappedFile* file)
+{
+	assert(file);
+
+	delete m_file;
+	m_file = NULL;
+	if (!load(file->getData(), file->getSize()))
+	{
+		return false;
+	}
+	// Mantenemos los datos vivos mientras viva el lector
+	m_file = file;
+	return true;
+}
+
 inline bool DatReader::read(std::map<Glib::ustring, DatSet>& set_collection)
 {
 	return false;
@@ -19,84 +19,360 @@
  * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
  */
 
-#include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <climits>
+#include <zlib.h>
 #include "dat_reader_factory.hpp"
 #include "clrmamepro_reader.hpp"
 #include "logiqxxml_reader.hpp"
 #include "mamexml_reader.hpp"
 #include "hyperspinxml_reader.hpp"
+#include "../../utils/zip_file.hpp"
+#include "../../utils/log.hpp"
 
+// Número máximo de bytes examinados para detectar el formato de un dat
+#define DAT_SNIFF_SIZE 4096
+// Tamaño mínimo de un fichero gzip: cabecera de 10 bytes y cola de 8 bytes
+#define GZIP_MIN_SIZE 18
 
 namespace bmonkey{
 
 DatReader* DatReaderFactory::getDatReader(const Glib::ustring& file)
 {
-	char* buffer = NULL;
-	std::ifstream file_stream;
-	unsigned int size;
+	MappedFile* mapped;
 	DatReader* reader = NULL;
+	Format format;
 
 	assert(!file.empty());
 
-	file_stream.open(file.data());
-	// Comprobamos si la apertura fue correcta
-	if (!file_stream.good())
+	// Proyectamos el fichero en memoria en lugar de copiarlo
+	mapped = new MappedFile();
+	if (!mapped->open(file))
 	{
-		file_stream.close();
+		delete mapped;
 		return NULL;
 	}
-	// Obtenemos el tamaño del fichero
-	file_stream.seekg(0, std::ios::end);
-	size = file_stream.tellg();
-	file_stream.seekg(0, std::ios::beg);
-
-	// Reservamos la memoria necesaria
-	buffer = new char[size];
-	if (!buffer)
+	// Si el dat viene comprimido trabajamos con sus datos descomprimidos
+	mapped = decompress(mapped);
+	if (!mapped)
 	{
-		file_stream.close();
 		return NULL;
 	}
-	// Cargamos el contenido completo del fichero en memoria
-	file_stream.read(buffer, size);
-	file_stream.close();
-	// Buscamos el lector adecuado
-	// Chequeamos CMPro
-	reader = new ClrMameProReader();
-	if (reader->load(buffer, size))
+	// Creamos directamente el lector adecuado según la cabecera del dat
+	format = sniffFormat(mapped->getData(), mapped->getSize());
+	if (format == FORMAT_UNDETERMINED)
 	{
-		delete[] buffer;
-		return reader;
+		// La cabecera es demasiado larga, probamos con todos los lectores
+		return tryReaders(mapped);
 	}
-	delete reader;
-	// Chequeamos Logiqx xml
-	reader = new LogiqxXmlReader();
-	if (reader->load(buffer, size))
+	reader = createReader(format);
+	if (!reader)
 	{
-		delete[] buffer;
-		return reader;
+		// No encontramos ningún lector adecuado para el fichero
+		delete mapped;
+		return NULL;
 	}
-	delete reader;
-	// Chequeamos Mame xml
-	reader = new MameXmlReader();
-	if (reader->load(buffer, size))
+	// El lector se queda con el fichero proyectado
+	if (!reader->loadFile(mapped))
 	{
-		delete[] buffer;
-		return reader;
+		delete reader;
+		delete mapped;
+		return NULL;
 	}
-	delete reader;
-	// Chequeamos Hyperspin xml
-	reader = new HyperspinXmlReader();
-	if (reader->load(buffer, size))
+	return reader;
+}
+
+DatReader* DatReaderFactory::createReader(const Format format)
+{
+	switch (format)
 	{
-		delete[] buffer;
-		return reader;
+	case FORMAT_CLRMAMEPRO:
+		return new ClrMameProReader();
+	case FORMAT_LOGIQXXML:
+		return new LogiqxXmlReader();
+	case FORMAT_MAMEXML:
+		return new MameXmlReader();
+	case FORMAT_HYPERSPINXML:
+		return new HyperspinXmlReader();
+	default:
+		return NULL;
 	}
-	delete reader;
+}
+
+DatReader* DatReaderFactory::tryReaders(MappedFile* file)
+{
+	static const Format formats[] = {FORMAT_CLRMAMEPRO, FORMAT_LOGIQXXML, FORMAT_MAMEXML, FORMAT_HYPERSPINXML};
+	DatReader* reader;
+	unsigned int i;
 
+	assert(file);
+
+	for (i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i)
+	{
+		reader = createReader(formats[i]);
+		if (reader->loadFile(file))
+		{
+			return reader;
+		}
+		delete reader;
+	}
 	// No encontramos ningún lector adecuado para el fichero
-	delete[] buffer;
+	delete file;
 	return NULL;
 }
 
+DatReaderFactory::Format DatReaderFactory::sniffFormat(const char* buffer, const unsigned int size)
+{
+	const char* pos = buffer;
+	const char* end;
+	const char* name;
+	const char* found;
+	Glib::ustring root;
+	Format exhausted;
+
+	assert(buffer);
+
+	end = buffer + ((size < DAT_SNIFF_SIZE) ? size : DAT_SNIFF_SIZE);
+	// Si la cabecera no termina dentro de la zona examinada no podemos
+	// descartar el dat, salvo que ya la hayamos examinado completo
+	exhausted = (size > DAT_SNIFF_SIZE) ? FORMAT_UNDETERMINED : FORMAT_UNKNOWN;
+
+	// Saltamos la posible marca BOM de UTF-8
+	if ((end - pos >= 3) && (std::memcmp(pos, "\xEF\xBB\xBF", 3) == 0))
+	{
+		pos += 3;
+	}
+	// Los datos no terminan en nulo, por lo que todas las búsquedas se
+	// realizan acotadas al final de la zona examinada
+	while (pos < end)
+	{
+		// Saltamos los espacios en blanco
+		while ((pos < end) && std::isspace(static_cast<unsigned char>(*pos)))
+		{
+			++pos;
+		}
+		if (pos == end)
+		{
+			break;
+		}
+		// Los dats de ClrMamePro comienzan por el bloque "clrmamepro"
+		if (*pos != '<')
+		{
+			if (end - pos <= 10)
+			{
+				return exhausted;
+			}
+			if ((std::strncmp(pos, "clrmamepro", 10) == 0) &&
+				(std::isspace(static_cast<unsigned char>(pos[10])) || (pos[10] == '(')))
+			{
+				return FORMAT_CLRMAMEPRO;
+			}
+			return FORMAT_UNKNOWN;
+		}
+		// Saltamos declaraciones e instrucciones de procesamiento
+		if (end - pos < 2)
+		{
+			return exhausted;
+		}
+		if (pos[1] == '?')
+		{
+			found = std::search(pos, end, "?>", "?>" + 2);
+			if (found == end)
+			{
+				return exhausted;
+			}
+			pos = found + 2;
+			continue;
+		}
+		// Saltamos los comentarios
+		if ((end - pos >= 4) && (std::strncmp(pos, "<!--", 4) == 0))
+		{
+			found = std::search(pos, end, "-->", "-->" + 3);
+			if (found == end)
+			{
+				return exhausted;
+			}
+			pos = found + 3;
+			continue;
+		}
+		// El DOCTYPE ya indica el nombre del elemento raíz. Nos quedamos con él
+		// ya que algunos dats como los de Mame incluyen una DTD muy extensa
+		if ((end - pos >= 9) && (std::strncmp(pos, "<!DOCTYPE", 9) == 0))
+		{
+			pos += 9;
+			while ((pos < end) && std::isspace(static_cast<unsigned char>(*pos)))
+			{
+				++pos;
+			}
+		}
+		else if (pos[1] == '!')
+		{
+			// Otras declaraciones desconocidas
+			return FORMAT_UNKNOWN;
+		}
+		else
+		{
+			++pos;
+		}
+		// Obtenemos el nombre del elemento raíz
+		name = pos;
+		while ((pos < end) && !std::isspace(static_cast<unsigned char>(*pos)) &&
+			(*pos != '>') && (*pos != '/') && (*pos != '['))
+		{
+			++pos;
+		}
+		if (pos == end)
+		{
+			return exhausted;
+		}
+		root.assign(name, pos);
+		if (root == "datafile")
+		{
+			return FORMAT_LOGIQXXML;
+		}
+		else if (root == "mame")
+		{
+			return FORMAT_MAMEXML;
+		}
+		else if (root == "menu")
+		{
+			return FORMAT_HYPERSPINXML;
+		}
+		return FORMAT_UNKNOWN;
+	}
+	return exhausted;
+}
+
+MappedFile* DatReaderFactory::decompress(MappedFile* file)
+{
+	const char* data;
+	unsigned int size;
+	MappedFile* inflated = NULL;
+	ZipFile zip;
+	std::vector<ZipFile::Entry>::const_iterator iter;
+
+	assert(file);
+
+	data = file->getData();
+	size = file->getSize();
+	// Ficheros gzip
+	if ((size >= GZIP_MIN_SIZE) && (static_cast<unsigned char>(data[0]) == 0x1F) &&
+		(static_cast<unsigned char>(data[1]) == 0x8B))
+	{
+		inflated = inflateGzip(data, size);
+		delete file;
+		return inflated;
+	}
+	// Ficheros zip
+	if (ZipFile::isZip(data, size))
+	{
+		if (zip.open(data, size))
+		{
+			// Usamos el primer fichero que contenga datos
+			for (iter = zip.getEntries().begin(); iter != zip.getEntries().end(); ++iter)
+			{
+				if ((iter->size > 0) && !iter->name.empty() &&
+					(iter->name.raw()[iter->name.bytes() - 1] != '/'))
+				{
+					inflated = new MappedFile();
+					if (!inflated->allocate(iter->size) ||
+						!zip.extract(*iter, inflated->getBuffer()))
+					{
+						delete inflated;
+						inflated = NULL;
+					}
+					break;
+				}
+			}
+		}
+		delete file;
+		return inflated;
+	}
+	// El fichero no está comprimido
+	return file;
+}
+
+MappedFile* DatReaderFactory::inflateGzip(const char* data, const unsigned int size)
+{
+	MappedFile* inflated;
+	z_stream stream;
+	unsigned int capacity;
+	unsigned int written = 0;
+	bool ret = true;
+	int status;
+
+	assert(data);
+	assert(size >= GZIP_MIN_SIZE);
+
+	// La cola del gzip indica el tamaño descomprimido del último miembro
+	// módulo 2^32. Sólo nos sirve como estimación inicial de la memoria
+	capacity = ZipFile::readUint32(data + size - 4);
+	if (capacity < size)
+	{
+		capacity = (size > UINT_MAX / 4) ? UINT_MAX : size * 4;
+	}
+	inflated = new MappedFile();
+	std::memset(&stream, 0, sizeof(stream));
+	// Indicamos a zlib que los datos incluyen la cabecera gzip
+	if (!inflated->allocate(capacity) || (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK))
+	{
+		delete inflated;
+		return NULL;
+	}
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+	stream.avail_in = size;
+
+	while (ret)
+	{
+		stream.next_out = reinterpret_cast<Bytef*>(inflated->getBuffer() + written);
+		stream.avail_out = capacity - written;
+		status = inflate(&stream, Z_NO_FLUSH);
+		written = capacity - stream.avail_out;
+		if (status == Z_STREAM_END)
+		{
+			// Si le sigue otro miembro continuamos con él, en otro caso
+			// ignoramos lo que quede, como hace gzip
+			if ((stream.avail_in < 2) || (stream.next_in[0] != 0x1F) || (stream.next_in[1] != 0x8B))
+			{
+				break;
+			}
+			ret = (inflateReset(&stream) == Z_OK);
+		}
+		else if (status != Z_OK)
+		{
+			// Datos corruptos o truncados
+			ret = false;
+		}
+		else if (stream.avail_out == 0)
+		{
+			// Ampliamos la memoria al doble conservando lo ya descomprimido
+			if (capacity == UINT_MAX)
+			{
+				LOG_ERROR("DatReaderFactory: Uncompressed dat is larger than 4 GB");
+				ret = false;
+			}
+			else
+			{
+				capacity = (capacity > UINT_MAX / 2) ? UINT_MAX : capacity * 2;
+				ret = inflated->resize(capacity);
+			}
+		}
+	}
+	inflateEnd(&stream);
+
+	if (!ret || (written == 0))
+	{
+		delete inflated;
+		return NULL;
+	}
+	// Ajustamos la memoria al tamaño real de los datos
+	if (written < capacity)
+	{
+		inflated->resize(written);
+	}
+	return inflated;
+}
+
 } // namespace bmonkey
@@ -54,11 +54,70 @@ public:
 	 * @param file Path al fichero dat para el que se necesita un lector
 	 * @return El lector adecuado para el fichero o NULL si el formato del
 	 * fichero pasado no está soportado.
+	 * @note Se admiten dats comprimidos en gzip o zip, que se descomprimen
+	 * directamente en memoria sin usar ficheros temporales.
 	 * @note El usuario debe encargarse de liberar la memoria ocupada por el
 	 * lector devuelto por el método.
 	 */
 	static DatReader* getDatReader(const Glib::ustring& file);
 
+private:
+
+	// Formatos de dat reconocidos por la fábrica
+	enum Format
+	{
+		FORMAT_UNKNOWN,
+		FORMAT_UNDETERMINED,
+		FORMAT_CLRMAMEPRO,
+		FORMAT_LOGIQXXML,
+		FORMAT_MAMEXML,
+		FORMAT_HYPERSPINXML
+	};
+
+	/**
+	 * Detecta el formato de un dat examinando únicamente su cabecera
+	 * @param buffer Buffer con los datos del dat
+	 * @param size Tamaño total del buffer
+	 * @return Formato detectado, FORMAT_UNKNOWN si no se reconoce o
+	 * FORMAT_UNDETERMINED si la cabecera no cabe en la zona examinada
+	 */
+	static Format sniffFormat(const char* buffer, const unsigned int size);
+
+	/**
+	 * Descomprime en memoria un dat comprimido en formato gzip o zip
+	 * @param file Fichero proyectado con los datos del dat
+	 * @return Datos descomprimidos, el propio fichero si no estaba comprimido o
+	 * NULL si no se pudo descomprimir
+	 * @note Si el fichero estaba comprimido, el original es liberado
+	 */
+	static MappedFile* decompress(MappedFile* file);
+
+	/**
+	 * Crea un lector para un formato de dat
+	 * @param format Formato del dat
+	 * @return Nuevo lector o NULL si el formato no está soportado
+	 */
+	static DatReader* createReader(const Format format);
+
+	/**
+	 * Busca un lector para un dat probando con todos los disponibles
+	 * @param file Fichero proyectado con los datos del dat
+	 * @return Lector que pudo cargar el dat o NULL si ninguno pudo
+	 * @note Si ningún lector carga el dat, el fichero es liberado
+	 */
+	static DatReader* tryReaders(MappedFile* file);
+
+	/**
+	 * Descomprime en memoria los datos de un fichero gzip
+	 * @param data Datos del fichero gzip
+	 * @param size Tamaño de los datos
+	 * @return Datos descomprimidos o NULL si no se pudieron descomprimir
+	 * @note Se admiten ficheros con varios miembros concatenados, como los
+	 * generados por pigz. Los dats que descomprimidos superan los 4 GB no se
+	 * admiten, al igual que ocurre con los dats sin comprimir
+	 */
+	static MappedFile* inflateGzip(const char* data, const unsigned int size);
+
 };
 
 } // namespace bmonkey
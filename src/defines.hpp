@@ -87,6 +87,7 @@
 // Toda la estructura se montará a partir del directory de trabajo del usuario
 #define USER_LIBRARY_DIR				"library"
 #define USER_COLLECTION_DIR				"collection"		// library/collection
+#define USER_THUMBNAILS_DIR				"thumbnails"		// library/thumbnails
 #define USER_THEMES_DIR					"themes"
 #define USER_SCREENSHOT_DIR				"screenshots"
 
@@ -109,6 +110,7 @@
 #define BMONKEY_COLLECTION_FILE			"collection.xml"
 #define BMONKEY_PLATFORM_FILE			"config.xml"
 #define BMONKEY_GAMES_FILE				"games.xml"
+#define BMONKEY_HASHES_FILE				"hashes.xml"
 #define BMONKEY_LOG_FILE				"bmonkey.log"
 #define BMONKEY_DEFAULT_FONT_FILE		"FreeSans.ttf"
 #define BMONKEY_DEFAULT_THEME			"default"
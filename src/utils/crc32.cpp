@@ -20,11 +20,23 @@
  */
 
 #include "crc32.hpp"
+#include <cassert>
 #include <fstream>
+#include <vector>
+#include <cstring>
+#include "mapped_file.hpp"
+#if defined(CRC32_ENGINE_PCLMUL)
+	#include <immintrin.h>
+#elif defined(CRC32_ENGINE_ARMV8)
+	#include <arm_acle.h>
+	#include <sys/auxv.h>
+	#include <asm/hwcap.h>
+#endif
 
 
-// Definimos el tamaño del buffer interno de 10K
-#define CRC32_BUFF_SIZE 10240
+// Definimos el tamaño del buffer interno de 256K. Las lecturas grandes reducen
+// las llamadas al sistema al verificar muchas roms en paralelo
+#define CRC32_BUFF_SIZE 262144
 
 // Tabla CRC32 pregenerada con el polinomio utilizado por WinZip y PKZIP
 const Crc32::Crc Crc32::m_crc_table[256] =
@@ -97,28 +109,43 @@ const Crc32::Crc Crc32::m_crc_table[256] =
 
 const char Crc32::m_hex_table[] = "0123456789abcdef";
 
+uint32_t Crc32::m_slice_table[8][256];
+
+// El método de cálculo se selecciona una única vez al iniciar el programa
+const Crc32::Engine Crc32::m_engine = Crc32::selectEngine();
+
 
 Crc32::Crc Crc32::Crc32::getCrc32(const Glib::ustring file)
 {
+	MappedFile mapped;
 	std::ifstream file_stream;
 	unsigned int readed;
-	char buff[CRC32_BUFF_SIZE];
+	std::vector<char> buff;
 	Crc crc = 0xFFFFFFFF;
 
-	file_stream.open(file.data());
+	// Siempre que sea posible proyectamos el fichero para calcular el crc
+	// directamente sobre sus páginas, sin copias intermedias
+	if (mapped.open(file))
+	{
+		return getCrc32(mapped.getData(), mapped.getSize());
+	}
+
+	file_stream.open(file.data(), std::ios::in | std::ios::binary);
 	// Comprobamos si la apertura fue correcta
 	if (!file_stream.good())
 	{
 		file_stream.close();
 		return 0;
 	}
+	// Reservamos el buffer en el heap para no cargar la pila de los hilos
+	buff.resize(CRC32_BUFF_SIZE);
 	// Procesamos los datos
 	do
 	{
 		// Cargamos un bloque en el buffer
-		file_stream.read (buff, CRC32_BUFF_SIZE);
+		file_stream.read (&buff[0], CRC32_BUFF_SIZE);
 		readed = file_stream.gcount();
-		crc = getCrc32(buff, readed, crc);
+		crc = getCrc32(&buff[0], readed, crc);
 	}
 	while (!file_stream.eof());
 	file_stream.close();
@@ -127,16 +154,81 @@ Crc32::Crc Crc32::Crc32::getCrc32(const Glib::ustring file)
 	return getCrc32Finalize(crc);
 }
 
-Crc32::Crc Crc32::getCrc32(char* data, const unsigned int size)
+Crc32::Crc Crc32::getCrc32(const char* data, const unsigned int size)
 {
 	return getCrc32Finalize( getCrc32(data, size, 0xFFFFFFFF) );
 }
 
-Crc32::Crc Crc32::getCrc32(char* data, const unsigned int size,	const Crc crc)
+Crc32::Crc Crc32::getCrc32(const char* data, const unsigned int size,	const Crc crc)
+{
+	return m_engine(reinterpret_cast<const unsigned char*>(data), size, crc);
+}
+
+Glib::ustring Crc32::getEngineName(void)
+{
+#if defined(CRC32_ENGINE_PCLMUL)
+	if (m_engine == getCrc32Pclmul)
+	{
+		return "pclmulqdq";
+	}
+#endif
+#if defined(CRC32_ENGINE_ARMV8)
+	if (m_engine == getCrc32Armv8)
+	{
+		return "armv8-crc32";
+	}
+#endif
+	return "slicing-by-8";
+}
+
+bool Crc32::isEngineSupported(const EngineType type)
+{
+	switch (type)
+	{
+	case ENGINE_TABLE:
+	case ENGINE_SLICING8:
+		return true;
+#if defined(CRC32_ENGINE_PCLMUL)
+	case ENGINE_PCLMUL:
+		__builtin_cpu_init();
+		return (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1"));
+#endif
+#if defined(CRC32_ENGINE_ARMV8)
+	case ENGINE_ARMV8:
+		return ((getauxval(AT_HWCAP) & HWCAP_CRC32) != 0);
+#endif
+	default:
+		return false;
+	}
+}
+
+Crc32::Crc Crc32::getCrc32(const char* data, const unsigned int size, const Crc crc, const EngineType type)
+{
+	const unsigned char* buff = reinterpret_cast<const unsigned char*>(data);
+
+	assert(isEngineSupported(type));
+	switch (type)
+	{
+#if defined(CRC32_ENGINE_PCLMUL)
+	case ENGINE_PCLMUL:
+		return getCrc32Pclmul(buff, size, crc);
+#endif
+#if defined(CRC32_ENGINE_ARMV8)
+	case ENGINE_ARMV8:
+		return getCrc32Armv8(buff, size, crc);
+#endif
+	case ENGINE_SLICING8:
+		return getCrc32Slicing8(buff, size, crc);
+	default:
+		return getCrc32Table(buff, size, crc);
+	}
+}
+
+uint32_t Crc32::getCrc32Table(const unsigned char* data, unsigned int size, uint32_t crc)
 {
-    char* end_data = NULL;
-    char* p = NULL;
-    Crc return_crc = crc;
+    const unsigned char* end_data = NULL;
+    const unsigned char* p = NULL;
+    uint32_t return_crc = crc;
 
     // Aplicamos el algoritmo de cálculo del crc
     end_data = data + size;
@@ -148,9 +240,234 @@ Crc32::Crc Crc32::getCrc32(char* data, const unsigned int size,	const Crc crc)
     return(return_crc);
 }
 
+uint32_t Crc32::getCrc32Slicing8(const unsigned char* data, unsigned int size, uint32_t crc)
+{
+	uint32_t one, two;
+
+	// Procesamos byte a byte hasta alinear los datos a 8 bytes
+	while ((size > 0) && (reinterpret_cast<uintptr_t>(data) & 7))
+	{
+		crc = m_slice_table[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+		--size;
+	}
+	// Bloques de 8 bytes. Componemos las palabras byte a byte para que el
+	// resultado no dependa del orden de bytes de la máquina
+	while (size >= 8)
+	{
+		one = crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) |
+			(static_cast<uint32_t>(data[3]) << 24));
+		two = data[4] | (data[5] << 8) | (data[6] << 16) |
+			(static_cast<uint32_t>(data[7]) << 24);
+		crc = m_slice_table[7][one & 0xFF] ^
+			m_slice_table[6][(one >> 8) & 0xFF] ^
+			m_slice_table[5][(one >> 16) & 0xFF] ^
+			m_slice_table[4][one >> 24] ^
+			m_slice_table[3][two & 0xFF] ^
+			m_slice_table[2][(two >> 8) & 0xFF] ^
+			m_slice_table[1][(two >> 16) & 0xFF] ^
+			m_slice_table[0][two >> 24];
+		data += 8;
+		size -= 8;
+	}
+	// Bytes restantes
+	while (size > 0)
+	{
+		crc = m_slice_table[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+		--size;
+	}
+	return crc;
+}
+
+#if defined(CRC32_ENGINE_PCLMUL)
+
+/*
+ * Plegado del crc mediante multiplicaciones sin acarreo según el documento de
+ * Intel "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+ * Instruction". Las constantes corresponden al polinomio reflejado del crc32.
+ */
+__attribute__((target("sse4.1,pclmul")))
+uint32_t Crc32::getCrc32Pclmul(const unsigned char* data, unsigned int size, uint32_t crc)
+{
+	static const uint64_t k1k2[] __attribute__((aligned(16))) = {0x0154442bd4, 0x01c6e41596};
+	static const uint64_t k3k4[] __attribute__((aligned(16))) = {0x01751997d0, 0x00ccaa009e};
+	static const uint64_t k5k0[] __attribute__((aligned(16))) = {0x0163cd6124, 0x0000000000};
+	static const uint64_t poly[] __attribute__((aligned(16))) = {0x01db710641, 0x01f7011641};
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+	unsigned int tail;
+
+	// El plegado necesita al menos un bloque de 64 bytes
+	if (size < 64)
+	{
+		return getCrc32Slicing8(data, size, crc);
+	}
+	tail = size & 15;
+	size -= tail;
+
+	x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+	x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+	x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+	x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+	x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+	data += 64;
+	size -= 64;
+
+	// Plegado en paralelo de bloques de 64 bytes
+	while (size >= 64)
+	{
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+		y5 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+		y6 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+		y7 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+		y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+		data += 64;
+		size -= 64;
+	}
+
+	// Plegado de los cuatro bloques en uno de 128 bits
+	x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	// Plegado de los bloques restantes de 16 bytes
+	while (size >= 16)
+	{
+		x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+		data += 16;
+		size -= 16;
+	}
+
+	// Reducción de 128 a 64 bits
+	x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+	x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+	x1 = _mm_srli_si128(x1, 8);
+	x1 = _mm_xor_si128(x1, x2);
+	x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, x3);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	// Reducción de Barrett a 32 bits
+	x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+	x2 = _mm_and_si128(x1, x3);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+	x2 = _mm_and_si128(x2, x3);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+	crc = _mm_extract_epi32(x1, 1);
+
+	// Los bytes que no completan un bloque se procesan con tablas
+	return getCrc32Slicing8(data, tail, crc);
+}
+
+#endif
+
+#if defined(CRC32_ENGINE_ARMV8)
+
+__attribute__((target("+crc")))
+uint32_t Crc32::getCrc32Armv8(const unsigned char* data, unsigned int size, uint32_t crc)
+{
+	uint64_t word;
+
+	// Procesamos byte a byte hasta alinear los datos a 8 bytes
+	while ((size > 0) && (reinterpret_cast<uintptr_t>(data) & 7))
+	{
+		crc = __crc32b(crc, *data++);
+		--size;
+	}
+	while (size >= 8)
+	{
+		std::memcpy(&word, data, 8);
+		crc = __crc32d(crc, word);
+		data += 8;
+		size -= 8;
+	}
+	while (size > 0)
+	{
+		crc = __crc32b(crc, *data++);
+		--size;
+	}
+	return crc;
+}
+
+#endif
+
+Crc32::Engine Crc32::selectEngine(void)
+{
+	// Bloque de datos para comprobar que los métodos acelerados producen los
+	// mismos resultados que el método de referencia
+	unsigned char check[1031];
+	unsigned int i, j;
+	Engine engine = getCrc32Slicing8;
+
+	// Generamos las tablas de slicing-by-8 a partir de la tabla básica
+	for (i = 0; i < 256; ++i)
+	{
+		m_slice_table[0][i] = m_crc_table[i];
+	}
+	for (i = 0; i < 256; ++i)
+	{
+		for (j = 1; j < 8; ++j)
+		{
+			m_slice_table[j][i] = (m_slice_table[j - 1][i] >> 8) ^
+				m_slice_table[0][m_slice_table[j - 1][i] & 0xFF];
+		}
+	}
+
+#if defined(CRC32_ENGINE_PCLMUL)
+	if (isEngineSupported(ENGINE_PCLMUL))
+	{
+		engine = getCrc32Pclmul;
+	}
+#elif defined(CRC32_ENGINE_ARMV8)
+	if (isEngineSupported(ENGINE_ARMV8))
+	{
+		engine = getCrc32Armv8;
+	}
+#endif
+
+	// Si el método elegido no coincide con el de referencia usamos las tablas
+	for (i = 0; i < sizeof(check); ++i)
+	{
+		check[i] = (i * 131 + 7) & 0xFF;
+	}
+	for (i = 0; i < sizeof(check); i += 97)
+	{
+		if (engine(check + (i & 7), sizeof(check) - i, 0xFFFFFFFF) !=
+			getCrc32Table(check + (i & 7), sizeof(check) - i, 0xFFFFFFFF))
+		{
+			return getCrc32Slicing8;
+		}
+	}
+	return engine;
+}
+
 Crc32::Crc Crc32::getCrc32Finalize(const Crc crc)
 {
-	return ~crc;
+	// Crc puede tener más de 32 bits, descartamos los bits superiores
+	return (~crc & 0xFFFFFFFF);
 }
 
 Crc32::Crc Crc32::fromString(const Glib::ustring crc)
@@ -23,12 +23,27 @@
 #define _CRC32_HPP_
 
 #include <glibmm/ustring.h>
+#include <stdint.h>
+#include "os_detect.hpp"
+
+// Métodos de cálculo acelerados por hardware disponibles según el compilador y
+// la arquitectura
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define CRC32_ENGINE_PCLMUL
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(OS_LINUX)
+	#define CRC32_ENGINE_ARMV8
+#endif
 
 
 /**
  * Cálculo y transformaciones del CRC32 utilizando el mismo polinomio que
  * programas como WinZip y PKZIP. Este es el tipo de crc utilizado en los
  * archivos .zip.
+ *
+ * El cálculo se realiza con el método más rápido disponible en el procesador,
+ * seleccionado en tiempo de ejecución: instrucciones PCLMULQDQ en x86,
+ * instrucciones CRC32 en ARMv8 o slicing-by-8 mediante tablas en el resto.
+ * Todos los métodos producen exactamente el mismo resultado.
  */
 class Crc32
 {
@@ -37,6 +52,16 @@ public:
 	/** Tipo para representar el crc */
 	typedef unsigned long Crc;
 
+	// Métodos de cálculo del crc
+	enum EngineType
+	{
+		ENGINE_TABLE = 0,	/**< Referencia byte a byte mediante la tabla básica */
+		ENGINE_SLICING8,	/**< Slicing-by-8 mediante tablas */
+		ENGINE_PCLMUL,		/**< Instrucciones PCLMULQDQ de x86 */
+		ENGINE_ARMV8,		/**< Instrucciones CRC32 de ARMv8 */
+		ENGINE_COUNT
+	};
+
 	/**
 	 * Calcula el crc32 de un fichero dado
 	 * @param p_file Path al fichero del que calcular su crc
@@ -50,7 +75,7 @@ public:
 	 * @param size Tamaño del buffer de datos
 	 * @return crc32 calculado
 	 */
-	static Crc getCrc32(char* data, const unsigned int size);
+	static Crc getCrc32(const char* data, const unsigned int size);
 
 	/**
 	 * Calcula el crc32 de los datos en un buffer continuando un crc previo
@@ -60,13 +85,13 @@ public:
 	 * @return crc32 calculado
 	 * @note Después de finalizar hay que llamar a getCrc32Finalize
 	 */
-	static Crc getCrc32(char* data, const unsigned int size, const Crc crc);
+	static Crc getCrc32(const char* data, const unsigned int size, const Crc crc);
 
 	/**
 	 * Finaliza el cálculo de un crc32 realizado con getCrc32 con continuación
 	 * @param crc Crc32 a finalizar
 	 */
-	inline static Crc getCrc32Finalize(const Crc crc);
+	static Crc getCrc32Finalize(const Crc crc);
 
 	/**
 	 * Convierte un crc32 en una cadena de texto a TCrc32 (unsigned long)
@@ -83,7 +108,85 @@ public:
 	 */
 	static Glib::ustring toString(Crc crc);
 
+	/**
+	 * Obtiene el nombre del método de cálculo seleccionado para el procesador
+	 * @return Nombre descriptivo del método de cálculo
+	 */
+	static Glib::ustring getEngineName(void);
+
+	/**
+	 * Indica si un método de cálculo está disponible en el procesador
+	 * @param type Método de cálculo a comprobar
+	 * @return true si el método se puede usar, false en otro caso
+	 */
+	static bool isEngineSupported(const EngineType type);
+
+	/**
+	 * Calcula el crc32 de los datos en un buffer continuando un crc previo con
+	 * un método de cálculo concreto, en lugar del seleccionado
+	 * @param data Comienzo del buffer de datos
+	 * @param size Tamaño del buffer de datos
+	 * @param crc Crc32 de entrada
+	 * @param type Método de cálculo a usar
+	 * @return crc32 calculado
+	 * @note El método debe estar disponible según isEngineSupported. Después
+	 * de finalizar hay que llamar a getCrc32Finalize
+	 * @note Pensado para comprobar y medir los métodos entre sí
+	 */
+	static Crc getCrc32(const char* data, const unsigned int size, const Crc crc, const EngineType type);
+
 private:
+	/** Tipo para los métodos de cálculo del crc sin finalizar */
+	typedef uint32_t (*Engine)(const unsigned char* data, unsigned int size, uint32_t crc);
+
+	/**
+	 * Cálculo de referencia byte a byte mediante la tabla básica
+	 * @param data Comienzo del buffer de datos
+	 * @param size Tamaño del buffer de datos
+	 * @param crc Crc32 de entrada
+	 * @return crc32 calculado sin finalizar
+	 */
+	static uint32_t getCrc32Table(const unsigned char* data, unsigned int size, uint32_t crc);
+
+	/**
+	 * Cálculo mediante slicing-by-8, procesando 8 bytes en cada paso
+	 * @param data Comienzo del buffer de datos
+	 * @param size Tamaño del buffer de datos
+	 * @param crc Crc32 de entrada
+	 * @return crc32 calculado sin finalizar
+	 */
+	static uint32_t getCrc32Slicing8(const unsigned char* data, unsigned int size, uint32_t crc);
+
+#if defined(CRC32_ENGINE_PCLMUL)
+	/**
+	 * Cálculo mediante plegado con multiplicaciones sin acarreo (PCLMULQDQ)
+	 * @param data Comienzo del buffer de datos
+	 * @param size Tamaño del buffer de datos
+	 * @param crc Crc32 de entrada
+	 * @return crc32 calculado sin finalizar
+	 */
+	static uint32_t getCrc32Pclmul(const unsigned char* data, unsigned int size, uint32_t crc);
+#endif
+
+#if defined(CRC32_ENGINE_ARMV8)
+	/**
+	 * Cálculo mediante las instrucciones CRC32 de ARMv8
+	 * @param data Comienzo del buffer de datos
+	 * @param size Tamaño del buffer de datos
+	 * @param crc Crc32 de entrada
+	 * @return crc32 calculado sin finalizar
+	 */
+	static uint32_t getCrc32Armv8(const unsigned char* data, unsigned int size, uint32_t crc);
+#endif
+
+	/**
+	 * Genera las tablas de slicing-by-8 y selecciona el método de cálculo
+	 * @return Método de cálculo seleccionado
+	 */
+	static Engine selectEngine(void);
+
+	static uint32_t m_slice_table[8][256];	/**< Tablas para el cálculo slicing-by-8 */
+	static const Engine m_engine;		/**< Método de cálculo seleccionado */
 	static const Crc m_crc_table[];		/**< Tabla de generada con el polinomio utilizado por WinZip y PKZIP */
 	static const char m_hex_table[];	/**< Tabla con caracteres hexadecimales para toString */
 };
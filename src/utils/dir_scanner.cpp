@@ -0,0 +1,299 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "dir_scanner.hpp"
+#include <cstring>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if defined(OS_POSIX)
+	#include <dirent.h>
+#endif
+#if defined(OS_LINUX)
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/syscall.h>
+#elif !defined(OS_POSIX)
+	#include <glibmm/fileutils.h>
+#endif
+#include <glibmm/miscutils.h>
+
+#ifdef OS_LINUX
+	// Tamaño del buffer para la lectura de entradas con getdents
+	#define DIR_SCANNER_BUFF_SIZE 131072
+
+	/**
+	 * Entrada de directorio devuelta por getdents64
+	 */
+	struct LinuxDirent64
+	{
+		ino64_t d_ino;
+		off64_t d_off;
+		unsigned short d_reclen;
+		unsigned char d_type;
+		char d_name[];
+	};
+#endif
+
+#if defined(OS_POSIX)
+/**
+ * Obtiene el tipo de una entrada a partir de su path, siguiendo los enlaces
+ * @param path Path de la entrada
+ * @param link Lugar de retorno que indica si la entrada es un enlace
+ * @return Tipo de la entrada
+ */
+static DirScanner::EntryType getEntryType(const std::string& path, bool& link)
+{
+	struct stat info;
+
+	if (lstat(path.c_str(), &info) != 0)
+	{
+		return DirScanner::ENTRY_OTHER;
+	}
+	link = S_ISLNK(info.st_mode);
+	if (link && (stat(path.c_str(), &info) != 0))
+	{
+		return DirScanner::ENTRY_OTHER;
+	}
+	if (S_ISREG(info.st_mode))
+	{
+		return DirScanner::ENTRY_FILE;
+	}
+	else if (S_ISDIR(info.st_mode))
+	{
+		return DirScanner::ENTRY_DIR;
+	}
+	return DirScanner::ENTRY_OTHER;
+}
+
+/**
+ * Obtiene el tipo de una entrada a partir del tipo informado por el sistema
+ * @param dir Path del directorio de la entrada
+ * @param name Nombre de la entrada
+ * @param type Tipo de la entrada según el sistema (d_type)
+ * @param link Lugar de retorno que indica si la entrada es un enlace
+ * @return Tipo de la entrada
+ */
+static DirScanner::EntryType getEntryType(const std::string& dir, const char* name, const unsigned char type, bool& link)
+{
+	link = false;
+	switch (type)
+	{
+	case DT_REG:
+		return DirScanner::ENTRY_FILE;
+	case DT_DIR:
+		return DirScanner::ENTRY_DIR;
+	// Solo consultamos los enlaces y los sistemas que no informan del tipo
+	case DT_LNK:
+	case DT_UNKNOWN:
+		return getEntryType(dir + G_DIR_SEPARATOR_S + name, link);
+	default:
+		return DirScanner::ENTRY_OTHER;
+	}
+}
+#endif
+
+DirScanner::DirScanner(const unsigned int threads):
+	m_pool(threads),
+	m_recursive(true),
+	m_dirs(0),
+	m_files(0),
+	m_errors(0)
+{
+}
+
+DirScanner::~DirScanner(void)
+{
+	m_pool.clear();
+	m_pool.wait();
+}
+
+bool DirScanner::scan(const Glib::ustring& path, const Callback& callback, const bool recursive)
+{
+	assert(!path.empty());
+	assert(callback);
+
+	m_callback = callback;
+	m_recursive = recursive;
+	m_dirs = 0;
+	m_files = 0;
+	m_errors = 0;
+	m_visited.clear();
+
+	// Cada directorio es una tarea, las subtareas se encolan desde los hilos
+	m_pool.addTask(std::bind(&DirScanner::scanDir, this, path, false));
+	m_pool.wait();
+
+	m_callback = nullptr;
+	m_visited.clear();
+	return (m_dirs > 0);
+}
+
+void DirScanner::scanDir(const Glib::ustring path, const bool link)
+{
+	std::vector<Entry> entries;
+	std::vector<Entry>::iterator iter;
+	unsigned int files = 0;
+
+	// Todos los directorios se registran, pero sólo se descartan los
+	// alcanzados por un enlace, que son los únicos que pueden formar ciclos
+	if (!markVisited(path) && link)
+	{
+		return;
+	}
+	if (!readDir(path, entries))
+	{
+		++m_errors;
+		return;
+	}
+	++m_dirs;
+	for (iter = entries.begin(); iter != entries.end(); ++iter)
+	{
+		if (iter->type == ENTRY_FILE)
+		{
+			++files;
+		}
+		else if (m_recursive && (iter->type == ENTRY_DIR))
+		{
+#if !defined(OS_POSIX)
+			// Sin inodos no podemos detectar los ciclos
+			if (iter->link)
+			{
+				continue;
+			}
+#endif
+			m_pool.addTask(std::bind(&DirScanner::scanDir, this, Glib::ustring(path.raw() + G_DIR_SEPARATOR_S + iter->name), iter->link));
+		}
+	}
+	m_files += files;
+	if (!entries.empty())
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_callback(path, entries);
+	}
+}
+
+bool DirScanner::markVisited(const Glib::ustring& path)
+{
+#if defined(OS_POSIX)
+	struct stat info;
+
+	if (stat(path.c_str(), &info) != 0)
+	{
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(m_visited_mutex);
+	return m_visited.insert(std::make_pair(static_cast<unsigned long long>(info.st_dev),
+		static_cast<unsigned long long>(info.st_ino))).second;
+#else
+	return true;
+#endif
+}
+
+bool DirScanner::readDir(const Glib::ustring& path, std::vector<Entry>& entries)
+{
+	Entry entry;
+
+	assert(!path.empty());
+
+#if defined(OS_LINUX)
+	std::vector<char> buffer(DIR_SCANNER_BUFF_SIZE);
+	const LinuxDirent64* dirent;
+	long size, pos;
+	int fd;
+
+	fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		return false;
+	}
+	// Cada llamada devuelve tantas entradas como quepan en el buffer
+	while ((size = syscall(SYS_getdents64, fd, &buffer[0], buffer.size())) > 0)
+	{
+		for (pos = 0; pos < size; pos += dirent->d_reclen)
+		{
+			dirent = reinterpret_cast<const LinuxDirent64*>(&buffer[pos]);
+			if ((dirent->d_name[0] == '.') && ((dirent->d_name[1] == '\0') ||
+				((dirent->d_name[1] == '.') && (dirent->d_name[2] == '\0'))))
+			{
+				continue;
+			}
+			entry.name = dirent->d_name;
+			entry.type = getEntryType(path.raw(), dirent->d_name, dirent->d_type, entry.link);
+			entries.push_back(entry);
+		}
+	}
+	::close(fd);
+	return (size == 0);
+#elif defined(OS_POSIX)
+	const struct dirent* dirent;
+	DIR* dir;
+
+	dir = opendir(path.c_str());
+	if (!dir)
+	{
+		return false;
+	}
+	while ((dirent = readdir(dir)) != NULL)
+	{
+		if ((std::strcmp(dirent->d_name, ".") == 0) || (std::strcmp(dirent->d_name, "..") == 0))
+		{
+			continue;
+		}
+		entry.name = dirent->d_name;
+		entry.type = getEntryType(path.raw(), dirent->d_name, dirent->d_type, entry.link);
+		entries.push_back(entry);
+	}
+	closedir(dir);
+	return true;
+#else
+	Glib::Dir::iterator iter;
+	Glib::ustring file;
+
+	try
+	{
+		Glib::Dir dir(path);
+		for (iter = dir.begin(); iter != dir.end(); ++iter)
+		{
+			file = Glib::build_filename(path, (*iter));
+			entry.name = (*iter);
+			entry.link = Glib::file_test(file, Glib::FILE_TEST_IS_SYMLINK);
+			if (Glib::file_test(file, Glib::FILE_TEST_IS_DIR))
+			{
+				entry.type = ENTRY_DIR;
+			}
+			else if (Glib::file_test(file, Glib::FILE_TEST_IS_REGULAR))
+			{
+				entry.type = ENTRY_FILE;
+			}
+			else
+			{
+				entry.type = ENTRY_OTHER;
+			}
+			entries.push_back(entry);
+		}
+		return true;
+	}
+	catch (Glib::Error& e)
+	{
+		return false;
+	}
+#endif
+}
@@ -0,0 +1,173 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _DIR_SCANNER_HPP_
+#define _DIR_SCANNER_HPP_
+
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+// Si no está definido el modo debug, desactivamos los asserts
+#ifndef ENABLE_DEBUG_MODE
+	#define NDEBUG
+#endif
+
+#include <cassert>
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <set>
+#include <utility>
+#include <glibmm/ustring.h>
+#include "os_detect.hpp"
+#include "thread_pool.hpp"
+
+
+/**
+ * Recorrido rápido de árboles de directorios.
+ *
+ * Lee cada directorio en bloques grandes obteniendo el tipo de las entradas
+ * directamente del sistema (getdents en Linux), sin necesidad de consultar
+ * cada fichero por separado salvo en los sistemas de ficheros que no lo
+ * informan o en los enlaces simbólicos.
+ * Los subdirectorios se reparten entre un conjunto de hilos de trabajo y las
+ * entradas de cada directorio se entregan a medida que se leen mediante un
+ * callback, sin esperar a recorrer el árbol completo.
+ */
+class DirScanner
+{
+public:
+
+	/**
+	 * Tipos de entradas de un directorio
+	 */
+	enum EntryType
+	{
+		ENTRY_FILE = 0,			/**< Fichero regular */
+		ENTRY_DIR,				/**< Directorio */
+		ENTRY_OTHER				/**< Cualquier otro tipo de entrada */
+	};
+
+	/**
+	 * Entrada de un directorio
+	 */
+	struct Entry
+	{
+		std::string name;		/**< Nombre de la entrada dentro del directorio */
+		EntryType type;			/**< Tipo de la entrada */
+		bool link;				/**< Indica si la entrada es un enlace simbólico */
+	};
+
+	/**
+	 * Tipo para el callback que recibe las entradas de cada directorio
+	 * @param dir Path del directorio leído
+	 * @param entries Entradas del directorio, sin incluir "." y ".."
+	 */
+	typedef std::function<void (const Glib::ustring& dir, const std::vector<Entry>& entries)> Callback;
+
+	/**
+	 * Constructor parametrizado
+	 * @param threads Número de hilos de trabajo a usar, 0 para usar uno por
+	 * cada núcleo disponible. En discos mecánicos conviene usar pocos hilos
+	 */
+	DirScanner(const unsigned int threads = 0);
+
+	/**
+	 * Destructor de la clase
+	 */
+	~DirScanner(void);
+
+	/**
+	 * Recorre un directorio entregando sus entradas al callback
+	 * @param path Path del directorio a recorrer
+	 * @param callback Función que recibirá las entradas de cada directorio
+	 * @param recursive Indica si se recorren también los subdirectorios
+	 * @return true si se pudo leer el directorio inicial, false en otro caso
+	 * @note El método bloquea hasta recorrer todo el árbol. El callback se
+	 * llama desde los hilos de trabajo pero nunca de forma simultánea
+	 * @note Los enlaces a directorios se recorren salvo que apunten a un
+	 * directorio ya recorrido, lo que evita los ciclos. En los sistemas sin
+	 * identificadores de inodo no se recorren
+	 */
+	bool scan(const Glib::ustring& path, const Callback& callback, const bool recursive = true);
+
+	/**
+	 * Obtiene el número de directorios leídos en el último recorrido
+	 * @return Número de directorios leídos
+	 */
+	unsigned int getDirCount(void) const;
+
+	/**
+	 * Obtiene el número de ficheros encontrados en el último recorrido
+	 * @return Número de ficheros encontrados
+	 */
+	unsigned int getFileCount(void) const;
+
+	/**
+	 * Obtiene el número de directorios que no se pudieron leer en el último
+	 * recorrido
+	 * @return Número de errores de lectura
+	 */
+	unsigned int getErrorCount(void) const;
+
+	/**
+	 * Lee las entradas de un único directorio
+	 * @param path Path del directorio
+	 * @param entries Vector donde se añaden las entradas leídas
+	 * @return true si se pudo leer el directorio, false en otro caso
+	 * @note Los enlaces simbólicos se resuelven para obtener su tipo
+	 */
+	static bool readDir(const Glib::ustring& path, std::vector<Entry>& entries);
+
+private:
+	/**
+	 * Lee un directorio desde un hilo de trabajo y encola sus subdirectorios
+	 * @param path Path del directorio
+	 * @param link Indica si se ha llegado al directorio a través de un enlace
+	 */
+	void scanDir(const Glib::ustring path, const bool link);
+
+	/**
+	 * Registra un directorio como recorrido
+	 * @param path Path del directorio
+	 * @return true si no se había recorrido antes, false en otro caso o si no
+	 * se pudo identificar
+	 */
+	bool markVisited(const Glib::ustring& path);
+
+	ThreadPool m_pool;					/**< Hilos de trabajo del recorrido */
+	Callback m_callback;				/**< Callback del recorrido en curso */
+	bool m_recursive;					/**< Indica si se recorren los subdirectorios */
+	std::mutex m_mutex;					/**< Serialización de las llamadas al callback */
+	std::mutex m_visited_mutex;			/**< Protección de los directorios recorridos */
+	std::set<std::pair<unsigned long long, unsigned long long> > m_visited;	/**< Dispositivo e inodo de los directorios recorridos */
+	std::atomic<unsigned int> m_dirs;	/**< Directorios leídos */
+	std::atomic<unsigned int> m_files;	/**< Ficheros encontrados */
+	std::atomic<unsigned int> m_errors;	/**< Directorios no leídos */
+};
+
+// Inclusión de los métodos inline
+#include "dir_scanner.inl"
+
+#endif // _DIR_SCANNER_HPP_
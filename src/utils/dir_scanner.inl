@@ -0,0 +1,40 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _DIR_SCANNER_INL_
+#define _DIR_SCANNER_INL_
+
+inline unsigned int DirScanner::getDirCount(void) const
+{
+	return m_dirs;
+}
+
+inline unsigned int DirScanner::getFileCount(void) const
+{
+	return m_files;
+}
+
+inline unsigned int DirScanner::getErrorCount(void) const
+{
+	return m_errors;
+}
+
+#endif // _DIR_SCANNER_INL_
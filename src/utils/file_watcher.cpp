@@ -0,0 +1,274 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "file_watcher.hpp"
+#ifdef OS_LINUX
+	#include <sys/inotify.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+	#include <climits>
+#endif
+#include "log.hpp"
+
+#ifdef OS_LINUX
+	// Eventos de inotify que nos interesan de cada directorio
+	#define FILE_WATCHER_MASK (IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+	// Tamaño del buffer de lectura de eventos (caben al menos 64 eventos)
+	#define FILE_WATCHER_BUFF_SIZE (64 * (sizeof(struct inotify_event) + NAME_MAX + 1))
+#endif
+
+// Segundos tras los que un fichero creado se notifica aunque no se cierre
+#define FILE_WATCHER_CREATED_TIMEOUT 30
+// Número máximo de ficheros creados pendientes de escritura
+#define FILE_WATCHER_MAX_CREATED 1024
+
+FileWatcher::FileWatcher(void):
+	m_fd(-1)
+{
+#ifdef OS_LINUX
+	m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_fd < 0)
+	{
+		LOG_ERROR("FileWatcher: Can't initialize inotify");
+	}
+#endif
+}
+
+FileWatcher::~FileWatcher(void)
+{
+	clear();
+#ifdef OS_LINUX
+	if (m_fd >= 0)
+	{
+		::close(m_fd);
+	}
+#endif
+}
+
+int FileWatcher::addWatch(const Glib::ustring& dir)
+{
+	int watch = -1;
+
+	assert(!dir.empty());
+
+#ifdef OS_LINUX
+	if (m_fd < 0)
+	{
+		return -1;
+	}
+	watch = inotify_add_watch(m_fd, dir.c_str(), FILE_WATCHER_MASK | IN_ONLYDIR);
+	if (watch < 0)
+	{
+		LOG_ERROR("FileWatcher: Can't watch directory \"" << dir << "\"");
+		return -1;
+	}
+	m_watches[watch] = dir;
+#endif
+	return watch;
+}
+
+void FileWatcher::removeWatch(const int watch)
+{
+	std::unordered_map<int, Glib::ustring>::iterator iter;
+
+	iter = m_watches.find(watch);
+	if (iter != m_watches.end())
+	{
+#ifdef OS_LINUX
+		inotify_rm_watch(m_fd, watch);
+#endif
+		m_watches.erase(iter);
+		forgetCreated(watch);
+	}
+}
+
+void FileWatcher::clear(void)
+{
+	while (!m_watches.empty())
+	{
+		removeWatch(m_watches.begin()->first);
+	}
+	m_created.clear();
+}
+
+Glib::ustring FileWatcher::getDir(const int watch) const
+{
+	std::unordered_map<int, Glib::ustring>::const_iterator iter;
+
+	iter = m_watches.find(watch);
+	if (iter != m_watches.end())
+	{
+		return iter->second;
+	}
+	return "";
+}
+
+bool FileWatcher::pollEvents(std::vector<Event>& events)
+{
+	std::vector<Event>::size_type count;
+
+	count = events.size();
+#ifdef OS_LINUX
+	char buffer[FILE_WATCHER_BUFF_SIZE] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event* inotify;
+	Event event;
+	Created created;
+	std::string key;
+	ssize_t size;
+	char* pos;
+	bool exists;
+
+	if (m_fd < 0)
+	{
+		return false;
+	}
+	// Leemos hasta vaciar la cola del descriptor
+	while ((size = ::read(m_fd, buffer, sizeof(buffer))) > 0)
+	{
+		for (pos = buffer; pos < buffer + size; pos += sizeof(struct inotify_event) + inotify->len)
+		{
+			inotify = reinterpret_cast<const struct inotify_event*>(pos);
+			event.watch = inotify->wd;
+			event.name.clear();
+			if (inotify->mask & IN_Q_OVERFLOW)
+			{
+				LOG_INFO("FileWatcher: Event queue overflow");
+				event.watch = -1;
+				event.type = EVENT_OVERFLOW;
+				events.push_back(event);
+				continue;
+			}
+			// El directorio ha desaparecido, el sistema elimina la vigilancia
+			if (inotify->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF))
+			{
+				m_watches.erase(inotify->wd);
+				forgetCreated(inotify->wd);
+				continue;
+			}
+			if ((inotify->len == 0) || (inotify->mask & IN_ISDIR))
+			{
+				continue;
+			}
+			event.name = inotify->name;
+			key = std::to_string(inotify->wd) + "/" + inotify->name;
+			if (inotify->mask & IN_CREATE)
+			{
+				// Los enlaces y ficheros especiales no se escriben, por lo que
+				// se notifican ya. Del resto esperamos a que se escriban
+				if (isPendingWrite(inotify->wd, event.name, exists) && (m_created.size() < FILE_WATCHER_MAX_CREATED))
+				{
+					created.watch = inotify->wd;
+					created.name = event.name;
+					created.time = std::time(NULL);
+					m_created[key] = created;
+					continue;
+				}
+				if (!exists)
+				{
+					continue;
+				}
+				event.type = EVENT_ADDED;
+			}
+			else if (inotify->mask & IN_CLOSE_WRITE)
+			{
+				event.type = (m_created.erase(key) > 0) ? EVENT_ADDED : EVENT_CHANGED;
+			}
+			else if (inotify->mask & IN_MOVED_TO)
+			{
+				event.type = EVENT_ADDED;
+			}
+			else
+			{
+				m_created.erase(key);
+				event.type = EVENT_REMOVED;
+			}
+			events.push_back(event);
+		}
+	}
+	expireCreated(events);
+#endif
+	return (events.size() > count);
+}
+
+bool FileWatcher::isPendingWrite(const int watch, const Glib::ustring& name, bool& exists) const
+{
+#ifdef OS_LINUX
+	struct stat file_stat;
+
+	exists = (lstat((getDir(watch) + "/" + name).c_str(), &file_stat) == 0);
+	// Un fichero regular con varios enlaces es un enlace duro a uno existente
+	return exists && S_ISREG(file_stat.st_mode) && (file_stat.st_nlink == 1);
+#else
+	exists = false;
+	return false;
+#endif
+}
+
+void FileWatcher::expireCreated(std::vector<Event>& events)
+{
+	std::unordered_map<std::string, Created>::iterator iter;
+	std::time_t now;
+	Event event;
+	bool exists;
+
+	if (m_created.empty())
+	{
+		return;
+	}
+	now = std::time(NULL);
+	iter = m_created.begin();
+	while (iter != m_created.end())
+	{
+		if (now - iter->second.time < FILE_WATCHER_CREATED_TIMEOUT)
+		{
+			++iter;
+			continue;
+		}
+		// Si sigue existiendo lo notificamos, aunque aún se esté escribiendo
+		isPendingWrite(iter->second.watch, iter->second.name, exists);
+		if (exists)
+		{
+			event.watch = iter->second.watch;
+			event.type = EVENT_ADDED;
+			event.name = iter->second.name;
+			events.push_back(event);
+		}
+		iter = m_created.erase(iter);
+	}
+}
+
+void FileWatcher::forgetCreated(const int watch)
+{
+	std::unordered_map<std::string, Created>::iterator iter;
+
+	iter = m_created.begin();
+	while (iter != m_created.end())
+	{
+		if (iter->second.watch == watch)
+		{
+			iter = m_created.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+}
@@ -0,0 +1,175 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _FILE_WATCHER_HPP_
+#define _FILE_WATCHER_HPP_
+
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+// Si no está definido el modo debug, desactivamos los asserts
+#ifndef ENABLE_DEBUG_MODE
+	#define NDEBUG
+#endif
+
+#include <cassert>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <ctime>
+#include <glibmm/ustring.h>
+#include "os_detect.hpp"
+
+
+/**
+ * Vigilancia de los cambios en los ficheros de un conjunto de directorios.
+ *
+ * Informa de los ficheros añadidos, eliminados o modificados en los
+ * directorios vigilados sin necesidad de volver a recorrerlos. En Linux se
+ * utiliza inotify; en el resto de sistemas la vigilancia no está disponible y
+ * no se genera ningún evento.
+ * Los eventos se recogen sin bloquear mediante pollEvents, por lo que puede
+ * consultarse periódicamente desde el bucle principal.
+ * Los ficheros nuevos no se notifican hasta que se terminan de escribir,
+ * salvo los enlaces y ficheros especiales, que se notifican al aparecer.
+ */
+class FileWatcher
+{
+public:
+
+	/**
+	 * Tipos de eventos notificados
+	 */
+	enum EventType
+	{
+		EVENT_ADDED = 0,		/**< Fichero añadido al directorio */
+		EVENT_REMOVED,			/**< Fichero eliminado del directorio */
+		EVENT_CHANGED,			/**< Fichero existente modificado */
+		EVENT_OVERFLOW			/**< Se han perdido eventos, hay que recorrer los directorios */
+	};
+
+	/**
+	 * Evento sobre un fichero de un directorio vigilado
+	 */
+	struct Event
+	{
+		int watch;				/**< Identificador del directorio, -1 en EVENT_OVERFLOW */
+		EventType type;			/**< Tipo del evento */
+		Glib::ustring name;		/**< Nombre del fichero dentro del directorio */
+	};
+
+	/**
+	 * Constructor de la clase
+	 */
+	FileWatcher(void);
+
+	/**
+	 * Destructor de la clase
+	 */
+	~FileWatcher(void);
+
+	/**
+	 * Indica si el sistema permite vigilar directorios
+	 * @return true si la vigilancia está disponible, false en otro caso
+	 */
+	bool isSupported(void) const;
+
+	/**
+	 * Comienza a vigilar un directorio
+	 * @param dir Path del directorio a vigilar
+	 * @return Identificador de la vigilancia o -1 si no se pudo establecer
+	 * @note Los subdirectorios no se vigilan
+	 */
+	int addWatch(const Glib::ustring& dir);
+
+	/**
+	 * Deja de vigilar un directorio
+	 * @param watch Identificador de la vigilancia
+	 */
+	void removeWatch(const int watch);
+
+	/**
+	 * Deja de vigilar todos los directorios
+	 */
+	void clear(void);
+
+	/**
+	 * Obtiene el directorio asociado a una vigilancia
+	 * @param watch Identificador de la vigilancia
+	 * @return Path del directorio o cadena vacía si no existe la vigilancia
+	 */
+	Glib::ustring getDir(const int watch) const;
+
+	/**
+	 * Recoge sin bloquear los eventos producidos desde la última llamada
+	 * @param events Vector donde se añaden los eventos obtenidos
+	 * @return true si se obtuvo algún evento, false en otro caso
+	 */
+	bool pollEvents(std::vector<Event>& events);
+
+private:
+	/**
+	 * Fichero creado pendiente de terminar de escribirse
+	 */
+	struct Created
+	{
+		int watch;				/**< Identificador del directorio */
+		Glib::ustring name;		/**< Nombre del fichero dentro del directorio */
+		std::time_t time;		/**< Momento de su creación */
+	};
+
+	// Evitamos las copias, el descriptor pertenece a una única instancia
+	FileWatcher(const FileWatcher&);
+	FileWatcher& operator=(const FileWatcher&);
+
+	/**
+	 * Indica si un fichero recién creado se va a escribir a continuación
+	 * @param watch Identificador del directorio del fichero
+	 * @param name Nombre del fichero dentro del directorio
+	 * @param exists Devuelve si el fichero existe todavía
+	 * @return true si es un fichero regular nuevo, false si es un enlace, un
+	 * fichero especial o no existe
+	 */
+	bool isPendingWrite(const int watch, const Glib::ustring& name, bool& exists) const;
+
+	/**
+	 * Notifica como añadidos los ficheros creados que llevan demasiado
+	 * tiempo sin terminar de escribirse y los olvida
+	 * @param events Vector donde se añaden los eventos
+	 */
+	void expireCreated(std::vector<Event>& events);
+
+	/**
+	 * Olvida los ficheros creados pendientes de un directorio
+	 * @param watch Identificador del directorio
+	 */
+	void forgetCreated(const int watch);
+
+	int m_fd;											/**< Descriptor de inotify */
+	std::unordered_map<int, Glib::ustring> m_watches;	/**< Directorios vigilados */
+	std::unordered_map<std::string, Created> m_created;	/**< Ficheros creados pendientes de escritura */
+};
+
+// Inclusión de los métodos inline
+#include "file_watcher.inl"
+
+#endif // _FILE_WATCHER_HPP_
@@ -0,0 +1,260 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "hash_cache.hpp"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glibmm/miscutils.h>
+#include "xml_reader.hpp"
+#include "xml_writer.hpp"
+#include "log.hpp"
+
+HashCache::HashCache(void):
+	m_modified(false),
+	m_hits(0),
+	m_misses(0)
+{
+}
+
+HashCache::~HashCache(void)
+{
+	clear();
+}
+
+bool HashCache::load(const Glib::ustring& file, const Glib::ustring& base_dir)
+{
+	XmlReader xml;
+	XmlNode root;
+	XmlNode::iterator iter;
+	Glib::ustring dir, name, crc;
+	Entry entry;
+
+	assert(!file.empty());
+
+	clear();
+	m_file = file;
+	m_base_dir = base_dir;
+
+	LOG_INFO("HashCache: Loading hash cache from file \"" << m_file << "\"...");
+	if (!xml.open(m_file))
+	{
+		LOG_DEBUG("HashCache: Can't open hash cache file \"" << m_file << "\", starting empty");
+		return false;
+	}
+	root = xml.getRootElement();		// <hashcache>
+	if (root.getName() != "hashcache")
+	{
+		LOG_ERROR("HashCache: Root element \"hashcache\" not found in \"" << m_file << "\"");
+		return false;
+	}
+	// Los paths relativos solo son válidos para el mismo directorio base
+	root.getAttribute("dir", dir);
+	if (dir != m_base_dir)
+	{
+		LOG_INFO("HashCache: Base directory changed, discarding cached hashes");
+		m_modified = true;
+		return false;
+	}
+
+	entry.used = false;
+	for (iter = root.begin(); iter != root.end(); ++iter)
+	{
+		if (iter->getName() != "file")
+		{
+			continue;
+		}
+		name.clear();
+		crc.clear();
+		if (iter->getAttribute("name", name) && iter->getAttribute("crc", crc) &&
+			iter->getAttribute("size", entry.size) &&
+			iter->getAttribute("mtime", entry.mtime) &&
+			iter->getAttribute("inode", entry.inode) && !name.empty())
+		{
+			// Las cachés anteriores no guardan los nanosegundos, lo que
+			// obligará a recalcular sus crc una vez
+			entry.mtime_nsec = -1;
+			iter->getAttribute("mtime_nsec", entry.mtime_nsec);
+			entry.crc = Crc32::fromString(crc);
+			m_entries[name.raw()] = entry;
+		}
+	}
+	xml.close();
+	LOG_INFO("HashCache: Loaded " << m_entries.size() << " cached hashes");
+	return true;
+}
+
+bool HashCache::save(const bool prune)
+{
+	XmlWriter xml;
+	std::unordered_map<std::string, Entry>::iterator iter;
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_file.empty())
+	{
+		return false;
+	}
+	// Descartamos los ficheros que ya no se encuentran en el directorio
+	if (prune)
+	{
+		iter = m_entries.begin();
+		while (iter != m_entries.end())
+		{
+			if (!iter->second.used)
+			{
+				iter = m_entries.erase(iter);
+				m_modified = true;
+			}
+			else
+			{
+				++iter;
+			}
+		}
+	}
+	if (!m_modified)
+	{
+		return true;
+	}
+
+	LOG_INFO("HashCache: Saving hash cache file \"" << m_file << "\"...");
+	if (!xml.open(m_file))
+	{
+		LOG_ERROR("HashCache: Can't open hash cache file \""<< m_file << "\" for writing");
+		return false;
+	}
+	xml.startElement("hashcache");
+	xml.writeAttribute("dir", m_base_dir);
+	for (iter = m_entries.begin(); iter != m_entries.end(); ++iter)
+	{
+		xml.startElement("file");
+		xml.writeAttribute("name", iter->first);
+		xml.writeAttribute("size", iter->second.size);
+		xml.writeAttribute("mtime", iter->second.mtime);
+		xml.writeAttribute("mtime_nsec", iter->second.mtime_nsec);
+		xml.writeAttribute("inode", iter->second.inode);
+		xml.writeAttribute("crc", Crc32::toString(iter->second.crc));
+		xml.endElement();
+	}
+	xml.endElement();
+	xml.close();
+	m_modified = false;
+	return true;
+}
+
+void HashCache::resetUsed(void)
+{
+	std::unordered_map<std::string, Entry>::iterator iter;
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (iter = m_entries.begin(); iter != m_entries.end(); ++iter)
+	{
+		iter->second.used = false;
+	}
+}
+
+void HashCache::clear(void)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_entries.clear();
+	m_file.clear();
+	m_base_dir.clear();
+	m_modified = false;
+	m_hits = 0;
+	m_misses = 0;
+}
+
+bool HashCache::getCrc32(const Glib::ustring& file, Crc32::Crc& crc)
+{
+	std::unordered_map<std::string, Entry>::iterator iter;
+	std::string key;
+	Entry entry;
+
+	if (!getFileInfo(file, entry))
+	{
+		return false;
+	}
+	key = getKey(file);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		iter = m_entries.find(key);
+		if ((iter != m_entries.end()) && (iter->second.size == entry.size) &&
+			(iter->second.mtime == entry.mtime) && (iter->second.mtime_nsec == entry.mtime_nsec) &&
+			(iter->second.inode == entry.inode))
+		{
+			iter->second.used = true;
+			crc = iter->second.crc;
+			++m_hits;
+			return true;
+		}
+	}
+	// El cálculo se realiza fuera del bloqueo para no detener al resto de hilos
+	entry.crc = Crc32::getCrc32(file);
+	entry.used = true;
+	crc = entry.crc;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_entries[key] = entry;
+		m_modified = true;
+		++m_misses;
+	}
+	return true;
+}
+
+bool HashCache::getFileInfo(const Glib::ustring& file, Entry& entry)
+{
+	struct stat info;
+
+	if ((stat(file.c_str(), &info) != 0) || !S_ISREG(info.st_mode))
+	{
+		return false;
+	}
+	entry.size = info.st_size;
+	entry.mtime = info.st_mtime;
+	// Con sólo segundos, un fichero reescrito en el mismo segundo y con el
+	// mismo tamaño devolvería el crc anterior
+#if defined(OS_MACOSX)
+	entry.mtime_nsec = info.st_mtimespec.tv_nsec;
+#elif defined(OS_POSIX)
+	entry.mtime_nsec = info.st_mtim.tv_nsec;
+#else
+	entry.mtime_nsec = 0;
+#endif
+	entry.inode = info.st_ino;
+	return true;
+}
+
+std::string HashCache::getKey(const Glib::ustring& file) const
+{
+	std::string::size_type size;
+
+	// Eliminamos el directorio base y el separador que le sigue
+	size = m_base_dir.bytes();
+	if ((size > 0) && (file.bytes() > size) && (file.raw().compare(0, size, m_base_dir.raw()) == 0) &&
+		(G_IS_DIR_SEPARATOR(file.raw()[size]) || G_IS_DIR_SEPARATOR(file.raw()[size - 1])))
+	{
+		while ((size < file.bytes()) && G_IS_DIR_SEPARATOR(file.raw()[size]))
+		{
+			++size;
+		}
+		return file.raw().substr(size);
+	}
+	return file.raw();
+}
@@ -0,0 +1,182 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _HASH_CACHE_HPP_
+#define _HASH_CACHE_HPP_
+
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+// Si no está definido el modo debug, desactivamos los asserts
+#ifndef ENABLE_DEBUG_MODE
+	#define NDEBUG
+#endif
+
+#include <cassert>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <glibmm/ustring.h>
+#include "crc32.hpp"
+
+
+/**
+ * Caché persistente de los crc32 de los ficheros de un directorio.
+ *
+ * Cada fichero se identifica por su path relativo al directorio base junto a
+ * su tamaño, fecha de modificación (con nanosegundos si el sistema los
+ * proporciona) e inodo. Mientras estos datos no cambien se
+ * reutiliza el crc almacenado sin volver a leer el fichero, por lo que solo
+ * es necesario calcular el crc de los ficheros nuevos o modificados.
+ * La consulta de la caché es segura desde varios hilos a la vez.
+ */
+class HashCache
+{
+public:
+	/**
+	 * Constructor de la clase
+	 */
+	HashCache(void);
+
+	/**
+	 * Destructor de la clase
+	 */
+	~HashCache(void);
+
+	/**
+	 * Carga la caché desde un fichero
+	 * @param file Fichero donde se almacena la caché
+	 * @param base_dir Directorio al que son relativos los ficheros de la caché
+	 * @return true si se pudo cargar la caché, false en otro caso
+	 * @note Si el fichero no existe o pertenece a otro directorio base la caché
+	 * comienza vacía, pero se guardará igualmente en el fichero indicado
+	 */
+	bool load(const Glib::ustring& file, const Glib::ustring& base_dir);
+
+	/**
+	 * Guarda la caché en su fichero si ha sido modificada
+	 * @param prune Indica si se descartan los ficheros no consultados desde
+	 * la carga de la caché o la última llamada a resetUsed
+	 * @return true si se pudo guardar o no era necesario, false en otro caso
+	 */
+	bool save(const bool prune = false);
+
+	/**
+	 * Marca todos los ficheros como no consultados
+	 * @note Debe llamarse antes de consultar de nuevo todos los ficheros del
+	 * directorio, para que save pueda descartar los que ya no existen
+	 */
+	void resetUsed(void);
+
+	/**
+	 * Descarta todos los datos de la caché
+	 */
+	void clear(void);
+
+	/**
+	 * Obtiene el crc32 de un fichero, calculándolo solo si no está en la caché
+	 * o el fichero ha cambiado
+	 * @param file Path al fichero del que obtener su crc
+	 * @param crc Lugar de retorno para el crc obtenido
+	 * @return true si se pudo obtener el crc, false si el fichero no existe
+	 */
+	bool getCrc32(const Glib::ustring& file, Crc32::Crc& crc);
+
+	/**
+	 * Obtiene el fichero donde se almacena la caché
+	 * @return Path del fichero de la caché o cadena vacía si no se ha cargado
+	 */
+	const Glib::ustring& getFile(void) const;
+
+	/**
+	 * Obtiene el directorio al que son relativos los ficheros de la caché
+	 * @return Path del directorio base
+	 */
+	const Glib::ustring& getBaseDir(void) const;
+
+	/**
+	 * Obtiene el número de ficheros almacenados en la caché
+	 * @return Número de ficheros de la caché
+	 */
+	unsigned int getSize(void);
+
+	/**
+	 * Obtiene el número de consultas resueltas sin leer el fichero
+	 * @return Número de aciertos de la caché
+	 */
+	unsigned int getHits(void) const;
+
+	/**
+	 * Obtiene el número de consultas que necesitaron calcular el crc
+	 * @return Número de fallos de la caché
+	 */
+	unsigned int getMisses(void) const;
+
+private:
+
+	/**
+	 * Datos almacenados de cada fichero
+	 */
+	struct Entry
+	{
+		unsigned long long size;	/**< Tamaño del fichero */
+		long long mtime;			/**< Fecha de modificación del fichero */
+		long long mtime_nsec;		/**< Nanosegundos de la fecha de modificación */
+		unsigned long long inode;	/**< Inodo del fichero */
+		Crc32::Crc crc;				/**< Crc32 del fichero */
+		bool used;					/**< Indica si se ha consultado desde la carga */
+	};
+
+	/**
+	 * Obtiene del sistema de ficheros los datos que identifican un fichero
+	 * @param file Path al fichero
+	 * @param entry Lugar de retorno para el tamaño, fecha e inodo del fichero
+	 * @note Si el sistema no proporciona los nanosegundos de la fecha se
+	 * devuelven a 0
+	 * @return true si se pudo acceder al fichero, false en otro caso
+	 */
+	static bool getFileInfo(const Glib::ustring& file, Entry& entry);
+
+	/**
+	 * Obtiene la clave de un fichero dentro de la caché
+	 * @param file Path al fichero
+	 * @return Path del fichero relativo al directorio base
+	 */
+	std::string getKey(const Glib::ustring& file) const;
+
+	Glib::ustring m_file;			/**< Fichero donde se almacena la caché */
+	Glib::ustring m_base_dir;		/**< Directorio base de los ficheros */
+	std::unordered_map<std::string, Entry> m_entries;	/**< Ficheros de la caché */
+	std::mutex m_mutex;				/**< Protección de los datos de la caché */
+	bool m_modified;				/**< Indica si la caché ha cambiado desde su carga */
+	unsigned int m_hits;			/**< Consultas resueltas por la caché */
+	unsigned int m_misses;			/**< Consultas que calcularon el crc */
+
+	// Evitamos las copias, la caché pertenece a una única instancia
+	HashCache(const HashCache&);
+	HashCache& operator=(const HashCache&);
+};
+
+// Inclusión de los métodos inline
+#include "hash_cache.inl"
+
+#endif // _HASH_CACHE_HPP_
@@ -0,0 +1,207 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "mapped_file.hpp"
+#include <cstring>
+#ifdef OS_POSIX
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <climits>
+#else
+	#include <fstream>
+#endif
+
+
+MappedFile::MappedFile(void):
+	m_data(NULL),
+	m_size(0)
+{
+}
+
+MappedFile::MappedFile(const Glib::ustring& file):
+	m_data(NULL),
+	m_size(0)
+{
+	open(file);
+}
+
+MappedFile::~MappedFile(void)
+{
+	close();
+}
+
+#ifdef OS_POSIX
+
+bool MappedFile::open(const Glib::ustring& file)
+{
+	int fd;
+	struct stat file_stat;
+	void* data;
+
+	assert(!file.empty());
+
+	close();
+
+	fd = ::open(file.c_str(), O_RDONLY);
+	if (fd == -1)
+	{
+		return false;
+	}
+	// Necesitamos el tamaño real del fichero para proyectarlo completo. Los
+	// ficheros que no caben en un unsigned int no se pueden proyectar
+	if ((fstat(fd, &file_stat) == -1) || (file_stat.st_size == 0) ||
+		(static_cast<unsigned long long>(file_stat.st_size) > UINT_MAX))
+	{
+		::close(fd);
+		return false;
+	}
+	data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// Una vez proyectado el descriptor ya no es necesario
+	::close(fd);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+	// Los consumidores recorren los datos de principio a fin, lo indicamos para
+	// que el sistema adelante la lectura de páginas
+	madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+
+	m_data = static_cast<char*>(data);
+	m_size = file_stat.st_size;
+	return true;
+}
+
+bool MappedFile::allocate(const unsigned int size)
+{
+	void* data;
+
+	assert(size);
+
+	close();
+
+	data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+	m_data = static_cast<char*>(data);
+	m_size = size;
+	return true;
+}
+
+bool MappedFile::resize(const unsigned int size)
+{
+	void* data;
+
+	assert(m_data);
+	assert(size);
+
+	data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+	std::memcpy(data, m_data, (size < m_size) ? size : m_size);
+	munmap(m_data, m_size);
+	m_data = static_cast<char*>(data);
+	m_size = size;
+	return true;
+}
+
+void MappedFile::close(void)
+{
+	if (m_data)
+	{
+		munmap(m_data, m_size);
+		m_data = NULL;
+		m_size = 0;
+	}
+}
+
+#else
+
+bool MappedFile::open(const Glib::ustring& file)
+{
+	std::ifstream file_stream;
+	unsigned int size;
+
+	assert(!file.empty());
+
+	close();
+
+	file_stream.open(file.c_str(), std::ios::in | std::ios::binary);
+	if (!file_stream.good())
+	{
+		return false;
+	}
+	// Obtenemos el tamaño del fichero
+	file_stream.seekg(0, std::ios::end);
+	size = file_stream.tellg();
+	file_stream.seekg(0, std::ios::beg);
+	if (size == 0)
+	{
+		file_stream.close();
+		return false;
+	}
+	// Sin soporte para proyecciones cargamos el contenido completo
+	m_data = new char[size];
+	file_stream.read(m_data, size);
+	file_stream.close();
+	m_size = size;
+	return true;
+}
+
+bool MappedFile::allocate(const unsigned int size)
+{
+	assert(size);
+
+	close();
+
+	m_data = new char[size];
+	m_size = size;
+	return true;
+}
+
+bool MappedFile::resize(const unsigned int size)
+{
+	char* data;
+
+	assert(m_data);
+	assert(size);
+
+	data = new char[size];
+	std::memcpy(data, m_data, (size < m_size) ? size : m_size);
+	delete[] m_data;
+	m_data = data;
+	m_size = size;
+	return true;
+}
+
+void MappedFile::close(void)
+{
+	delete[] m_data;
+	m_data = NULL;
+	m_size = 0;
+}
+
+#endif
@@ -0,0 +1,136 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _MAPPED_FILE_HPP_
+#define _MAPPED_FILE_HPP_
+
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+// Si no está definido el modo debug, desactivamos los asserts
+#ifndef ENABLE_DEBUG_MODE
+	#define NDEBUG
+#endif
+
+#include <cassert>
+#include <glibmm/ustring.h>
+#include "os_detect.hpp"
+
+
+/**
+ * Acceso de solo lectura al contenido completo de un fichero en memoria.
+ *
+ * En sistemas posix el fichero se proyecta en memoria mediante mmap, de forma
+ * que su contenido no se copia y el sistema lo va cargando bajo demanda
+ * conforme se lee. En el resto de sistemas el fichero se carga completo en un
+ * buffer interno.
+ * Permite que varios consumidores trabajen sobre los mismos datos sin
+ * necesidad de realizar copias intermedias.
+ * También permite reservar una zona de memoria anónima del mismo tipo, útil
+ * para volcar en ella datos generados como los de un fichero descomprimido.
+ */
+class MappedFile
+{
+public:
+	/**
+	 * Constructor básico de la clase
+	 */
+	MappedFile(void);
+
+	/**
+	 * Constructor con apertura directa del fichero
+	 * @param file Path del fichero a proyectar
+	 */
+	MappedFile(const Glib::ustring& file);
+
+	/**
+	 * Destructor de la clase
+	 */
+	~MappedFile(void);
+
+	/**
+	 * Proyecta en memoria el contenido de un fichero
+	 * @param file Path del fichero a proyectar
+	 * @return true si se pudo realizar la operación, false en otro caso
+	 * @note Los ficheros vacíos no se pueden proyectar
+	 */
+	bool open(const Glib::ustring& file);
+
+	/**
+	 * Reserva una zona de memoria anónima de escritura para ser rellenada
+	 * @param size Tamaño en bytes de la zona a reservar
+	 * @return true si se pudo realizar la operación, false en otro caso
+	 */
+	bool allocate(const unsigned int size);
+
+	/**
+	 * Cambia el tamaño de una zona reservada mediante allocate, conservando
+	 * su contenido hasta el menor de ambos tamaños
+	 * @param size Nuevo tamaño en bytes de la zona
+	 * @return true si se pudo realizar la operación, false en otro caso, en
+	 * cuyo caso la zona anterior se mantiene intacta
+	 */
+	bool resize(const unsigned int size);
+
+	/**
+	 * Libera la proyección del fichero
+	 */
+	void close(void);
+
+	/**
+	 * Indica si hay un fichero proyectado
+	 * @return true si hay un fichero proyectado, false en otro caso
+	 */
+	bool isOpen(void) const;
+
+	/**
+	 * Obtiene el comienzo de los datos del fichero proyectado
+	 * @return Puntero al comienzo de los datos o null si no hay fichero
+	 */
+	const char* getData(void) const;
+
+	/**
+	 * Obtiene el comienzo de los datos con permiso de escritura
+	 * @return Puntero al comienzo de los datos o null si no hay fichero
+	 * @note Solo debe escribirse en zonas creadas mediante allocate
+	 */
+	char* getBuffer(void);
+
+	/**
+	 * Obtiene el tamaño de los datos del fichero proyectado
+	 * @return Tamaño en bytes de los datos
+	 */
+	unsigned int getSize(void) const;
+
+private:
+	// Evitamos las copias, los datos pertenecen a una única instancia
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	char* m_data;			/**< Comienzo de los datos del fichero */
+	unsigned int m_size;	/**< Tamaño de los datos del fichero */
+};
+
+// Inclusión de los métodos inline
+#include "mapped_file.inl"
+
+#endif // _MAPPED_FILE_HPP_
@@ -0,0 +1,136 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(const unsigned int threads):
+	m_active(0),
+	m_stop(false)
+{
+	unsigned int i, count;
+
+	count = threads;
+	if (count == 0)
+	{
+		count = std::thread::hardware_concurrency();
+		// El sistema puede no ser capaz de indicarnos los núcleos
+		if (count == 0)
+		{
+			count = 2;
+		}
+	}
+	m_threads.reserve(count);
+	for (i = 0; i < count; ++i)
+	{
+		m_threads.push_back(std::thread(&ThreadPool::run, this));
+	}
+}
+
+ThreadPool::~ThreadPool(void)
+{
+	std::vector<std::thread>::iterator iter;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.clear();
+		m_stop = true;
+	}
+	m_task_condition.notify_all();
+	for (iter = m_threads.begin(); iter != m_threads.end(); ++iter)
+	{
+		iter->join();
+	}
+}
+
+void ThreadPool::addTask(const Task& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(task);
+	}
+	m_task_condition.notify_one();
+}
+
+void ThreadPool::wait(void)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (!m_tasks.empty() || (m_active > 0))
+	{
+		m_idle_condition.wait(lock);
+	}
+}
+
+void ThreadPool::clear(void)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_tasks.clear();
+	if (m_active == 0)
+	{
+		m_idle_condition.notify_all();
+	}
+}
+
+bool ThreadPool::isIdle(void)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return (m_tasks.empty() && (m_active == 0));
+}
+
+unsigned int ThreadPool::getThreadCount(void) const
+{
+	return m_threads.size();
+}
+
+void ThreadPool::run(void)
+{
+	Task task;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (m_tasks.empty() && !m_stop)
+			{
+				m_task_condition.wait(lock);
+			}
+			if (m_stop)
+			{
+				return;
+			}
+			task = m_tasks.front();
+			m_tasks.pop_front();
+			++m_active;
+		}
+		// Ejecutamos la tarea fuera de la zona protegida
+		task();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			--m_active;
+			if (m_tasks.empty() && (m_active == 0))
+			{
+				m_idle_condition.notify_all();
+			}
+		}
+	}
+}
@@ -0,0 +1,113 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _THREAD_POOL_HPP_
+#define _THREAD_POOL_HPP_
+
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+// Si no está definido el modo debug, desactivamos los asserts
+#ifndef ENABLE_DEBUG_MODE
+	#define NDEBUG
+#endif
+
+#include <cassert>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+/**
+ * Conjunto de hilos de trabajo para ejecutar tareas en segundo plano.
+ *
+ * Las tareas se encolan y son ejecutadas por el primer hilo libre en el mismo
+ * orden en que se agregaron. Permite esperar a que se completen todas las
+ * tareas pendientes o descartarlas sin ejecutarlas.
+ */
+class ThreadPool
+{
+public:
+	/** Tipo para las tareas ejecutables por los hilos */
+	typedef std::function<void (void)> Task;
+
+	/**
+	 * Constructor parametrizado
+	 * @param threads Número de hilos de trabajo a crear. Si es 0 se crea uno
+	 * por cada núcleo disponible en el sistema
+	 */
+	ThreadPool(const unsigned int threads = 0);
+
+	/**
+	 * Destructor de la clase
+	 * @note Descarta las tareas pendientes y espera a que terminen las que se
+	 * están ejecutando
+	 */
+	~ThreadPool(void);
+
+	/**
+	 * Agrega una nueva tarea a la cola de tareas
+	 * @param task Tarea a ejecutar
+	 */
+	void addTask(const Task& task);
+
+	/**
+	 * Bloquea hasta que se hayan ejecutado todas las tareas pendientes
+	 */
+	void wait(void);
+
+	/**
+	 * Descarta las tareas pendientes que aún no han comenzado a ejecutarse
+	 */
+	void clear(void);
+
+	/**
+	 * Indica si no hay tareas pendientes ni en ejecución
+	 * @return true si todos los hilos están libres, false en otro caso
+	 */
+	bool isIdle(void);
+
+	/**
+	 * Obtiene el número de hilos de trabajo
+	 * @return Número de hilos de trabajo
+	 */
+	unsigned int getThreadCount(void) const;
+
+private:
+	/**
+	 * Bucle principal de cada hilo de trabajo
+	 */
+	void run(void);
+
+	std::vector<std::thread> m_threads;			/**< Hilos de trabajo */
+	std::deque<Task> m_tasks;					/**< Cola de tareas pendientes */
+	std::mutex m_mutex;							/**< Protección de la cola y el estado */
+	std::condition_variable m_task_condition;	/**< Aviso de nuevas tareas */
+	std::condition_variable m_idle_condition;	/**< Aviso de hilos libres */
+	unsigned int m_active;						/**< Tareas en ejecución */
+	bool m_stop;								/**< Indica a los hilos que deben terminar */
+};
+
+#endif // _THREAD_POOL_HPP_
@@ -20,14 +20,15 @@
  */
 
 #include "tokenizer.hpp"
-#include <fstream>
 
 Tokenizer::Tokenizer(void):
+	m_begin(NULL),
+	m_end(NULL),
+	m_pos(NULL),
 	m_delimiters(DEFAULT_DELIMITERS),
 	m_last_delimiter('\0'),
 	m_detect_strings(true)
 {
-	m_buff_pos = m_buff.begin();
 }
 
 Tokenizer::~Tokenizer()
@@ -36,105 +37,82 @@ Tokenizer::~Tokenizer()
 
 bool Tokenizer::initFromMemory(const char *buffer, const unsigned int size)
 {
-	// Usamos ustring.assign(InputIterator begin, InputIterator end) en vez de
-	// ustring.assign(const char*, size_type) porque esta segunda versión espera
-	// la longitud del buffer en "caracteres" no en bytes y por lo tanto puede
-	// producir errores/excepciones
-	m_buff.assign(buffer, buffer + size);
-	m_buff_pos = m_buff.begin();
-	m_token.clear();
-	m_last_delimiter = '\0';
+	// Trabajamos directamente sobre el buffer recibido sin copiarlo
+	m_file.close();
+	m_buff.clear();
+	setRange(buffer, buffer + size);
 
 	return true;
 }
 
 bool Tokenizer::initFromFile(const Glib::ustring& file)
 {
-	std::ifstream file_stream;
-	unsigned int size;
-	char* buff = nullptr;
-
 	assert(!file.empty());
 
-	file_stream.open(file.data());
-	if (!file_stream.good())
-	{
-		file_stream.close();
-		return false;
-	}
-	// Obtenemos el tamaño del fichero para redimensionar la cadena
-	file_stream.seekg (0, std::ios::end);
-	size = file_stream.tellg();
-	file_stream.seekg (0, std::ios::beg);
-
-	// Reservamos la memoria necesaria
-	buff = new char[size];
-	if (!buff)
+	m_buff.clear();
+	if (!m_file.open(file))
 	{
-		file_stream.close();
+		setRange(NULL, NULL);
 		return false;
 	}
-
-	// Cargamos el contenido completo del fichero en el buffer
-	file_stream.read(buff, size);
-	file_stream.close();
-	// Inicializamos el string interno
-	initFromMemory(buff, size);
-
-	delete[] buff;
+	setRange(m_file.getData(), m_file.getData() + m_file.getSize());
 
 	return true;
 }
 
 bool Tokenizer::initFromString(const Glib::ustring& str)
 {
+	// La cadena puede ser temporal, por lo que mantenemos una copia propia
+	m_file.close();
 	m_buff = str;
-	m_buff_pos = m_buff.begin();
-	m_token.clear();
-	m_last_delimiter = '\0';
+	setRange(m_buff.data(), m_buff.data() + m_buff.bytes());
 
 	return true;
 }
 
 Glib::ustring Tokenizer::nextToken(void)
 {
+	const char* start;
+
 	m_token.clear();
 
 	if (hasMoreTokens())
 	{
 		// Comprobamos si estamos en una cadena y hay que extraerla
-		if ((*m_buff_pos == '"') && m_detect_strings)
+		if ((*m_pos == '"') && m_detect_strings)
 		{
 			m_token = getString();
 			return m_token;
 		}
-		while ((m_buff_pos != m_buff.end()) && !isDelimiter())
+		start = m_pos;
+		while ((m_pos != m_end) && !isDelimiter())
 		{
-			m_token += *m_buff_pos;
-			++m_buff_pos;
+			nextChar();
 		}
+		// Extraemos el token completo de una sola vez
+		m_token.assign(start, m_pos);
 	}
 	return m_token;
 }
 
 bool Tokenizer::hasMoreTokens(void)
 {
-	m_last_delimiter_string.clear();
+	const char* start = m_pos;
+	const char* last = m_pos;
+
 	// Saltamos delimitadores iniciales y guardamos el último y la cadena
-	while ((m_buff_pos != m_buff.end()) && isDelimiter())
-	{
-		m_last_delimiter = *m_buff_pos;
-		m_last_delimiter_string.push_back(m_last_delimiter);
-		++m_buff_pos;
-	}
-	if (m_buff_pos != m_buff.end())
+	while ((m_pos != m_end) && isDelimiter())
 	{
-		return true;
+		last = m_pos;
+		nextChar();
 	}
-	else
+	if (m_pos != start)
 	{
-		return false;
+		m_last_delimiter = g_utf8_get_char(last);
 	}
+	m_last_delimiter_string.assign(start, m_pos);
+
+	return (m_pos != m_end);
 }
 
 std::vector<Glib::ustring> Tokenizer::split(void)
@@ -151,40 +129,34 @@ std::vector<Glib::ustring> Tokenizer::split(void)
 
 Glib::ustring Tokenizer::getString(void)
 {
+	const char* start;
 	Glib::ustring str;
 
 	// Saltamos las comillas iniciales donde hemos sido llamados
-	++m_buff_pos;
-
-	// Comprobamos caracteres escapados iniciales
-	while (*m_buff_pos == '\\')
-	{
-		str += *m_buff_pos;
-		++m_buff_pos;
-		str += *m_buff_pos;
-		++m_buff_pos;
-	}
+	++m_pos;
+	start = m_pos;
 
-	// Consideramos que la cadena finaliza en " o al final del buffer
-	while ((*m_buff_pos != '"') && (m_buff_pos != m_buff.end()) )
+	// Consideramos que la cadena finaliza en " o al final del buffer. Los
+	// caracteres escapados se mantienen tal cual en la cadena
+	while ((m_pos != m_end) && (*m_pos != '"'))
 	{
-		str += *m_buff_pos;
-		++m_buff_pos;
-		// Caracteres escapados internos
-		while (*m_buff_pos == '\\')
+		if (*m_pos == '\\')
 		{
-			str += *m_buff_pos;
-			++m_buff_pos;
-			str += *m_buff_pos;
-			++m_buff_pos;
+			++m_pos;
+			if (m_pos == m_end)
+			{
+				break;
+			}
 		}
+		nextChar();
 	}
+	str.assign(start, m_pos);
 
 	// Si paramos en unas comillas, pasamos a la siguiente posición para evitar
 	// que se vuelva a interpretar la posición como cadena
-	if (*m_buff_pos == '"')
+	if (m_pos != m_end)
 	{
-		++m_buff_pos;
+		++m_pos;
 	}
 	return str;
 }
@@ -34,6 +34,7 @@
 #include <cassert>
 #include <vector>
 #include <glibmm/ustring.h>
+#include "mapped_file.hpp"
 
 
 // Delimitadores por defecto: Espacio, Salto de línea, Retorno de carro,
@@ -51,6 +52,8 @@ static const Glib::ustring DEFAULT_DELIMITERS = " \n\r\t\v\f";
  * página.
  * Incluye soporte para detectar cadenas de texto entrecomilladas activado por
  * defecto.
+ * El tokenizador trabaja directamente sobre los datos de origen sin copiarlos,
+ * por lo que los tokens se extraen como rangos de bytes del buffer.
  */
 class Tokenizer
 {
@@ -77,6 +80,8 @@ public:
 	 * @param buffer Puntero al buffer donde se almacenan los datos
 	 * @param size Tamaño total del buffer
 	 * @return true si se realizó la carga correctamente
+	 * @note El buffer no se copia, por lo que debe permanecer válido mientras
+	 * se use el tokenizador
 	 */
 	bool initFromMemory(const char *buffer, const unsigned int size);
 
@@ -84,6 +89,7 @@ public:
 	 * Inicializa el tokenizador sobre un fichero determinado
 	 * @param file nombre del fichero con el contenido a tokenizar
 	 * @return true si se realizó la carga correctamente
+	 * @note El fichero se proyecta en memoria en lugar de cargarse completo
 	 */
 	bool initFromFile(const Glib::ustring& file);
 
@@ -157,6 +163,19 @@ private:
 	 */
 	bool isDelimiter(void);
 
+	/**
+	 * Avanza la posición de lectura del buffer hasta el siguiente carácter
+	 * UTF-8 sin sobrepasar el final del buffer
+	 */
+	void nextChar(void);
+
+	/**
+	 * Establece el rango de datos sobre el que trabaja el tokenizador
+	 * @param begin Comienzo de los datos
+	 * @param end Final de los datos
+	 */
+	void setRange(const char* begin, const char* end);
+
 	/**
 	 * Obtiene una cadena del buffer del tokenizador
 	 * @return cadena leída
@@ -165,8 +184,11 @@ private:
 	 */
 	Glib::ustring getString(void);
 
-	Glib::ustring m_buff;						/**< Buffer del tokenizador */
-	Glib::ustring::const_iterator m_buff_pos;	/**< Posición de lectura del buffer */
+	Glib::ustring m_buff;						/**< Buffer propio para cadenas */
+	MappedFile m_file;							/**< Fichero proyectado en memoria */
+	const char* m_begin;						/**< Comienzo de los datos */
+	const char* m_end;							/**< Final de los datos */
+	const char* m_pos;							/**< Posición de lectura de los datos */
 	Glib::ustring m_delimiters;					/**< Lista de delimitadores */
 	Glib::ustring m_token;						/**< Token leído */
 	Glib::ustring::value_type m_last_delimiter;	/**< Ultimo delimitador encontrado */
@@ -44,14 +44,43 @@ inline Glib::ustring Tokenizer::lastDelimiterString(void)
 
 inline void Tokenizer::reset(void)
 {
-	m_buff_pos = m_buff.begin();
+	m_pos = m_begin;
 	m_token.clear();
 	m_last_delimiter = '\0';
 }
 
 inline bool Tokenizer::isDelimiter(void)
 {
-	return(m_delimiters.find(*m_buff_pos) != std::string::npos);
+	// Los caracteres ASCII se comprueban directamente sin decodificar
+	if (static_cast<unsigned char>(*m_pos) < 0x80)
+	{
+		return (m_delimiters.find(static_cast<gunichar>(*m_pos)) != std::string::npos);
+	}
+	return (m_delimiters.find(g_utf8_get_char(m_pos)) != std::string::npos);
+}
+
+inline void Tokenizer::nextChar(void)
+{
+	if (static_cast<unsigned char>(*m_pos) < 0x80)
+	{
+		++m_pos;
+	}
+	else
+	{
+		m_pos = g_utf8_next_char(m_pos);
+		// Evitamos salirnos del buffer con secuencias UTF-8 truncadas
+		if (m_pos > m_end)
+		{
+			m_pos = m_end;
+		}
+	}
+}
+
+inline void Tokenizer::setRange(const char* begin, const char* end)
+{
+	m_begin = begin;
+	m_end = end;
+	reset();
 }
 
 #endif // _TOKENIZER_INL_
@@ -25,6 +25,7 @@
 #include <cstdio>
 #include <fstream>
 #include "log.hpp"
+#include "dir_scanner.hpp"
 //#include <glibmm/fileutils.h>
 //#include <glibmm.h>
 //#include <glib/gstdio.h>
@@ -113,137 +114,100 @@ bool copyFile(const Glib::ustring&orig, const Glib::ustring& dest)
 
 bool getFiles(const Glib::ustring& path, std::vector<Glib::ustring>& files)
 {
-	Glib::Dir::iterator dir_iter;
-	Glib::ustring file;
+	std::vector<DirScanner::Entry> entries;
+	std::vector<DirScanner::Entry>::iterator iter;
 
 	assert(!path.empty());
 
-	try
+	files.clear();
+	// El tipo de cada entrada se obtiene en la propia lectura del directorio
+	if (!DirScanner::readDir(path, entries))
 	{
-		// Abrimos el directorio y vamos obteniendo los ficheros
-		Glib::Dir dir(path);
-		files.clear();
-		for (dir_iter = dir.begin(); dir_iter != dir.end(); dir_iter++)
-		{
-			file = Glib::build_filename(path, (*dir_iter));
-			if (Glib::file_test(file.c_str(), Glib::FILE_TEST_IS_REGULAR))
-			{
-				files.push_back((*dir_iter));
-			}
-		}
-		return true;
+		LOG_ERROR("Utils: Reading files (" << path << ")");
+		return false;
 	}
-	catch (Glib::Error& e)
+	for (iter = entries.begin(); iter != entries.end(); ++iter)
 	{
-		LOG_ERROR("Utils: Reading files (" << e.what().c_str() << ")");
+		if (iter->type == DirScanner::ENTRY_FILE)
+		{
+			files.push_back(iter->name);
+		}
 	}
-	return false;
+	return true;
 }
 
 bool getDirectories(const Glib::ustring& path, std::vector<Glib::ustring>& directories)
 {
-	Glib::Dir::iterator dir_iter;
-	Glib::ustring file;
+	std::vector<DirScanner::Entry> entries;
+	std::vector<DirScanner::Entry>::iterator iter;
 
 	assert(!path.empty());
 
-	try
+	directories.clear();
+	if (!DirScanner::readDir(path, entries))
 	{
-		// Abrimos el directorio y vamos obteniendo los directorios
-		Glib::Dir dir(path);
-		directories.clear();
-		for (dir_iter = dir.begin(); dir_iter != dir.end(); dir_iter++)
-		{
-			file = Glib::build_filename(path, (*dir_iter));
-			if (Glib::file_test(file.c_str(), Glib::FILE_TEST_IS_DIR))
-			{
-				directories.push_back((*dir_iter));
-			}
-		}
-		return true;
+		LOG_ERROR("Utils: Reading files (" << path << ")");
+		return false;
 	}
-	catch (Glib::Error& e)
+	for (iter = entries.begin(); iter != entries.end(); ++iter)
 	{
-		LOG_ERROR("Utils: Reading files (" << e.what().c_str() << ")");
+		if (iter->type == DirScanner::ENTRY_DIR)
+		{
+			directories.push_back(iter->name);
+		}
 	}
-	return false;
+	return true;
 }
 
 bool findFiles(const Glib::ustring& path, std::vector<Glib::ustring>& files, const Glib::ustring& pattern)
 {
-	Glib::Dir::iterator dir_iter;
-	Glib::ustring file;
+	std::vector<DirScanner::Entry> entries;
+	std::vector<DirScanner::Entry>::iterator iter;
 
 	assert(!path.empty());
 
-	try
+	files.clear();
+	if (!DirScanner::readDir(path, entries))
 	{
-		// Abrimos el directorio y vamos obteniendo los directorios
-		Glib::Dir dir(path);
-		files.clear();
-		for (dir_iter = dir.begin(); dir_iter != dir.end(); dir_iter++)
-		{
-			file = Glib::build_filename(path, (*dir_iter));
-			if (Glib::file_test(file.c_str(), Glib::FILE_TEST_IS_REGULAR) && (*dir_iter).find(pattern) == 0)
-			{
-				files.push_back(file);
-			}
-		}
-		return true;
+		LOG_ERROR("Utils: Finding files (" << path << ")");
+		return false;
 	}
-	catch (Glib::Error& e)
+	for (iter = entries.begin(); iter != entries.end(); ++iter)
 	{
-		LOG_ERROR("Utils: Finding files (" << e.what().c_str() << ")");
+		if ((iter->type == DirScanner::ENTRY_FILE) && (iter->name.compare(0, pattern.bytes(), pattern.raw()) == 0))
+		{
+			files.push_back(path.raw() + G_DIR_SEPARATOR_S + iter->name);
+		}
 	}
-	return false;
+	return true;
 }
 
-/**
- * Obtiene todos los ficheros de un directorio que comienzar por pattern de
- * forma recursiva
- * @param path Ruta al directorio donde leer los ficheros
- * @param files Vector donde se guardan las rutas a los ficheros
- * @param pattern Patrón de comienzo para los nombres de los ficheros o ""
- * 		  para cualquier fichero
- * @return True si se pudo realizar la operación, false en otro caso
- * @note El vector p_files no será vaciado en esta función
- */
-bool findFilesRecursiveExt(const Glib::ustring& path, std::vector<Glib::ustring>& files, const Glib::ustring& pattern)
+bool findFilesRecursive(const Glib::ustring& path, std::vector<Glib::ustring>& files, const Glib::ustring& pattern)
 {
-	Glib::Dir::iterator dir_iter;
-	Glib::ustring file;
+	DirScanner scanner;
+	bool ret;
 
-	try
+	assert(!path.empty());
+
+	files.clear();
+	// Los directorios se leen en paralelo y sus ficheros se van agregando
+	ret = scanner.scan(path, [&files, &pattern](const Glib::ustring& dir, const std::vector<DirScanner::Entry>& entries)
 	{
-		Glib::Dir dir(path);
-		for (dir_iter = dir.begin(); dir_iter != dir.end(); dir_iter++)
+		std::vector<DirScanner::Entry>::const_iterator iter;
+
+		for (iter = entries.begin(); iter != entries.end(); ++iter)
 		{
-			file = Glib::build_filename(path, (*dir_iter));
-			if (Glib::file_test(file.c_str(), Glib::FILE_TEST_IS_DIR))
+			if ((iter->type != DirScanner::ENTRY_DIR) && (iter->name.compare(0, pattern.bytes(), pattern.raw()) == 0))
 			{
-				findFilesRecursiveExt(file, files, pattern);
-			}
-			else if((*dir_iter).find(pattern) == 0)
-			{
-				files.push_back(file);
+				files.push_back(dir.raw() + G_DIR_SEPARATOR_S + iter->name);
 			}
 		}
-		return true;
-	}
-	catch (Glib::Error& e)
+	});
+	if (!ret)
 	{
-		LOG_ERROR("Utils: Finding files (" << e.what().c_str() << ")");
+		LOG_ERROR("Utils: Finding files (" << path << ")");
 	}
-	return false;
-}
-
-bool findFilesRecursive(const Glib::ustring& path, std::vector<Glib::ustring>& files, const Glib::ustring& pattern)
-{
-
-	assert(!path.empty());
-
-	files.clear();
-	return findFilesRecursiveExt(path, files, pattern);
+	return ret;
 }
 
 Glib::ustring getRndWord(const int min_chars, const int max_chars)
@@ -106,6 +106,8 @@ bool findFiles(const Glib::ustring& path, std::vector<Glib::ustring>& files, con
  * @param pattern Patrón de comienzo para los nombres de los ficheros o ""
  * 		  para cualquier fichero
  * @return True si se pudo realizar la operación, false en otro caso
+ * @note Los subdirectorios se recorren en paralelo, por lo que el orden de los
+ * ficheros obtenidos no está definido
  */
 bool findFilesRecursive(const Glib::ustring& path, std::vector<Glib::ustring>& files, const Glib::ustring& pattern);
 
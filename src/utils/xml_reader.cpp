@@ -20,6 +20,8 @@
  */
 
 #include "xml_reader.hpp"
+#include <cstring>
+#include <libxml2/libxml/parser.h>
 
 
 XmlNode::XmlNode(void):
@@ -184,9 +186,16 @@ bool XmlReader::open(const Glib::ustring& file)
 
 bool XmlReader::load(const char* buffer, const unsigned int size)
 {
+	MemoryInput input;
+
 	// Liberamos la memoria si fuera necesario
 	close();
-	m_doc = xmlParseMemory(buffer, size);
+	// xmlParseMemory duplica el buffer completo antes de parsearlo, por lo que
+	// usamos un callback de lectura para que libxml lo consuma por bloques
+	input.pos = buffer;
+	input.end = buffer + size;
+	m_doc = xmlReadIO(readMemory, NULL, &input, NULL, NULL,
+		XML_PARSE_COMPACT | XML_PARSE_HUGE);
 	if (m_doc == NULL)
 	{
 		// Anulamos el nodo root
@@ -203,6 +212,21 @@ bool XmlReader::load(const Glib::ustring& str)
 	return(load(str.c_str(), str.bytes()));
 }
 
+int XmlReader::readMemory(void* context, char* buffer, int len)
+{
+	MemoryInput* input = static_cast<MemoryInput*>(context);
+	int size;
+
+	size = input->end - input->pos;
+	if (size > len)
+	{
+		size = len;
+	}
+	std::memcpy(buffer, input->pos, size);
+	input->pos += size;
+	return size;
+}
+
 void XmlReader::close(void)
 {
 	// Anulamos el nodo root
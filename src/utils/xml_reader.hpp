@@ -292,6 +292,8 @@ public:
 	 * @param buffer Puntero al buffer donde se almacenan los datos
 	 * @param size Tamaño total del buffer
 	 * @return true si se pudo realizar la carga sin problemas
+	 * @note El buffer se entrega al parser por bloques sin realizar una copia
+	 * completa del mismo
 	 */
 	bool load(const char* buffer, const unsigned int size);
 
@@ -318,6 +320,25 @@ public:
 	}
 
 private:
+	/**
+	 * Posición de lectura de un buffer de memoria durante su parseo
+	 */
+	struct MemoryInput
+	{
+		const char* pos;	/**< Posición actual de lectura */
+		const char* end;	/**< Final del buffer */
+	};
+
+	/**
+	 * Callback de lectura para libxml que entrega un buffer de memoria por
+	 * bloques
+	 * @param context Entrada de memoria de la que leer
+	 * @param buffer Buffer donde libxml espera los datos
+	 * @param len Número máximo de bytes a leer
+	 * @return Número de bytes leidos
+	 */
+	static int readMemory(void* context, char* buffer, int len);
+
 	xmlDocPtr m_doc;	/**< Documento xml de uso interno */
 	XmlNode m_root;		/**< Elemento root del xml */
 };
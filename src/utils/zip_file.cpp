@@ -0,0 +1,302 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "zip_file.hpp"
+#include <cstring>
+#include <zlib.h>
+
+// Firmas de los distintos bloques de un zip
+#define ZIP_LOCAL_HEADER_SIGNATURE 0x04034b50
+#define ZIP_CENTRAL_HEADER_SIGNATURE 0x02014b50
+#define ZIP_END_HEADER_SIGNATURE 0x06054b50
+// Tamaños fijos de las cabeceras
+#define ZIP_LOCAL_HEADER_SIZE 30
+#define ZIP_CENTRAL_HEADER_SIZE 46
+#define ZIP_END_HEADER_SIZE 22
+// Tamaño máximo del comentario al final del zip
+#define ZIP_MAX_COMMENT_SIZE 0xFFFF
+// Tamaño del buffer para la descompresión por bloques
+#define ZIP_INFLATE_BUFF_SIZE 262144
+
+ZipFile::ZipFile(void):
+	m_data(NULL),
+	m_size(0)
+{
+}
+
+ZipFile::~ZipFile(void)
+{
+	close();
+}
+
+bool ZipFile::open(const Glib::ustring& file)
+{
+	assert(!file.empty());
+
+	close();
+	if (!m_file.open(file))
+	{
+		return false;
+	}
+	m_data = m_file.getData();
+	m_size = m_file.getSize();
+	if (!readCentralDirectory())
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool ZipFile::open(const char* buffer, const unsigned int size)
+{
+	assert(buffer);
+
+	close();
+	m_data = buffer;
+	m_size = size;
+	if (!readCentralDirectory())
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void ZipFile::close(void)
+{
+	m_file.close();
+	m_data = NULL;
+	m_size = 0;
+	m_entries.clear();
+}
+
+bool ZipFile::extract(const Entry& entry, char* buffer) const
+{
+	const char* data;
+	z_stream stream;
+	int ret;
+
+	assert(m_data);
+	assert(buffer);
+
+	data = getEntryData(entry);
+	if (!data)
+	{
+		return false;
+	}
+
+	switch (entry.method)
+	{
+	case METHOD_STORED:
+		if (entry.compressed_size != entry.size)
+		{
+			return false;
+		}
+		std::memcpy(buffer, data, entry.size);
+		return true;
+	case METHOD_DEFLATED:
+		std::memset(&stream, 0, sizeof(stream));
+		// Los datos de un zip son deflate sin cabecera zlib
+		if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+		{
+			return false;
+		}
+		stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+		stream.avail_in = entry.compressed_size;
+		stream.next_out = reinterpret_cast<Bytef*>(buffer);
+		stream.avail_out = entry.size;
+		// Conocemos el tamaño final, por lo que descomprimimos de una vez
+		ret = inflate(&stream, Z_FINISH);
+		inflateEnd(&stream);
+		return ((ret == Z_STREAM_END) && (stream.total_out == entry.size));
+	default:
+		return false;
+	}
+}
+
+bool ZipFile::getCrc32(const Entry& entry, Crc32::Crc& crc) const
+{
+	const char* data;
+	std::vector<char> buffer;
+	z_stream stream;
+	Crc32::Crc value = 0xFFFFFFFF;
+	int ret;
+
+	assert(m_data);
+
+	data = getEntryData(entry);
+	if (!data)
+	{
+		return false;
+	}
+
+	switch (entry.method)
+	{
+	case METHOD_STORED:
+		if (entry.compressed_size != entry.size)
+		{
+			return false;
+		}
+		crc = Crc32::getCrc32(data, entry.size);
+		return true;
+	case METHOD_DEFLATED:
+		std::memset(&stream, 0, sizeof(stream));
+		if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+		{
+			return false;
+		}
+		// Descomprimimos por bloques sobre un buffer fijo, calculando el crc
+		// de cada bloque según se obtiene
+		buffer.resize(ZIP_INFLATE_BUFF_SIZE);
+		stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+		stream.avail_in = entry.compressed_size;
+		do
+		{
+			stream.next_out = reinterpret_cast<Bytef*>(&buffer[0]);
+			stream.avail_out = ZIP_INFLATE_BUFF_SIZE;
+			ret = inflate(&stream, Z_NO_FLUSH);
+			if ((ret != Z_OK) && (ret != Z_STREAM_END))
+			{
+				inflateEnd(&stream);
+				return false;
+			}
+			value = Crc32::getCrc32(&buffer[0], ZIP_INFLATE_BUFF_SIZE - stream.avail_out, value);
+		}
+		while (ret != Z_STREAM_END);
+		inflateEnd(&stream);
+		if (stream.total_out != entry.size)
+		{
+			return false;
+		}
+		crc = Crc32::getCrc32Finalize(value);
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool ZipFile::verify(const Entry& entry) const
+{
+	Crc32::Crc crc;
+
+	return (getCrc32(entry, crc) && (crc == entry.crc));
+}
+
+bool ZipFile::isZip(const char* buffer, const unsigned int size)
+{
+	assert(buffer);
+
+	return ((size >= ZIP_END_HEADER_SIZE) &&
+		((readUint32(buffer) == ZIP_LOCAL_HEADER_SIGNATURE) ||
+		(readUint32(buffer) == ZIP_END_HEADER_SIGNATURE)));
+}
+
+const char* ZipFile::getEntryData(const Entry& entry) const
+{
+	const char* data;
+
+	// La cabecera local puede tener campos extra distintos a los del
+	// directorio central, por lo que calculamos el comienzo de los datos
+	if ((entry.offset + ZIP_LOCAL_HEADER_SIZE > m_size) ||
+		(readUint32(m_data + entry.offset) != ZIP_LOCAL_HEADER_SIGNATURE))
+	{
+		return NULL;
+	}
+	data = m_data + entry.offset + ZIP_LOCAL_HEADER_SIZE +
+		readUint16(m_data + entry.offset + 26) +
+		readUint16(m_data + entry.offset + 28);
+	if (data + entry.compressed_size > m_data + m_size)
+	{
+		return NULL;
+	}
+	return data;
+}
+
+bool ZipFile::readCentralDirectory(void)
+{
+	const char* end_header = NULL;
+	const char* pos;
+	const char* limit;
+	unsigned int count;
+	unsigned int offset;
+	unsigned int name_size;
+	Entry entry;
+
+	if (m_size < ZIP_END_HEADER_SIZE)
+	{
+		return false;
+	}
+	// Buscamos la cabecera final desde el final del fichero, teniendo en
+	// cuenta que puede ir seguida de un comentario
+	pos = m_data + m_size - ZIP_END_HEADER_SIZE;
+	limit = (m_size > ZIP_END_HEADER_SIZE + ZIP_MAX_COMMENT_SIZE) ?
+		pos - ZIP_MAX_COMMENT_SIZE : m_data;
+	for (; pos >= limit; --pos)
+	{
+		if (readUint32(pos) == ZIP_END_HEADER_SIGNATURE)
+		{
+			end_header = pos;
+			break;
+		}
+	}
+	if (!end_header)
+	{
+		return false;
+	}
+	count = readUint16(end_header + 10);
+	offset = readUint32(end_header + 16);
+	if (offset > m_size)
+	{
+		return false;
+	}
+
+	// Recorremos el directorio central
+	m_entries.clear();
+	m_entries.reserve(count);
+	pos = m_data + offset;
+	limit = m_data + m_size;
+	while (count > 0)
+	{
+		if ((pos + ZIP_CENTRAL_HEADER_SIZE > limit) ||
+			(readUint32(pos) != ZIP_CENTRAL_HEADER_SIGNATURE))
+		{
+			return false;
+		}
+		name_size = readUint16(pos + 28);
+		if (pos + ZIP_CENTRAL_HEADER_SIZE + name_size > limit)
+		{
+			return false;
+		}
+		entry.method = readUint16(pos + 10);
+		entry.crc = readUint32(pos + 16);
+		entry.compressed_size = readUint32(pos + 20);
+		entry.size = readUint32(pos + 24);
+		entry.offset = readUint32(pos + 42);
+		entry.name.assign(pos + ZIP_CENTRAL_HEADER_SIZE, pos + ZIP_CENTRAL_HEADER_SIZE + name_size);
+		m_entries.push_back(entry);
+		// Pasamos a la siguiente cabecera saltando nombre, extra y comentario
+		pos += ZIP_CENTRAL_HEADER_SIZE + name_size + readUint16(pos + 30) +
+			readUint16(pos + 32);
+		--count;
+	}
+	return true;
+}
@@ -0,0 +1,191 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _ZIP_FILE_HPP_
+#define _ZIP_FILE_HPP_
+
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+// Si no está definido el modo debug, desactivamos los asserts
+#ifndef ENABLE_DEBUG_MODE
+	#define NDEBUG
+#endif
+
+#include <cassert>
+#include <vector>
+#include <glibmm/ustring.h>
+#include "crc32.hpp"
+#include "mapped_file.hpp"
+
+
+/**
+ * Lector simple de ficheros zip.
+ *
+ * Obtiene el listado de ficheros contenidos en un zip a partir de su
+ * directorio central, sin necesidad de recorrer o descomprimir los datos, y
+ * permite extraer cualquiera de ellos directamente a un buffer de memoria.
+ * Soporta entradas almacenadas sin compresión y comprimidas con deflate. Los
+ * zip en formato zip64 no están soportados.
+ */
+class ZipFile
+{
+public:
+
+	// Métodos de compresión soportados
+	enum Method
+	{
+		METHOD_STORED = 0,
+		METHOD_DEFLATED = 8
+	};
+
+	/**
+	 * Datos de un fichero contenido en el zip
+	 */
+	struct Entry
+	{
+		Glib::ustring name;			/**< Nombre del fichero dentro del zip */
+		Crc32::Crc crc;				/**< Crc32 de los datos descomprimidos */
+		unsigned int method;		/**< Método de compresión de los datos */
+		unsigned int compressed_size;	/**< Tamaño de los datos comprimidos */
+		unsigned int size;			/**< Tamaño de los datos descomprimidos */
+		unsigned int offset;		/**< Posición de la cabecera local */
+	};
+
+	/**
+	 * Constructor básico de la clase
+	 */
+	ZipFile(void);
+
+	/**
+	 * Destructor de la clase
+	 */
+	~ZipFile(void);
+
+	/**
+	 * Abre un fichero zip y lee su directorio central
+	 * @param file Path del fichero zip a abrir
+	 * @return true si se pudo realizar la operación, false en otro caso
+	 */
+	bool open(const Glib::ustring& file);
+
+	/**
+	 * Lee el directorio central de un zip contenido en un buffer de memoria
+	 * @param buffer Puntero al buffer donde se almacenan los datos del zip
+	 * @param size Tamaño total del buffer
+	 * @return true si se pudo realizar la operación, false en otro caso
+	 * @note El buffer no se copia, por lo que debe permanecer válido mientras
+	 * se use el zip
+	 */
+	bool open(const char* buffer, const unsigned int size);
+
+	/**
+	 * Cierra el zip liberando los recursos utilizados
+	 */
+	void close(void);
+
+	/**
+	 * Indica si hay un zip abierto
+	 * @return true si hay un zip abierto, false en otro caso
+	 */
+	bool isOpen(void) const;
+
+	/**
+	 * Obtiene los ficheros contenidos en el zip
+	 * @return Vector con los datos de los ficheros del zip
+	 */
+	const std::vector<Entry>& getEntries(void) const;
+
+	/**
+	 * Extrae un fichero del zip a un buffer de memoria
+	 * @param entry Fichero del zip a extraer
+	 * @param buffer Buffer donde se almacenarán los datos descomprimidos
+	 * @return true si se pudo realizar la operación, false en otro caso
+	 * @note El buffer debe tener al menos el tamaño descomprimido del fichero
+	 */
+	bool extract(const Entry& entry, char* buffer) const;
+
+	/**
+	 * Calcula el crc32 de un fichero del zip descomprimiéndolo por bloques
+	 * @param entry Fichero del zip del que calcular el crc
+	 * @param crc Crc32 calculado
+	 * @return true si se pudo realizar la operación, false en otro caso
+	 * @note No se necesita memoria para el fichero completo, por lo que es
+	 * adecuado para ficheros de cualquier tamaño
+	 */
+	bool getCrc32(const Entry& entry, Crc32::Crc& crc) const;
+
+	/**
+	 * Comprueba que los datos de un fichero del zip coinciden con el crc
+	 * almacenado en el directorio central
+	 * @param entry Fichero del zip a comprobar
+	 * @return true si los datos son correctos, false en otro caso
+	 */
+	bool verify(const Entry& entry) const;
+
+	/**
+	 * Comprueba si un buffer de memoria comienza con la firma de un zip
+	 * @param buffer Puntero al buffer donde se almacenan los datos
+	 * @param size Tamaño total del buffer
+	 * @return true si el buffer parece un zip, false en otro caso
+	 */
+	static bool isZip(const char* buffer, const unsigned int size);
+
+	/**
+	 * Lee un entero de 16 bits almacenado en formato little endian
+	 * @param data Puntero a los datos
+	 * @return Entero leído
+	 */
+	static unsigned int readUint16(const char* data);
+
+	/**
+	 * Lee un entero de 32 bits almacenado en formato little endian
+	 * @param data Puntero a los datos
+	 * @return Entero leído
+	 */
+	static unsigned int readUint32(const char* data);
+
+private:
+
+	/**
+	 * Lee el directorio central del zip y rellena el listado de ficheros
+	 * @return true si se pudo realizar la operación, false en otro caso
+	 */
+	bool readCentralDirectory(void);
+
+	/**
+	 * Localiza los datos comprimidos de un fichero del zip
+	 * @param entry Fichero del zip a localizar
+	 * @return Puntero a los datos comprimidos o NULL si no son válidos
+	 */
+	const char* getEntryData(const Entry& entry) const;
+
+	MappedFile m_file;				/**< Fichero zip proyectado en memoria */
+	const char* m_data;				/**< Comienzo de los datos del zip */
+	unsigned int m_size;			/**< Tamaño de los datos del zip */
+	std::vector<Entry> m_entries;	/**< Ficheros contenidos en el zip */
+};
+
+// Inclusión de los métodos inline
+#include "zip_file.inl"
+
+#endif // _ZIP_FILE_HPP_
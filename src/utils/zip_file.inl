@@ -0,0 +1,50 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * bmonkey
+ * Copyright (C) 2014 Juan Ángel Moreno Fernández
+ *
+ * bmonkey is free software.
+ *
+ * You can redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * bmonkey is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with bmonkey.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _ZIP_FILE_INL_
+#define _ZIP_FILE_INL_
+
+inline bool ZipFile::isOpen(void) const
+{
+	return (m_data != NULL);
+}
+
+inline const std::vector<ZipFile::Entry>& ZipFile::getEntries(void) const
+{
+	return m_entries;
+}
+
+inline unsigned int ZipFile::readUint16(const char* data)
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+	return (bytes[0] | (bytes[1] << 8));
+}
+
+inline unsigned int ZipFile::readUint32(const char* data)
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+	return (bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) |
+		(static_cast<unsigned int>(bytes[3]) << 24));
+}
+
+#endif // _ZIP_FILE_INL_